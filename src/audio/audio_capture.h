@@ -1,10 +1,16 @@
 #pragma once
 
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <functional>
+#include <string>
+#include <vector>
+#include <stdexcept>
 #include <common/model_config.h>
 #include <sherpa-onnx/c-api/c-api.h>
 #include <translator/translator.h>
+#include <pipeline/recognition_pipeline.h>
 
 namespace audio {
 
@@ -15,26 +21,55 @@ public:
     // Initialize audio capture
     virtual bool initialize() = 0;
 
-    // Start recording from a specific application
+    // Start recording from a specific application. Implementations that support
+    // several sources can be called once per application.
     virtual bool start_recording_application(unsigned int pid) = 0;
 
+    // Stop recording a single application. Platforms recording a single
+    // application stop everything.
+    virtual void stop_recording_application(unsigned int /*pid*/) { stop_recording(); }
+
     // Stop recording
     virtual void stop_recording() = 0;
 
     // List available applications
     virtual void list_applications() = 0;
 
+    // Applications that can be recorded, by index, with a descriptive name
+    virtual std::map<uint32_t, std::string> get_applications() { return {}; }
+
+    // Indexes of the applications currently being recorded
+    virtual std::vector<uint32_t> recording_applications() const { return {}; }
+
     // Factory method to create audio capture instance
     static std::unique_ptr<IAudioCapture> CreateAudioCapture();
 
     // set model recognizer
     virtual void set_model_recognizer(const SherpaOnnxOfflineRecognizer* recognizer) = 0;
 
+    // set streaming recognizer; replaces set_model_recognizer and set_model_vad,
+    // since the recognizer finds utterance endpoints itself
+    virtual void set_model_online_recognizer(const SherpaOnnxOnlineRecognizer* /*recognizer*/,
+                                             const common::StreamingConfig& /*config*/) {
+        throw std::runtime_error("Streaming recognition is not supported on this platform");
+    }
+
     // set model vad
     virtual void set_model_vad(SherpaOnnxVoiceActivityDetector* vad, const int window_size) = 0;
 
     // set translate
     virtual void set_translate(const translator::ITranslator* translate) = 0;
+
+    // set model config for pipeline tuning and per-source VAD creation; must be
+    // called before set_model_vad. Platforms without a staged pipeline ignore it.
+    virtual void set_model_config(const common::ModelConfig& /*config*/) {}
+
+    // Where recognition results are written; without one, the output section
+    // of the model config is used. Must be called before recording starts.
+    virtual void set_output(std::shared_ptr<output::OutputWriter> /*output*/) {}
+
+    // Queue depth and drop counters for each pipeline stage
+    virtual pipeline::PipelineStats get_pipeline_stats() const { return {}; }
 };
 
 } // namespace audio 
\ No newline at end of file
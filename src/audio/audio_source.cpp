@@ -0,0 +1,113 @@
+#include "audio/audio_source.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+#include "audio/sources/file_audio_source.h"
+#include "audio/sources/synthetic_audio_source.h"
+
+namespace audio {
+
+namespace {
+
+// Matches the 25 ms fragments PulseAudio delivers
+constexpr size_t kChunkSamples = IAudioSource::SAMPLE_RATE / 40;
+
+// How long to wait before retrying a chunk the sink did not accept
+constexpr auto kBackpressureDelay = std::chrono::milliseconds(2);
+
+bool ends_with(const std::string& value, const std::string& suffix) {
+    return value.size() >= suffix.size()
+        && std::equal(suffix.rbegin(), suffix.rend(), value.rbegin(),
+                      [](char a, char b) { return ::tolower(a) == ::tolower(b); });
+}
+
+} // namespace
+
+std::unique_ptr<IAudioSource> IAudioSource::Create(const std::string& spec) {
+    if (spec == "stdin" || spec == "-") {
+        return std::make_unique<FileAudioSource>("", FileAudioSource::Format::Raw);
+    }
+    if (spec.rfind("raw:", 0) == 0) {
+        return std::make_unique<FileAudioSource>(spec.substr(4), FileAudioSource::Format::Raw);
+    }
+    if (spec.rfind("file:", 0) == 0) {
+        return std::make_unique<FileAudioSource>(spec.substr(5), FileAudioSource::Format::Wav);
+    }
+    if (spec == "synth" || spec.rfind("synth:", 0) == 0) {
+        double seconds = spec.size() > 6 ? std::stod(spec.substr(6)) : 60.0;
+        if (seconds <= 0.0) {
+            throw std::runtime_error("Synthetic source duration must be positive: " + spec);
+        }
+        return std::make_unique<SyntheticAudioSource>(seconds);
+    }
+    if (ends_with(spec, ".wav")) {
+        return std::make_unique<FileAudioSource>(spec, FileAudioSource::Format::Wav);
+    }
+    if (ends_with(spec, ".pcm") || ends_with(spec, ".raw")) {
+        return std::make_unique<FileAudioSource>(spec, FileAudioSource::Format::Raw);
+    }
+    throw std::runtime_error("Unknown audio source: " + spec);
+}
+
+AudioSourcePlayer::AudioSourcePlayer(std::unique_ptr<IAudioSource> source, double speed, Sink sink)
+    : source_(std::move(source))
+    , speed_(speed)
+    , sink_(std::move(sink))
+    , stopping_(false)
+    , finished_(false)
+    , samples_played_(0) {
+}
+
+AudioSourcePlayer::~AudioSourcePlayer() {
+    stop();
+}
+
+void AudioSourcePlayer::start() {
+    if (thread_.joinable()) {
+        return;
+    }
+    stopping_ = false;
+    finished_ = false;
+    thread_ = std::thread(&AudioSourcePlayer::run, this);
+}
+
+void AudioSourcePlayer::stop() {
+    stopping_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void AudioSourcePlayer::run() {
+    std::vector<int16_t> chunk(kChunkSamples);
+    const auto started = std::chrono::steady_clock::now();
+    uint64_t played = 0;
+
+    while (!stopping_) {
+        const size_t n = source_->read(chunk.data(), chunk.size());
+        if (n == 0) {
+            break;
+        }
+
+        // Pace against the start time rather than sleeping per chunk, so
+        // scheduling jitter does not accumulate
+        if (speed_ > 0.0) {
+            const auto due = started + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(played / (IAudioSource::SAMPLE_RATE * speed_)));
+            std::this_thread::sleep_until(due);
+        }
+
+        while (!sink_(chunk.data(), n)) {
+            if (stopping_) {
+                break;
+            }
+            std::this_thread::sleep_for(kBackpressureDelay);
+        }
+        played += n;
+        samples_played_.store(played, std::memory_order_relaxed);
+    }
+    finished_ = true;
+}
+
+} // namespace audio
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace audio {
+
+// A pull-based producer of 16 kHz mono PCM, independent of any sound server.
+// Sources are read from one thread at a time (see AudioSourcePlayer).
+class IAudioSource {
+public:
+    static constexpr int SAMPLE_RATE = 16000;
+
+    virtual ~IAudioSource() = default;
+
+    // Human-readable description, e.g. the file path
+    virtual std::string name() const = 0;
+
+    // Reads up to max_samples samples. Returns 0 once the source is exhausted.
+    virtual size_t read(int16_t* out, size_t max_samples) = 0;
+
+    // Creates a source from a spec:
+    //   file:<path> or <path>.wav   WAV file (PCM16 or float32, any channel count)
+    //   raw:<path>                  headerless 16 kHz mono s16le PCM
+    //   stdin                       headerless 16 kHz mono s16le PCM on standard input
+    //   synth[:<seconds>]           generated speech-like bursts and silence (default 60 s)
+    static std::unique_ptr<IAudioSource> Create(const std::string& spec);
+};
+
+// Drives a source on its own thread and hands chunks to a sink, paced like a
+// live capture callback. speed 1.0 plays in real time, 4.0 four times faster,
+// and 0 as fast as the sink accepts. When the sink returns false (its buffer is
+// full) the chunk is retried, so accelerated playback applies backpressure
+// instead of dropping audio.
+class AudioSourcePlayer {
+public:
+    using Sink = std::function<bool(const int16_t* samples, size_t n)>;
+
+    AudioSourcePlayer(std::unique_ptr<IAudioSource> source, double speed, Sink sink);
+    ~AudioSourcePlayer();
+
+    AudioSourcePlayer(const AudioSourcePlayer&) = delete;
+    AudioSourcePlayer& operator=(const AudioSourcePlayer&) = delete;
+
+    void start();
+    // Stops early; playback also ends on its own when the source is exhausted
+    void stop();
+    bool finished() const { return finished_; }
+
+    const IAudioSource& source() const { return *source_; }
+    uint64_t samples_played() const { return samples_played_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    std::unique_ptr<IAudioSource> source_;
+    double speed_;
+    Sink sink_;
+
+    std::thread thread_;
+    std::atomic<bool> stopping_;
+    std::atomic<bool> finished_;
+    std::atomic<uint64_t> samples_played_;
+};
+
+} // namespace audio
@@ -0,0 +1,118 @@
+#include "audio/dsp/capture_converter.h"
+#include "audio/dsp/sample_kernels.h"
+#include <chrono>
+#include <random>
+#include <stdexcept>
+
+namespace dsp {
+
+CaptureConverter::CaptureConverter(Format format, int input_rate, int channels, int channel)
+    : format_(format)
+    , input_rate_(input_rate)
+    , channels_(channels)
+    , channel_(channel)
+    , bytes_per_frame_(static_cast<size_t>(channels) * (format == Format::S16 ? sizeof(int16_t) : sizeof(float))) {
+    if (channels <= 0) {
+        throw std::invalid_argument("Capture channel count must be positive");
+    }
+    if (channel >= channels) {
+        throw std::invalid_argument("Capture channel " + std::to_string(channel) + " does not exist, the source has "
+                                    + std::to_string(channels) + " channels");
+    }
+
+    mono_.resize(kChunkFrames);
+    if (format_ == Format::S16) {
+        interleaved_.resize(kChunkFrames * static_cast<size_t>(channels_));
+    }
+    size_t max_output = kChunkFrames;
+    if (input_rate_ != OUTPUT_RATE) {
+        resampler_ = std::make_unique<PolyphaseResampler>(input_rate_, OUTPUT_RATE, kChunkFrames);
+        max_output = resampler_->max_output(kChunkFrames);
+        resampled_.resize(max_output);
+    }
+    pcm_.resize(max_output);
+}
+
+const int16_t* CaptureConverter::convert_chunk(const uint8_t* in, size_t frames, size_t& produced) {
+    const SampleKernels& k = kernels();
+    const bool mix_all = channel_ < 0;
+
+    // Interleaved float input still to be mixed into mono_
+    const float* interleaved = nullptr;
+    if (format_ == Format::Float32) {
+        interleaved = reinterpret_cast<const float*>(in);
+    } else {
+        const int16_t* samples = reinterpret_cast<const int16_t*>(in);
+        // At 16 kHz, mono or plain stereo S16 needs no float round trip
+        if (!resampler_ && channels_ == 1) {
+            produced = frames;
+            return samples;
+        }
+        if (!resampler_ && channels_ == 2 && mix_all) {
+            k.downmix_s16(samples, pcm_.data(), frames);
+            produced = frames;
+            return pcm_.data();
+        }
+        if (channels_ == 2 && mix_all) {
+            k.downmix_s16_to_float(samples, mono_.data(), frames, kS16ToFloat);
+        } else {
+            k.s16_to_float(samples, interleaved_.data(), frames * static_cast<size_t>(channels_), kS16ToFloat);
+            interleaved = interleaved_.data();
+        }
+    }
+
+    if (interleaved) {
+        const size_t stride = static_cast<size_t>(channels_);
+        if (mix_all) {
+            k.mix_to_mono_f32(interleaved, stride, stride, mono_.data(), frames, 1.0f / static_cast<float>(channels_));
+        } else {
+            k.mix_to_mono_f32(interleaved + channel_, stride, 1, mono_.data(), frames, 1.0f);
+        }
+    }
+
+    const float* mono = mono_.data();
+    size_t n = frames;
+    if (resampler_) {
+        n = resampler_->process(mono_.data(), frames, resampled_.data());
+        mono = resampled_.data();
+    }
+    k.float_to_s16(mono, pcm_.data(), n, kFloatToS16);
+    produced = n;
+    return pcm_.data();
+}
+
+double CaptureConverter::measure_cost(Format format, int input_rate, int channels, int channel) {
+    using Clock = std::chrono::steady_clock;
+    constexpr int kSeconds = 2;
+    constexpr int kRuns = 3;
+
+    // Noise at a speech-like level; content does not change the cost
+    const size_t chunk = static_cast<size_t>(input_rate) / 40;
+    const size_t samples = static_cast<size_t>(input_rate) * kSeconds * static_cast<size_t>(channels);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-0.3f, 0.3f);
+    std::vector<float> f32(samples);
+    std::vector<int16_t> s16(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        f32[i] = dist(rng);
+        s16[i] = static_cast<int16_t>(f32[i] * 32767.0f);
+    }
+    const uint8_t* data = format == Format::S16 ? reinterpret_cast<const uint8_t*>(s16.data())
+                                                : reinterpret_cast<const uint8_t*>(f32.data());
+
+    double best = 0.0;
+    for (int run = 0; run < kRuns; ++run) {
+        CaptureConverter converter(format, input_rate, channels, channel);
+        const auto start = Clock::now();
+        for (size_t frame = 0; frame + chunk <= static_cast<size_t>(input_rate) * kSeconds; frame += chunk) {
+            converter.convert(data + frame * converter.bytes_per_frame(), chunk, [](const int16_t*, size_t) {});
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (run == 0 || seconds < best) {
+            best = seconds;
+        }
+    }
+    return best / kSeconds;
+}
+
+} // namespace dsp
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "audio/dsp/polyphase_resampler.h"
+
+namespace dsp {
+
+// Turns interleaved frames as delivered by the sound server into the 16 kHz
+// mono S16 the recognition pipeline takes: channel mixing or selection,
+// resampling when the input rate differs, and conversion to S16. All buffers
+// are sized in the constructor, so convert() makes no allocations.
+class CaptureConverter {
+public:
+    enum class Format {
+        S16,      // Interleaved native-endian int16
+        Float32,  // Interleaved native-endian float in [-1, 1]
+    };
+
+    static constexpr int OUTPUT_RATE = 16000;
+    // Frames converted per pass; 25 ms fragments normally fit in one
+    static constexpr size_t kChunkFrames = 4096;
+
+    // channel < 0 mixes all channels; otherwise only that channel is kept
+    CaptureConverter(Format format, int input_rate, int channels, int channel = -1);
+
+    CaptureConverter(const CaptureConverter&) = delete;
+    CaptureConverter& operator=(const CaptureConverter&) = delete;
+
+    // Converts frames of interleaved input and calls
+    // emit(const int16_t* pcm, size_t n) for every non-empty chunk of output
+    template <typename Emit>
+    void convert(const void* data, size_t frames, Emit&& emit) {
+        const uint8_t* in = static_cast<const uint8_t*>(data);
+        while (frames > 0) {
+            const size_t n = std::min(frames, kChunkFrames);
+            size_t produced = 0;
+            const int16_t* pcm = convert_chunk(in, n, produced);
+            if (produced > 0) {
+                emit(pcm, produced);
+            }
+            in += n * bytes_per_frame_;
+            frames -= n;
+        }
+    }
+
+    size_t bytes_per_frame() const { return bytes_per_frame_; }
+    int input_rate() const { return input_rate_; }
+    int channels() const { return channels_; }
+
+    // Share of one CPU core this conversion takes on this host, e.g. 0.002
+    // for 0.2%, measured on a few seconds of synthetic input in 25 ms chunks
+    static double measure_cost(Format format, int input_rate, int channels, int channel = -1);
+
+private:
+    const int16_t* convert_chunk(const uint8_t* in, size_t frames, size_t& produced);
+
+    const Format format_;
+    const int input_rate_;
+    const int channels_;
+    const int channel_;
+    const size_t bytes_per_frame_;
+
+    std::unique_ptr<PolyphaseResampler> resampler_;  // Only when input_rate_ != OUTPUT_RATE
+    std::vector<float> interleaved_;  // S16 input widened to float, when mixing needs it
+    std::vector<float> mono_;         // Mono float at the input rate
+    std::vector<float> resampled_;    // Mono float at 16 kHz
+    std::vector<int16_t> pcm_;        // Output
+};
+
+} // namespace dsp
@@ -0,0 +1,135 @@
+#include "audio/dsp/polyphase_resampler.h"
+#include "audio/dsp/sample_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace dsp {
+
+namespace {
+
+// Cutoff as a fraction of the lower Nyquist rate. The transition band ends
+// at the Nyquist rate, so nothing above it folds back.
+constexpr double kCutoff = 0.92;
+// Kaiser window shape; 8 gives about 80 dB of stopband attenuation
+constexpr double kKaiserBeta = 8.0;
+// Default taps per phase for every multiple of decimation
+constexpr double kTapsPerRatio = 64.0;
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Modified Bessel function of the first kind, order zero
+double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler(int input_rate, int output_rate, size_t max_input_frames,
+                                       int taps_per_phase)
+    : input_rate_(input_rate)
+    , output_rate_(output_rate)
+    , max_input_frames_(max_input_frames) {
+    if (input_rate <= 0 || output_rate <= 0) {
+        throw std::invalid_argument("Sample rates must be positive");
+    }
+
+    const size_t g = std::gcd(static_cast<size_t>(input_rate), static_cast<size_t>(output_rate));
+    up_ = static_cast<size_t>(output_rate) / g;
+    down_ = static_cast<size_t>(input_rate) / g;
+    step_whole_ = down_ / up_;
+    step_frac_ = down_ % up_;
+
+    const double ratio = std::max(1.0, static_cast<double>(input_rate) / output_rate);
+    size_t taps = taps_per_phase > 0 ? static_cast<size_t>(taps_per_phase)
+                                     : static_cast<size_t>(std::ceil(kTapsPerRatio * ratio));
+    taps_ = round_up(std::max<size_t>(taps, kDotBlock), kDotBlock);
+
+    // Tap t of phase p weighs the input sample at distance
+    // u = (taps/2 - 1 - t) + p/L from the output position, in input samples
+    const double cutoff = kCutoff / ratio;  // Relative to the input Nyquist rate
+    const double half = static_cast<double>(taps_) / 2.0;
+    const double i0_beta = bessel_i0(kKaiserBeta);
+    filter_.resize(up_ * taps_);
+    for (size_t p = 0; p < up_; ++p) {
+        float* phase = &filter_[p * taps_];
+        double sum = 0.0;
+        for (size_t t = 0; t < taps_; ++t) {
+            const double u = (half - 1.0 - static_cast<double>(t)) + static_cast<double>(p) / up_;
+            const double x = cutoff * u;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(kPi * x) / (kPi * x);
+            const double r = u / half;
+            const double window = r * r >= 1.0 ? 0.0 : bessel_i0(kKaiserBeta * std::sqrt(1.0 - r * r)) / i0_beta;
+            const double h = cutoff * sinc * window;
+            phase[t] = static_cast<float>(h);
+            sum += h;
+        }
+        // Unity gain at DC for every phase, so a constant input stays constant
+        for (size_t t = 0; t < taps_; ++t) {
+            phase[t] = static_cast<float>(phase[t] / sum);
+        }
+    }
+
+    history_.resize(taps_ - 1 + max_input_frames_);
+    reset();
+}
+
+void PolyphaseResampler::reset() {
+    // Half a filter of silence before the first sample, so output 0 is
+    // centred on input 0 instead of being delayed by the filter length
+    filled_ = taps_ / 2 - 1;
+    std::fill(history_.begin(), history_.begin() + filled_, 0.0f);
+    pos_ = 0;
+    phase_ = 0;
+}
+
+size_t PolyphaseResampler::max_output(size_t n) const {
+    return (taps_ + n) * up_ / down_ + 1;
+}
+
+size_t PolyphaseResampler::process(const float* in, size_t n, float* out) {
+    if (n > max_input_frames_) {
+        throw std::length_error("Resampler input chunk exceeds max_input_frames");
+    }
+
+    std::memcpy(history_.data() + filled_, in, n * sizeof(float));
+    filled_ += n;
+
+    const auto dot = kernels().dot;
+    const float* history = history_.data();
+    size_t produced = 0;
+    while (pos_ + taps_ <= filled_) {
+        out[produced++] = dot(history + pos_, &filter_[phase_ * taps_], taps_);
+        pos_ += step_whole_;
+        phase_ += step_frac_;
+        if (phase_ >= up_) {
+            phase_ -= up_;
+            ++pos_;
+        }
+    }
+
+    // Keep the samples the next outputs still need. When decimating, pos_
+    // can run past the buffered input; the excess is skipped from the next chunk.
+    const size_t consumed = std::min(pos_, filled_);
+    std::memmove(history_.data(), history_.data() + consumed, (filled_ - consumed) * sizeof(float));
+    filled_ -= consumed;
+    pos_ -= consumed;
+    return produced;
+}
+
+} // namespace dsp
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dsp {
+
+// Streaming rational resampler for mono float audio. The rate ratio is
+// reduced to L/M; output sample k sits at input position k * M / L and is a
+// dot product of taps_per_phase input samples with one of L precomputed
+// filter phases (a Kaiser-windowed sinc cut off below the lower Nyquist
+// rate). The last taps of each chunk are kept, so splitting the input into
+// chunks of any size produces exactly the same output as one call.
+//
+// process() makes no allocations and no divisions per sample; the dot
+// product runs on the dispatched SIMD kernel.
+class PolyphaseResampler {
+public:
+    // max_input_frames bounds the input of a single process() call.
+    // taps_per_phase is rounded up to a multiple of kDotBlock; 0 picks a
+    // length that keeps aliasing below about -80 dB for the given ratio.
+    PolyphaseResampler(int input_rate, int output_rate, size_t max_input_frames,
+                       int taps_per_phase = 0);
+
+    PolyphaseResampler(const PolyphaseResampler&) = delete;
+    PolyphaseResampler& operator=(const PolyphaseResampler&) = delete;
+
+    // Resamples n input frames (n <= max_input_frames) into out, which must
+    // hold max_output(n) samples. Returns the number of samples written.
+    size_t process(const float* in, size_t n, float* out);
+
+    // Upper bound of the samples one process() call of n frames can return
+    size_t max_output(size_t n) const;
+
+    // Forgets buffered input, e.g. after an audio hole
+    void reset();
+
+    int input_rate() const { return input_rate_; }
+    int output_rate() const { return output_rate_; }
+    size_t taps_per_phase() const { return taps_; }
+
+private:
+    const int input_rate_;
+    const int output_rate_;
+    size_t up_;    // L: filter phases
+    size_t down_;  // M
+    size_t taps_;
+    size_t max_input_frames_;
+    size_t step_whole_;  // M / L
+    size_t step_frac_;   // M % L
+
+    std::vector<float> filter_;  // up_ phases of taps_ coefficients each
+    std::vector<float> history_; // Unconsumed input, at most taps_ - 1 + max_input_frames_ samples
+    size_t filled_;  // Samples in history_
+    size_t pos_;     // First input sample under the filter for the next output
+    size_t phase_;   // Filter phase of the next output, in [0, up_)
+};
+
+} // namespace dsp
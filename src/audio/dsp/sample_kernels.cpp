@@ -0,0 +1,146 @@
+#include "audio/dsp/sample_kernels_impl.h"
+#include <cmath>
+
+namespace dsp {
+
+namespace detail {
+
+void downmix_s16_scalar(const int16_t* in, int16_t* out, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        const int32_t sum = static_cast<int32_t>(in[2 * i]) + static_cast<int32_t>(in[2 * i + 1]);
+        out[i] = static_cast<int16_t>(sum / 2);
+    }
+}
+
+void s16_to_float_scalar(const int16_t* in, float* out, size_t n, float scale) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<float>(in[i]) * scale;
+    }
+}
+
+void downmix_s16_to_float_scalar(const int16_t* in, float* out, size_t frames, float scale) {
+    for (size_t i = 0; i < frames; ++i) {
+        const int32_t sum = static_cast<int32_t>(in[2 * i]) + static_cast<int32_t>(in[2 * i + 1]);
+        out[i] = static_cast<float>(sum / 2) * scale;
+    }
+}
+
+void scale_scalar(float* data, size_t n, float gain) {
+    for (size_t i = 0; i < n; ++i) {
+        data[i] *= gain;
+    }
+}
+
+void float_to_s16_scalar(const float* in, int16_t* out, size_t n, float scale) {
+    for (size_t i = 0; i < n; ++i) {
+        float v = in[i] * scale;
+        v = v < -32768.0f ? -32768.0f : v;
+        v = v > 32767.0f ? 32767.0f : v;
+        out[i] = static_cast<int16_t>(std::lrint(v));
+    }
+}
+
+void mix_to_mono_f32_scalar(const float* in, size_t stride, size_t channels, float* out, size_t frames, float gain) {
+    for (size_t i = 0; i < frames; ++i) {
+        const float* frame = in + i * stride;
+        float sum = frame[0];
+        for (size_t c = 1; c < channels; ++c) {
+            sum += frame[c];
+        }
+        out[i] = sum * gain;
+    }
+}
+
+} // namespace detail
+
+namespace {
+
+float dot_scalar(const float* a, const float* b, size_t n) {
+    float lanes[kDotBlock] = {};
+    for (size_t i = 0; i < n; i += kDotBlock) {
+        for (size_t l = 0; l < kDotBlock; ++l) {
+            lanes[l] += a[i + l] * b[i + l];
+        }
+    }
+    return detail::reduce_dot_block(lanes);
+}
+
+const SampleKernels kScalarKernels = {
+    Isa::Scalar,
+    detail::downmix_s16_scalar,
+    detail::s16_to_float_scalar,
+    detail::downmix_s16_to_float_scalar,
+    detail::scale_scalar,
+    detail::mix_to_mono_f32_scalar,
+    detail::float_to_s16_scalar,
+    dot_scalar,
+};
+
+bool cpu_supports(Isa isa) {
+#if defined(DSP_X86_KERNELS)
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+        case Isa::Sse2:
+            return __builtin_cpu_supports("sse2");
+        case Isa::Avx2:
+            return __builtin_cpu_supports("avx2");
+        case Isa::Avx512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    }
+    return false;
+#else
+    return isa == Isa::Scalar;
+#endif
+}
+
+const SampleKernels* select_best() {
+    const Isa preference[] = {Isa::Avx512, Isa::Avx2, Isa::Sse2};
+    for (Isa isa : preference) {
+        if (const SampleKernels* k = kernels_for(isa)) {
+            return k;
+        }
+    }
+    return &kScalarKernels;
+}
+
+} // namespace
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::Sse2: return "sse2";
+        case Isa::Avx2: return "avx2";
+        case Isa::Avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+const SampleKernels* kernels_for(Isa isa) {
+    if (!cpu_supports(isa)) {
+        return nullptr;
+    }
+    switch (isa) {
+        case Isa::Scalar:
+            return &kScalarKernels;
+#if defined(DSP_X86_KERNELS)
+        case Isa::Sse2:
+            return &detail::kSse2Kernels;
+        case Isa::Avx2:
+            return &detail::kAvx2Kernels;
+        case Isa::Avx512:
+            return &detail::kAvx512Kernels;
+#else
+        default:
+            break;
+#endif
+    }
+    return nullptr;
+}
+
+const SampleKernels& kernels() {
+    static const SampleKernels* const best = select_best();
+    return *best;
+}
+
+} // namespace dsp
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dsp {
+
+// Instruction sets the sample kernels are built for, in order of preference
+enum class Isa {
+    Scalar,
+    Sse2,
+    Avx2,
+    Avx512,  // AVX-512F + AVX-512BW
+};
+
+const char* isa_name(Isa isa);
+
+// One implementation of every sample kernel. All implementations produce
+// bit-identical output to the scalar one: integer downmixing truncates toward
+// zero like (l + r) / 2, float results are a single int->float conversion
+// followed by one multiply, rounding is to nearest even, no fused
+// multiply-add is used, and dot() sums kDotBlock partial sums in a fixed order.
+struct SampleKernels {
+    Isa isa;
+
+    // Interleaved stereo S16 -> mono S16, out[i] = (l + r) / 2
+    void (*downmix_s16)(const int16_t* in, int16_t* out, size_t frames);
+    // S16 -> float, out[i] = in[i] * scale
+    void (*s16_to_float)(const int16_t* in, float* out, size_t n, float scale);
+    // Interleaved stereo S16 -> mono float, out[i] = ((l + r) / 2) * scale
+    void (*downmix_s16_to_float)(const int16_t* in, float* out, size_t frames, float scale);
+    // In-place gain, data[i] *= gain
+    void (*scale)(float* data, size_t n, float gain);
+    // Interleaved float -> mono float. Frame i starts at in[i * stride]; its
+    // first channels samples are summed in order, out[i] = sum * gain.
+    // Mixing all channels is (stride = n, channels = n, gain = 1/n), picking
+    // channel c is (in + c, stride = n, channels = 1, gain = 1).
+    void (*mix_to_mono_f32)(const float* in, size_t stride, size_t channels, float* out, size_t frames, float gain);
+    // float -> S16, out[i] = round(clamp(in[i] * scale, -32768, 32767)); in must be finite
+    void (*float_to_s16)(const float* in, int16_t* out, size_t n, float scale);
+    // sum(a[i] * b[i]); n must be a multiple of kDotBlock
+    float (*dot)(const float* a, const float* b, size_t n);
+};
+
+// dot() accumulates kDotBlock interleaved partial sums and adds them pairwise
+// at the end, so every vector width computes the same sum in the same order
+constexpr size_t kDotBlock = 16;
+
+// Best implementation for this CPU, picked on the first call
+const SampleKernels& kernels();
+
+// A specific implementation, or nullptr if it was not built or the CPU lacks
+// the instructions. Used by tests and benchmarks to compare implementations.
+const SampleKernels* kernels_for(Isa isa);
+
+// Scale that maps S16 to [-1, 1), as expected by sherpa-onnx, and back
+constexpr float kS16ToFloat = 1.0f / 32768.0f;
+constexpr float kFloatToS16 = 32768.0f;
+
+} // namespace dsp
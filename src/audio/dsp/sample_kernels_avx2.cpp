@@ -0,0 +1,124 @@
+// Built with -mavx2 (see src/CMakeLists.txt); only reached when the CPU has AVX2
+#if defined(DSP_X86_KERNELS)
+
+#include "audio/dsp/sample_kernels_impl.h"
+#include <immintrin.h>
+
+namespace dsp {
+namespace detail {
+
+namespace {
+
+// Per-lane (l + r) / 2 of an interleaved stereo vector, truncated toward zero
+inline __m256i half_sum(__m256i stereo) {
+    const __m256i sum = _mm256_madd_epi16(stereo, _mm256_set1_epi16(1));
+    return _mm256_srai_epi32(_mm256_add_epi32(sum, _mm256_srli_epi32(sum, 31)), 1);
+}
+
+void downmix_s16_avx2(const int16_t* in, int16_t* out, size_t frames) {
+    size_t i = 0;
+    for (; i + 16 <= frames; i += 16) {
+        const __m256i lo = half_sum(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * i)));
+        const __m256i hi = half_sum(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * i + 16)));
+        // packs works per 128-bit lane; restore frame order across the lanes
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    downmix_s16_scalar(in + 2 * i, out + i, frames - i);
+}
+
+void s16_to_float_avx2(const int16_t* in, float* out, size_t n, float scale) {
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        const __m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), s));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), s));
+    }
+    s16_to_float_scalar(in + i, out + i, n - i, scale);
+}
+
+void downmix_s16_to_float_avx2(const int16_t* in, float* out, size_t frames, float scale) {
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m256i mono = half_sum(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * i)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(mono), s));
+    }
+    downmix_s16_to_float_scalar(in + 2 * i, out + i, frames - i, scale);
+}
+
+void scale_avx2(float* data, size_t n, float gain) {
+    const __m256 g = _mm256_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), g));
+    }
+    scale_scalar(data + i, n - i, gain);
+}
+
+void mix_to_mono_f32_avx2(const float* in, size_t stride, size_t channels, float* out, size_t frames, float gain) {
+    if (stride != 2 || channels != 2) {
+        mix_to_mono_f32_scalar(in, stride, channels, out, frames, gain);
+        return;
+    }
+    const __m256 g = _mm256_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m256 a = _mm256_loadu_ps(in + 2 * i);
+        const __m256 b = _mm256_loadu_ps(in + 2 * i + 8);
+        // Per 128-bit lane, so frames come out as 0 1 4 5 2 3 6 7; the permute restores order
+        const __m256 left = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 right = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m256 sum = _mm256_mul_ps(_mm256_add_ps(left, right), g);
+        _mm256_storeu_ps(out + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), 0xD8)));
+    }
+    mix_to_mono_f32_scalar(in + 2 * i, stride, channels, out + i, frames - i, gain);
+}
+
+void float_to_s16_avx2(const float* in, int16_t* out, size_t n, float scale) {
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 lo = _mm256_set1_ps(-32768.0f);
+    const __m256 hi = _mm256_set1_ps(32767.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), s), lo), hi);
+        const __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i + 8), s), lo), hi);
+        const __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    float_to_s16_scalar(in + i, out + i, n - i, scale);
+}
+
+// Two accumulators hold the kDotBlock lanes 0-7 and 8-15
+float dot_avx2(const float* a, const float* b, size_t n) {
+    __m256 lo = _mm256_setzero_ps();
+    __m256 hi = _mm256_setzero_ps();
+    for (size_t i = 0; i < n; i += kDotBlock) {
+        lo = _mm256_add_ps(lo, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        hi = _mm256_add_ps(hi, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    }
+    const __m256 sum8 = _mm256_add_ps(lo, hi);
+    const __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+    const __m128 sum2 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    return _mm_cvtss_f32(_mm_add_ss(sum2, _mm_shuffle_ps(sum2, sum2, 1)));
+}
+
+} // namespace
+
+const SampleKernels kAvx2Kernels = {
+    Isa::Avx2,
+    downmix_s16_avx2,
+    s16_to_float_avx2,
+    downmix_s16_to_float_avx2,
+    scale_avx2,
+    mix_to_mono_f32_avx2,
+    float_to_s16_avx2,
+    dot_avx2,
+};
+
+} // namespace detail
+} // namespace dsp
+
+#endif // DSP_X86_KERNELS
@@ -0,0 +1,118 @@
+// Built with -mavx512f -mavx512bw (see src/CMakeLists.txt); only reached when
+// the CPU has both
+#if defined(DSP_X86_KERNELS)
+
+#include "audio/dsp/sample_kernels_impl.h"
+#include <immintrin.h>
+
+namespace dsp {
+namespace detail {
+
+namespace {
+
+// Per-lane (l + r) / 2 of an interleaved stereo vector, truncated toward zero
+inline __m512i half_sum(__m512i stereo) {
+    const __m512i sum = _mm512_madd_epi16(stereo, _mm512_set1_epi16(1));
+    return _mm512_srai_epi32(_mm512_add_epi32(sum, _mm512_srli_epi32(sum, 31)), 1);
+}
+
+void downmix_s16_avx512(const int16_t* in, int16_t* out, size_t frames) {
+    size_t i = 0;
+    for (; i + 16 <= frames; i += 16) {
+        const __m512i mono = half_sum(_mm512_loadu_si512(in + 2 * i));
+        // Every half sum fits in 16 bits, so narrowing without saturation is exact
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm512_cvtepi32_epi16(mono));
+    }
+    downmix_s16_scalar(in + 2 * i, out + i, frames - i);
+}
+
+void s16_to_float_avx512(const int16_t* in, float* out, size_t n, float scale) {
+    const __m512 s = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512i x = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)));
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_cvtepi32_ps(x), s));
+    }
+    s16_to_float_scalar(in + i, out + i, n - i, scale);
+}
+
+void downmix_s16_to_float_avx512(const int16_t* in, float* out, size_t frames, float scale) {
+    const __m512 s = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= frames; i += 16) {
+        const __m512i mono = half_sum(_mm512_loadu_si512(in + 2 * i));
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_cvtepi32_ps(mono), s));
+    }
+    downmix_s16_to_float_scalar(in + 2 * i, out + i, frames - i, scale);
+}
+
+void scale_avx512(float* data, size_t n, float gain) {
+    const __m512 g = _mm512_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(data + i, _mm512_mul_ps(_mm512_loadu_ps(data + i), g));
+    }
+    scale_scalar(data + i, n - i, gain);
+}
+
+void mix_to_mono_f32_avx512(const float* in, size_t stride, size_t channels, float* out, size_t frames, float gain) {
+    if (stride != 2 || channels != 2) {
+        mix_to_mono_f32_scalar(in, stride, channels, out, frames, gain);
+        return;
+    }
+    const __m512 g = _mm512_set1_ps(gain);
+    const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    size_t i = 0;
+    for (; i + 16 <= frames; i += 16) {
+        const __m512 a = _mm512_loadu_ps(in + 2 * i);
+        const __m512 b = _mm512_loadu_ps(in + 2 * i + 16);
+        const __m512 left = _mm512_permutex2var_ps(a, even, b);
+        const __m512 right = _mm512_permutex2var_ps(a, odd, b);
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_add_ps(left, right), g));
+    }
+    mix_to_mono_f32_scalar(in + 2 * i, stride, channels, out + i, frames - i, gain);
+}
+
+void float_to_s16_avx512(const float* in, int16_t* out, size_t n, float scale) {
+    const __m512 s = _mm512_set1_ps(scale);
+    const __m512 lo = _mm512_set1_ps(-32768.0f);
+    const __m512 hi = _mm512_set1_ps(32767.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512 v = _mm512_min_ps(_mm512_max_ps(_mm512_mul_ps(_mm512_loadu_ps(in + i), s), lo), hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm512_cvtepi32_epi16(_mm512_cvtps_epi32(v)));
+    }
+    float_to_s16_scalar(in + i, out + i, n - i, scale);
+}
+
+// One accumulator holds all kDotBlock lanes
+float dot_avx512(const float* a, const float* b, size_t n) {
+    __m512 acc = _mm512_setzero_ps();
+    for (size_t i = 0; i < n; i += kDotBlock) {
+        acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+    }
+    const __m256 upper = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(acc), 1));
+    const __m256 sum8 = _mm256_add_ps(_mm512_castps512_ps256(acc), upper);
+    const __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+    const __m128 sum2 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    return _mm_cvtss_f32(_mm_add_ss(sum2, _mm_shuffle_ps(sum2, sum2, 1)));
+}
+
+} // namespace
+
+const SampleKernels kAvx512Kernels = {
+    Isa::Avx512,
+    downmix_s16_avx512,
+    s16_to_float_avx512,
+    downmix_s16_to_float_avx512,
+    scale_avx512,
+    mix_to_mono_f32_avx512,
+    float_to_s16_avx512,
+    dot_avx512,
+};
+
+} // namespace detail
+} // namespace dsp
+
+#endif // DSP_X86_KERNELS
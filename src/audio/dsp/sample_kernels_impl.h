@@ -0,0 +1,35 @@
+#pragma once
+
+// Internal to the sample_kernels*.cpp files: the per-ISA tables and the
+// scalar routines the vector versions use for their tails.
+
+#include "audio/dsp/sample_kernels.h"
+
+namespace dsp {
+namespace detail {
+
+void downmix_s16_scalar(const int16_t* in, int16_t* out, size_t frames);
+void s16_to_float_scalar(const int16_t* in, float* out, size_t n, float scale);
+void downmix_s16_to_float_scalar(const int16_t* in, float* out, size_t frames, float scale);
+void scale_scalar(float* data, size_t n, float gain);
+void float_to_s16_scalar(const float* in, int16_t* out, size_t n, float scale);
+void mix_to_mono_f32_scalar(const float* in, size_t stride, size_t channels, float* out, size_t frames, float gain);
+
+// Pairwise sum of the kDotBlock partial sums of dot(): (0+8), (0+4), (0+2), (0+1)
+inline float reduce_dot_block(float* lanes) {
+    for (size_t width = kDotBlock / 2; width > 0; width /= 2) {
+        for (size_t i = 0; i < width; ++i) {
+            lanes[i] += lanes[i + width];
+        }
+    }
+    return lanes[0];
+}
+
+// Defined only when the matching file is compiled with its instruction set,
+// see DSP_X86_KERNELS in src/CMakeLists.txt
+extern const SampleKernels kSse2Kernels;
+extern const SampleKernels kAvx2Kernels;
+extern const SampleKernels kAvx512Kernels;
+
+} // namespace detail
+} // namespace dsp
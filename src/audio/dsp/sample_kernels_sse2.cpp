@@ -0,0 +1,124 @@
+// Built with -msse2 (see src/CMakeLists.txt); only reached when the CPU has SSE2
+#if defined(DSP_X86_KERNELS)
+
+#include "audio/dsp/sample_kernels_impl.h"
+#include <emmintrin.h>
+
+namespace dsp {
+namespace detail {
+
+namespace {
+
+// Per-lane (l + r) / 2 of an interleaved stereo vector, truncated toward zero
+inline __m128i half_sum(__m128i stereo) {
+    const __m128i sum = _mm_madd_epi16(stereo, _mm_set1_epi16(1));
+    return _mm_srai_epi32(_mm_add_epi32(sum, _mm_srli_epi32(sum, 31)), 1);
+}
+
+void downmix_s16_sse2(const int16_t* in, int16_t* out, size_t frames) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m128i lo = half_sum(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i)));
+        const __m128i hi = half_sum(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i + 8)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi));
+    }
+    downmix_s16_scalar(in + 2 * i, out + i, frames - i);
+}
+
+void s16_to_float_sse2(const int16_t* in, float* out, size_t n, float scale) {
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+    }
+    s16_to_float_scalar(in + i, out + i, n - i, scale);
+}
+
+void downmix_s16_to_float_sse2(const int16_t* in, float* out, size_t frames, float scale) {
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128i mono = half_sum(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i)));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(mono), s));
+    }
+    downmix_s16_to_float_scalar(in + 2 * i, out + i, frames - i, scale);
+}
+
+void scale_sse2(float* data, size_t n, float gain) {
+    const __m128 g = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), g));
+    }
+    scale_scalar(data + i, n - i, gain);
+}
+
+void mix_to_mono_f32_sse2(const float* in, size_t stride, size_t channels, float* out, size_t frames, float gain) {
+    if (stride != 2 || channels != 2) {
+        mix_to_mono_f32_scalar(in, stride, channels, out, frames, gain);
+        return;
+    }
+    const __m128 g = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 a = _mm_loadu_ps(in + 2 * i);
+        const __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+        const __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(left, right), g));
+    }
+    mix_to_mono_f32_scalar(in + 2 * i, stride, channels, out + i, frames - i, gain);
+}
+
+void float_to_s16_sse2(const float* in, int16_t* out, size_t n, float scale) {
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), s), lo), hi);
+        const __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), s), lo), hi);
+        const __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    float_to_s16_scalar(in + i, out + i, n - i, scale);
+}
+
+// Four accumulators hold the kDotBlock lanes 0-3, 4-7, 8-11 and 12-15
+float dot_sse2(const float* a, const float* b, size_t n) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    __m128 acc2 = _mm_setzero_ps();
+    __m128 acc3 = _mm_setzero_ps();
+    for (size_t i = 0; i < n; i += kDotBlock) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(a + i + 8), _mm_loadu_ps(b + i + 8)));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(a + i + 12), _mm_loadu_ps(b + i + 12)));
+    }
+    const __m128 sum4 = _mm_add_ps(_mm_add_ps(acc0, acc2), _mm_add_ps(acc1, acc3));
+    const __m128 sum2 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    return _mm_cvtss_f32(_mm_add_ss(sum2, _mm_shuffle_ps(sum2, sum2, 1)));
+}
+
+} // namespace
+
+const SampleKernels kSse2Kernels = {
+    Isa::Sse2,
+    downmix_s16_sse2,
+    s16_to_float_sse2,
+    downmix_s16_to_float_sse2,
+    scale_sse2,
+    mix_to_mono_f32_sse2,
+    float_to_s16_sse2,
+    dot_sse2,
+};
+
+} // namespace detail
+} // namespace dsp
+
+#endif // DSP_X86_KERNELS
@@ -1,9 +1,14 @@
 #include "pulse_audio_capture.h"
 #include <audio/audio_format.h>
 #include <common/model_config.h>
-#include <recognizer/model_factory.h>
+#include <recognizer/model_registry.h>
+#include <common/allocation_counter.h>
+#include <audio/dsp/sample_kernels.h>
+#include <trace/trace.h>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include "sherpa-onnx/c-api/c-api.h"
 #include <mutex>
 #include "translator/translator.h"
@@ -12,8 +17,18 @@ namespace linux_pulse {
 PulseAudioCapture::PulseAudioCapture()
     : mainloop_(nullptr)
     , context_(nullptr)
-    , stream_(nullptr)
-    , is_recording(false) {
+    , is_recording(false)
+    , has_model_config_(false)
+    , default_vad_(nullptr)
+    , default_vad_in_use_(false)
+    , captured_bytes_(metrics::Registry::Instance().counter(
+          "voice_assistant_capture_bytes_total", "Bytes of audio read from PulseAudio streams"))
+    , audio_holes_(metrics::Registry::Instance().counter(
+          "voice_assistant_capture_holes_total", "Gaps PulseAudio reported in a recorded stream"))
+    , audio_hole_bytes_(metrics::Registry::Instance().counter(
+          "voice_assistant_capture_hole_bytes_total", "Bytes of audio missing in reported gaps"))
+    , read_errors_(metrics::Registry::Instance().counter(
+          "voice_assistant_capture_read_errors_total", "Failed reads from PulseAudio streams")) {
     
     // 设置默认音频格式
     format_ = {16000, 1, 16};  // 16kHz, mono, 16-bit
@@ -30,28 +45,85 @@ PulseAudioCapture::~PulseAudioCapture() {
     cleanup();
 }
 
+pipeline::RecognitionPipeline& PulseAudioCapture::get_pipeline() {
+    if (!pipeline_) {
+        pipeline_ = std::make_unique<pipeline::RecognitionPipeline>(model_config_.pipeline);
+        if (output_) {
+            pipeline_->set_output(output_);
+        } else if (has_model_config_) {
+            pipeline_->set_output(std::make_shared<output::OutputWriter>(model_config_.output));
+        }
+
+        // Whisper reports no language; detect it per source so results can be translated
+        const auto& whisper = model_config_.whisper;
+        if (has_model_config_ && model_config_.type == "whisper" && whisper.enable_language_detection) {
+            pipeline_->set_language_identifier(std::make_shared<pipeline::LanguageIdService>(
+                recognizer::ModelRegistry::Instance().GetLanguageIdentifier(model_config_),
+                whisper.language_detection_recheck_interval_ms,
+                static_cast<size_t>(whisper.language_detection_queue_capacity)));
+        }
+    }
+    return *pipeline_;
+}
+
+bool PulseAudioCapture::use_native_conversion(const pa_sample_spec& sink_spec) {
+    const common::CaptureConfig& capture = model_config_.capture;
+    if (!pa_sample_spec_valid(&sink_spec) || capture.conversion == "server") {
+        return false;
+    }
+    if (capture.conversion == "native") {
+        return true;
+    }
+
+    // The server's resampling cost is not visible from here, so auto keeps our
+    // own conversion as long as it is cheap on this host
+    const auto key = std::make_pair(sink_spec.rate, sink_spec.channels);
+    auto it = native_conversion_cost_.find(key);
+    if (it == native_conversion_cost_.end()) {
+        const double percent = 100.0 * dsp::CaptureConverter::measure_cost(
+            dsp::CaptureConverter::Format::Float32, static_cast<int>(sink_spec.rate),
+            static_cast<int>(sink_spec.channels), capture.channel < sink_spec.channels ? capture.channel : -1);
+        it = native_conversion_cost_.emplace(key, percent).first;
+        std::cerr << "Native conversion of " << sink_spec.rate << "Hz x" << static_cast<int>(sink_spec.channels)
+                  << " costs " << std::fixed << std::setprecision(3) << percent << "% of a core (budget "
+                  << capture.native_max_cpu_percent << "%)" << std::defaultfloat << std::endl;
+    }
+    return it->second <= capture.native_max_cpu_percent;
+}
+
+pipeline::VadPtr PulseAudioCapture::acquire_vad() {
+    // The first source borrows the VAD handed to set_model_vad; the caller owns it,
+    // so it is only reset and handed back once the source is drained
+    bool expected = false;
+    if (default_vad_ && default_vad_in_use_.compare_exchange_strong(expected, true)) {
+        return pipeline::VadPtr(default_vad_, [this](SherpaOnnxVoiceActivityDetector* vad) {
+            SherpaOnnxVoiceActivityDetectorReset(vad);
+            default_vad_in_use_ = false;
+        });
+    }
+
+    if (!has_model_config_) {
+        throw std::runtime_error("Recording several sources requires set_model_config");
+    }
+    // Pooled, so a source that is stopped and started again reuses a loaded VAD
+    return recognizer::ModelRegistry::Instance().AcquireVad(model_config_);
+}
+
 void PulseAudioCapture::set_model_recognizer(const SherpaOnnxOfflineRecognizer* recognizer) {
     try {
         
         // check vad
-        if (!vad_) {
+        if (!default_vad_) {
             std::cerr << "[ERROR] VAD is not initialized" << std::endl;
             throw std::runtime_error("VAD is not initialized");
         }
         
-        recognizer_ = recognizer;
-        if (!recognizer_) {
+        if (!recognizer) {
             std::cerr << "[ERROR] Recognizer is not initialized" << std::endl;
             throw std::runtime_error("Recognizer is not initialized");
         }
         
-        recognition_stream_ = SherpaOnnxCreateOfflineStream(recognizer_);
-        if (!recognition_stream_) {
-            std::cerr << "[ERROR] Failed to create recognition stream" << std::endl;
-            throw std::runtime_error("Failed to create recognition stream");
-        }
-        
-        recognition_enabled_ = true;
+        get_pipeline().set_recognizer(recognizer);
         
     } catch (const std::exception& e) {
         std::cerr << "Error setting model recognizer: " << e.what() << std::endl;
@@ -62,133 +134,62 @@ void PulseAudioCapture::set_model_recognizer(const SherpaOnnxOfflineRecognizer*
 
 // set model vad
 void PulseAudioCapture::set_model_vad(SherpaOnnxVoiceActivityDetector* vad, const int window_size) {
-    vad_ = vad;
-    window_size_ = window_size;
+    default_vad_ = vad;
+    get_pipeline().set_window_size(window_size);
+}
+
+void PulseAudioCapture::set_model_online_recognizer(const SherpaOnnxOnlineRecognizer* recognizer,
+                                                    const common::StreamingConfig& config) {
+    if (!recognizer) {
+        throw std::runtime_error("Streaming recognizer is not initialized");
+    }
+    get_pipeline().set_online_recognizer(recognizer, config);
 }
 
 void PulseAudioCapture::set_translate(const translator::ITranslator* translate) {
-    translate_ = translate;
+    get_pipeline().set_translator(translate);
 }
 
-// process_audio_for_recognition
-void PulseAudioCapture::process_audio_for_recognition(const std::vector<int16_t>& audio_data) {
-    if (!recognition_enabled_ || !vad_) {
-        return;
+void PulseAudioCapture::set_model_config(const common::ModelConfig& config) {
+    if (pipeline_) {
+        throw std::runtime_error("Model configuration must be set before the models");
     }
-    
-    
-    std::lock_guard<std::mutex> lock(recognition_mutex_);
-    // Convert to float samples
-    std::vector<float> float_samples(audio_data.size());
-    for (size_t i = 0; i < audio_data.size(); ++i) {
-        float_samples[i] = audio_data[i] / 32768.0f;
-    }
-
-    // If we have remaining samples from last batch, prepend them
-    if (!remaining_samples_.empty()) {
-        float_samples.insert(float_samples.begin(),
-                           remaining_samples_.begin(),
-                           remaining_samples_.end());
-        remaining_samples_.clear();
-    }
-
-    const int window_size = window_size_;
-    size_t i = 0;
-    while (i + window_size <= float_samples.size()) {
-        // Feed window_size samples to VAD
-        SherpaOnnxVoiceActivityDetectorAcceptWaveform(
-            vad_,
-            float_samples.data() + i,
-            window_size
-        );
-        
-        // Process any complete speech segments
-        while (!SherpaOnnxVoiceActivityDetectorEmpty(vad_)) {
-            const SherpaOnnxSpeechSegment* segment = 
-                    SherpaOnnxVoiceActivityDetectorFront(vad_);
-            if (segment) {
-                
-                // Create a new stream for this segment
-                const SherpaOnnxOfflineStream* stream = 
-                    SherpaOnnxCreateOfflineStream(recognizer_);
-
-                if (stream) {
-                    // Process the speech segment
-                    SherpaOnnxAcceptWaveformOffline(
-                        stream,
-                        SAMPLE_RATE,
-                        segment->samples,
-                        segment->n
-                    );
-
-                    SherpaOnnxDecodeOfflineStream(recognizer_, stream);
-
-                    const SherpaOnnxOfflineRecognizerResult* result = 
-                        SherpaOnnxGetOfflineStreamResult(stream);
-
-                    if (result && result->text) {
-                        float start = segment->start / static_cast<float>(SAMPLE_RATE);
-                        float duration = segment->n / static_cast<float>(SAMPLE_RATE);
-                        float end = start + duration;
-
-                        std::cout << "\n[Recognition Result]" << std::endl;
-                        std::cout << "Time: " << std::fixed << std::setprecision(3)
-                                  << start << "s -- " << end << "s" << std::endl;
-                        std::cout << "Text: " << result->text << std::endl;
-
-                        if (result->lang) {
-                            std::string language_code = std::string(result->lang).substr(2, 2);
-                            std::transform(language_code.begin(), language_code.end(), language_code.begin(), ::toupper);
-                            std::cout << "Language Code: " << language_code << std::endl;
-
-                            std::string target_lang = translate_->get_target_language();
-                            std::transform(target_lang.begin(), target_lang.end(), target_lang.begin(), ::toupper);
-                            std::cout << "Target Language: " << target_lang << std::endl;
-                            
-                            if (target_lang != language_code) {
-                                try {
-                                    std::string translated_text = translate_->translate(result->text, language_code);
-                                    std::cout << "Translated Text: " << translated_text << std::endl;
-                                } catch (const std::exception& e) {
-                                    std::cerr << "Error translating text: " << e.what() << std::endl;
-                                }
-                            }
-                        }
-                        std::cout << std::string(50, '-') << std::endl;
-                    } else {
-                        std::cout << "No recognition result or empty text" << std::endl;
-                    }
-
-                    // Clean up
-                    SherpaOnnxDestroyOfflineRecognizerResult(result);
-                    SherpaOnnxDestroyOfflineStream(stream);
-                } else {
-                    std::cerr << "[ERROR] Failed to create stream for speech segment" << std::endl;
-                }
-
-                SherpaOnnxDestroySpeechSegment(segment);
-            }
-            SherpaOnnxVoiceActivityDetectorPop(vad_);
-        }
-        i += window_size;
+    model_config_ = config;
+    has_model_config_ = true;
+}
+
+void PulseAudioCapture::set_output(std::shared_ptr<output::OutputWriter> output) {
+    output_ = std::move(output);
+    if (pipeline_) {
+        pipeline_->set_output(output_);
     }
+}
 
-    // Store remaining samples for next batch
-    if (i < float_samples.size()) {
-        remaining_samples_.assign(
-            float_samples.begin() + i,
-            float_samples.end()
-        );
+pipeline::PipelineStats PulseAudioCapture::get_pipeline_stats() const {
+    if (!pipeline_) {
+        return {};
     }
+    return pipeline_->stats();
 }
 
 
+void PulseAudioCapture::destroy_stream(CaptureStream& cs) {
+    if (cs.stream) {
+        pa_stream_disconnect(cs.stream);
+        pa_stream_unref(cs.stream);
+        cs.stream = nullptr;
+    }
+}
+
 void PulseAudioCapture::cleanup() {
-    if (stream_) {
-        pa_stream_disconnect(stream_);
-        pa_stream_unref(stream_);
-        stream_ = nullptr;
+    if (!streams_.empty() && mainloop_) {
+        pa_threaded_mainloop_lock(mainloop_);
+        for (auto& entry : streams_) {
+            destroy_stream(*entry.second);
+        }
+        pa_threaded_mainloop_unlock(mainloop_);
     }
+    streams_.clear();
 
     if (context_) {
         pa_context_disconnect(context_);
@@ -274,80 +275,44 @@ void PulseAudioCapture::stream_state_cb(pa_stream* /*s*/, void* userdata) {
 }
 
 void PulseAudioCapture::stream_read_cb(pa_stream* s, size_t /*length*/, void* userdata) {
-    auto *ac = static_cast<PulseAudioCapture*>(userdata);
+    // The mainloop thread belongs to PulseAudio, so it is named here
+    trace::SetThreadName("pulseaudio");
+    trace::Span span("stream_read_cb", "capture");
+    auto *cs = static_cast<CaptureStream*>(userdata);
+    auto *ac = cs->owner;
     const void *data;
     size_t bytes;
     
     if (pa_stream_peek(s, &data, &bytes) < 0) {
+        ac->read_errors_.inc();
         std::cerr << "Failed to read from stream" << std::endl;
         return;
     }
     
     if (!data) {
         if (bytes > 0) {
+            ac->audio_holes_.inc();
+            ac->audio_hole_bytes_.inc(bytes);
             std::cerr << "Got audio hole of " << bytes << " bytes" << std::endl;
         }
         pa_stream_drop(s);
         return;
     }
     
-    if (bytes > 0 && ac->is_recording) {
-        // std::cout << "Processing " << bytes << " bytes of audio data" << std::endl;
-        // Convert audio data to the required format (16kHz, mono, S16LE)
-        const int16_t *samples = static_cast<const int16_t*>(data);
-        size_t num_samples = bytes / sizeof(int16_t);
-        
-        // std::cout << "Number of samples: " << num_samples << std::endl;
-        
-        // If stereo, convert to mono by averaging channels
-        if (ac->source_spec.channels == 2) {
-            // std::cout << "Converting stereo to mono" << std::endl;
-            for (size_t i = 0; i < num_samples; i += 2) {
-                int32_t mono_sample = (static_cast<int32_t>(samples[i]) + 
-                                     static_cast<int32_t>(samples[i + 1])) / 2;
-                ac->audio_buffer.push_back(static_cast<int16_t>(mono_sample));
-            }
-        } else {
-            std::cout << "Copying mono samples directly" << std::endl;
-            ac->audio_buffer.insert(ac->audio_buffer.end(), samples, samples + num_samples);
-        }
-        
-        // Resample if needed (simple linear resampling)
-        if (ac->source_spec.rate != SAMPLE_RATE) {
-            std::cout << "Resampling from " << ac->source_spec.rate << " to " << SAMPLE_RATE << std::endl;
-            std::vector<int16_t> resampled;
-            float ratio = static_cast<float>(SAMPLE_RATE) / ac->source_spec.rate;
-            size_t new_size = static_cast<size_t>(ac->audio_buffer.size() * ratio);
-            resampled.reserve(new_size);
-            
-            for (size_t i = 0; i < new_size; ++i) {
-                float src_idx = i / ratio;
-                size_t idx1 = static_cast<size_t>(src_idx);
-                size_t idx2 = idx1 + 1;
-                if (idx2 >= ac->audio_buffer.size()) idx2 = idx1;
-                
-                float frac = src_idx - idx1;
-                int16_t sample = static_cast<int16_t>(
-                    ac->audio_buffer[idx1] * (1.0f - frac) + 
-                    ac->audio_buffer[idx2] * frac
-                );
-                resampled.push_back(sample);
-            }
-            
-            ac->audio_buffer = std::move(resampled);
-        }
-        
-        // std::cout << "Final buffer size: " << ac->audio_buffer.size() << " samples" << std::endl;
-    
-        
-        if (ac->recognition_enabled_) {
-                // std::cout << "Processing audio for recognition" << std::endl;
-                ac->process_audio_for_recognition(ac->audio_buffer);
-            }
-        
-        ac->audio_buffer.clear();  // Clear buffer after processing
+    ac->captured_bytes_.inc(bytes);
+    if (bytes > 0 && ac->is_recording && cs->context) {
+        // Conversion and hand-off reuse the buffers sized in start_recording_application,
+        // so the steady state makes no heap allocations; the counter proves it
+        common::AllocationScope allocations(ac->pipeline_->capture_allocations());
+
+        // Convert audio data to the required format (16kHz, mono, S16LE) and hand it off to
+        // the recognition pipeline; this only copies into a lock-free ring buffer
+        cs->converter->convert(data, bytes / cs->converter->bytes_per_frame(),
+                               [ac, cs](const int16_t* pcm, size_t n) {
+                                   ac->pipeline_->push_audio(*cs->context, pcm, n);
+                               });
     }
-    
+
     pa_stream_drop(s);
 }
 
@@ -368,15 +333,18 @@ void PulseAudioCapture::sink_input_info_cb(pa_context* /*c*/, const pa_sink_inpu
         const char* media_role = pa_proplist_gets(i->proplist, "media.role");
         const char* stream_name = i->name;
 
-                    // Debug output
-        std::cout << "Properties for sink input " << i->index << ":\n";
-        std::cout << "  media.name: " << (media_name ? media_name : "null") << "\n";
-        std::cout << "  application.name: " << (application_name ? application_name : "null") << "\n";
-        std::cout << "  application.process.name: " << (application_process_name ? application_process_name : "null") << "\n";
-        std::cout << "  window.title: " << (window_title ? window_title : "null") << "\n";
-        std::cout << "  media.title: " << (media_title ? media_title : "null") << "\n";
-        std::cout << "  media.role: " << (media_role ? media_role : "null") << "\n";
-        std::cout << "  stream_name: " << (stream_name ? stream_name : "null") << "\n";
+        // Debug dump, written in one piece to stderr so it never mixes into
+        // recognition output on stdout
+        std::ostringstream properties;
+        properties << "Properties for sink input " << i->index << ":\n"
+                   << "  media.name: " << (media_name ? media_name : "null") << "\n"
+                   << "  application.name: " << (application_name ? application_name : "null") << "\n"
+                   << "  application.process.name: " << (application_process_name ? application_process_name : "null") << "\n"
+                   << "  window.title: " << (window_title ? window_title : "null") << "\n"
+                   << "  media.title: " << (media_title ? media_title : "null") << "\n"
+                   << "  media.role: " << (media_role ? media_role : "null") << "\n"
+                   << "  stream_name: " << (stream_name ? stream_name : "null") << "\n";
+        std::cerr << properties.str();
         
         // Build descriptive name with available information
         if (window_title && media_title) {
@@ -419,7 +387,7 @@ bool PulseAudioCapture::wait_for_operation(pa_operation* op) {
     return true;
 }
 
-void PulseAudioCapture::list_applications() {
+std::map<uint32_t, std::string> PulseAudioCapture::get_applications() {
     if (!context_ || pa_context_get_state(context_) != PA_CONTEXT_READY) {
         throw std::runtime_error("PulseAudio context not ready");
     }
@@ -440,147 +408,215 @@ void PulseAudioCapture::list_applications() {
             
     pa_operation_unref(op);
     pa_threaded_mainloop_unlock(mainloop_);
-            
-    if (available_applications_.empty()) {
+
+    return available_applications_;
+}
+
+void PulseAudioCapture::list_applications() {
+    const auto applications = get_applications();
+    if (applications.empty()) {
         std::cout << "No applications are currently playing audio." << std::endl;
     } else {
         std::cout << "Applications currently playing audio:" << std::endl;
-        for (const auto& app : available_applications_) {
+        for (const auto& app : applications) {
             std::cout << "  " << app.first << ": " << app.second << std::endl;
         }
     }
 }
 
+std::vector<uint32_t> PulseAudioCapture::recording_applications() const {
+    std::vector<uint32_t> indexes;
+    for (const auto& stream : streams_) {
+        indexes.push_back(stream.first);
+    }
+    return indexes;
+}
+
 bool PulseAudioCapture::start_recording_application(uint32_t sink_input_index) {
-    std::cout << "Starting recording for sink input " << sink_input_index << std::endl;
+    std::cerr << "Starting recording for sink input " << sink_input_index << std::endl;
             
-    if (stream_) {
-        throw std::runtime_error("Already recording");
+    if (streams_.count(sink_input_index)) {
+        throw std::runtime_error("Already recording sink input " + std::to_string(sink_input_index));
     }
 
+    auto cs = std::make_unique<CaptureStream>();
+    cs->owner = this;
+    cs->sink_input_index = sink_input_index;
+
     pa_threaded_mainloop_lock(mainloop_);
-    std::cout << "Mainloop locked" << std::endl;
+    std::cerr << "Mainloop locked" << std::endl;
 
-    // Set up source format
-    source_spec.format = PA_SAMPLE_S16LE;
-    source_spec.channels = 2;  // Default to stereo
-    source_spec.rate = 16000;  // Changed to 16kHz
-            
-    std::cout << "Source format: " << source_spec.rate << "Hz, " 
-              << source_spec.channels << " channels" << std::endl;
-            
-    // Create stream
-    stream_ = pa_stream_new(context_, "RecordStream", &source_spec, nullptr);
-    if (!stream_) {
-        pa_threaded_mainloop_unlock(mainloop_);
-        throw std::runtime_error("Failed to create stream");
-    }
-    std::cout << "Stream created" << std::endl;
-            
-    pa_stream_set_state_callback(stream_, stream_state_cb, mainloop_);
-    pa_stream_set_read_callback(stream_, stream_read_cb, this);
-            
-    // Set up buffer attributes (following OBS's approach)
-    pa_buffer_attr buffer_attr;
-    buffer_attr.maxlength = (uint32_t)-1;
-    buffer_attr.fragsize = pa_usec_to_bytes(25000, &source_spec);  // 25ms chunks
-    buffer_attr.minreq = (uint32_t)-1;
-    buffer_attr.prebuf = (uint32_t)-1;
-    buffer_attr.tlength = (uint32_t)-1;
-            
-    std::cout << "Buffer attributes set up with fragsize: " << buffer_attr.fragsize << std::endl;
-            
-    // Get the sink name for this application
-    bool found = false;
-    std::string sink_name;
-            
-    std::cout << "Getting sink info for input " << sink_input_index << std::endl;
+    // Find the sink the application plays to, then the sink's monitor source
+    // and native sample spec
+    SinkLookup sink;
+    sink.ac = this;
 
-    struct CallbackData {
-        PulseAudioCapture* ac;
-        bool* found;
-        std::string* sink_name;
-        pa_stream* stream;
+    std::cerr << "Getting sink info for input " << sink_input_index << std::endl;
+
+    auto get_sink_input_cb = [](pa_context* /*c*/, const pa_sink_input_info* i, int eol, void* userdata) {
+        auto* data = static_cast<SinkLookup*>(userdata);
+        if (!eol && i) {
+            data->found = true;
+            data->sink_index = i->sink;
+        } else if (eol < 0) {
+            std::cerr << "Error getting sink input info" << std::endl;
+        }
+        pa_threaded_mainloop_signal(data->ac->mainloop_, 0);
     };
-            
-    auto get_sink_cb = [](pa_context* /*c*/, const pa_sink_input_info* i, int eol, void* userdata) {
-        std::cout << "Sink info callback called with eol: " << eol << std::endl;
-        auto* data = static_cast<CallbackData*>(userdata);
-        
+
+    auto get_sink_cb = [](pa_context* /*c*/, const pa_sink_info* i, int eol, void* userdata) {
+        auto* data = static_cast<SinkLookup*>(userdata);
         if (!eol && i) {
-            *data->found = true;
-            *data->sink_name = i->sink;
-            std::cout << "Found sink: " << i->sink << std::endl;
+            data->sink_name = i->name ? i->name : "";
+            data->monitor_source = i->monitor_source_name ? i->monitor_source_name : "";
+            data->sample_spec = i->sample_spec;
+            data->channel_map = i->channel_map;
         } else if (eol < 0) {
-            // Error occurred
             std::cerr << "Error getting sink info" << std::endl;
         }
-        
         pa_threaded_mainloop_signal(data->ac->mainloop_, 0);
     };
-            
-    CallbackData cb_data{this, &found, &sink_name, stream_};
-            
-    pa_operation *op = pa_context_get_sink_input_info(context_, sink_input_index, get_sink_cb, &cb_data);
-    if (!op) {
-        pa_stream_disconnect(stream_);
-        pa_stream_unref(stream_);
-        stream_ = nullptr;
+
+    if (!wait_for_operation(pa_context_get_sink_input_info(context_, sink_input_index, get_sink_input_cb, &sink))
+        || !sink.found) {
         pa_threaded_mainloop_unlock(mainloop_);
-        throw std::runtime_error("Failed to get sink input info");
+        throw std::runtime_error("Failed to find sink for application");
     }
-            
-    std::cout << "Waiting for sink info operation to complete" << std::endl;
-            
-    while (pa_operation_get_state(op) == PA_OPERATION_RUNNING) {
-        pa_threaded_mainloop_wait(mainloop_);
+    if (!wait_for_operation(pa_context_get_sink_info_by_index(context_, sink.sink_index, get_sink_cb, &sink))
+        || sink.monitor_source.empty()) {
+        pa_threaded_mainloop_unlock(mainloop_);
+        throw std::runtime_error("Failed to get sink info");
     }
-    pa_operation_unref(op);
-            
-    if (!found) {
-        pa_stream_disconnect(stream_);
-        pa_stream_unref(stream_);
-        stream_ = nullptr;
+
+    std::cerr << "Found sink: " << sink.sink_name << std::endl;
+
+    // The first source of a format times the native conversion over seconds of
+    // audio; do that without the mainloop lock so sources already recording
+    // keep getting read callbacks. Only this thread touches the cost cache.
+    pa_threaded_mainloop_unlock(mainloop_);
+    const common::CaptureConfig& capture = model_config_.capture;
+    const bool native = use_native_conversion(sink.sample_spec);
+    pa_threaded_mainloop_lock(mainloop_);
+    try {
+        if (native) {
+            // Record exactly what the sink plays so the server neither resamples
+            // nor remixes; channel selection and resampling happen here
+            cs->spec.format = PA_SAMPLE_FLOAT32NE;
+            cs->spec.channels = sink.sample_spec.channels;
+            cs->spec.rate = sink.sample_spec.rate;
+            cs->converter = std::make_unique<dsp::CaptureConverter>(
+                dsp::CaptureConverter::Format::Float32, static_cast<int>(cs->spec.rate),
+                static_cast<int>(cs->spec.channels), capture.channel);
+        } else {
+            cs->spec.format = PA_SAMPLE_S16LE;
+            cs->spec.channels = 2;
+            cs->spec.rate = SAMPLE_RATE;
+            cs->converter = std::make_unique<dsp::CaptureConverter>(
+                dsp::CaptureConverter::Format::S16, SAMPLE_RATE, 2);
+        }
+    } catch (...) {
         pa_threaded_mainloop_unlock(mainloop_);
-        throw std::runtime_error("Failed to find sink for application");
+        throw;
+    }
+
+    std::cerr << "Source format: " << (native ? "float32 " : "s16 ") << cs->spec.rate << "Hz, "
+              << static_cast<int>(cs->spec.channels) << " channels" << std::endl;
+
+    // Create stream
+    std::string stream_name = "RecordStream-" + std::to_string(sink_input_index);
+    cs->stream = pa_stream_new(context_, stream_name.c_str(), &cs->spec,
+                               native ? &sink.channel_map : nullptr);
+    if (!cs->stream) {
+        pa_threaded_mainloop_unlock(mainloop_);
+        throw std::runtime_error("Failed to create stream");
+    }
+    std::cerr << "Stream created" << std::endl;
+
+    pa_stream_set_state_callback(cs->stream, stream_state_cb, mainloop_);
+    pa_stream_set_read_callback(cs->stream, stream_read_cb, cs.get());
+
+    // Set up buffer attributes (following OBS's approach)
+    pa_buffer_attr buffer_attr;
+    buffer_attr.maxlength = (uint32_t)-1;
+    buffer_attr.fragsize = pa_usec_to_bytes(25000, &cs->spec);  // 25ms chunks
+    buffer_attr.minreq = (uint32_t)-1;
+    buffer_attr.prebuf = (uint32_t)-1;
+    buffer_attr.tlength = (uint32_t)-1;
+
+    std::cerr << "Buffer attributes set up with fragsize: " << buffer_attr.fragsize << std::endl;
+
+    // Register the source with the pipeline before audio starts flowing. Read
+    // callbacks cannot run while we hold the mainloop lock.
+    if (pipeline_ && pipeline_->ready()) {
+        try {
+            cs->context = pipeline_->add_stream(sink_input_index,
+                                                pipeline_->streaming() ? nullptr : acquire_vad());
+        } catch (...) {
+            destroy_stream(*cs);
+            pa_threaded_mainloop_unlock(mainloop_);
+            throw;
+        }
     }
             
-    std::cout << "Found sink: " << sink_name << std::endl;
-            
-    // Connect to the monitor source of the sink
-    std::string monitor_source = sink_name + ".monitor";
-    std::cout << "Connecting to monitor source: " << monitor_source << std::endl;
-            
-    if (pa_stream_connect_record(stream_, monitor_source.c_str(), &buffer_attr,
-        static_cast<pa_stream_flags_t>(PA_STREAM_ADJUST_LATENCY | PA_STREAM_AUTO_TIMING_UPDATE)) < 0) {
-        pa_stream_disconnect(stream_);
-        pa_stream_unref(stream_);
-        stream_ = nullptr;
+    // Connect to the monitor source of the sink, limited to this sink input so
+    // other applications playing to the same sink are not recorded with it
+    std::cerr << "Connecting to monitor source: " << sink.monitor_source << std::endl;
+
+    if (pa_stream_set_monitor_stream(cs->stream, sink_input_index) < 0
+        || pa_stream_connect_record(cs->stream, sink.monitor_source.c_str(), &buffer_attr,
+            static_cast<pa_stream_flags_t>(PA_STREAM_ADJUST_LATENCY | PA_STREAM_AUTO_TIMING_UPDATE
+                                           | PA_STREAM_DONT_MOVE)) < 0) {
+        destroy_stream(*cs);
         pa_threaded_mainloop_unlock(mainloop_);
+        if (cs->context) {
+            pipeline_->remove_stream(cs->context);
+        }
         throw std::runtime_error("Failed to connect stream");
     }
             
-    std::cout << "Stream connected successfully" << std::endl;
+    std::cerr << "Stream connected successfully" << std::endl;
             
+    // Start the worker stages before audio starts flowing; no-op if already running
+    if (cs->context) {
+        pipeline_->start();
+    }
+
+    streams_[sink_input_index] = std::move(cs);
     pa_threaded_mainloop_unlock(mainloop_);
     is_recording = true;
             
-    // Clear any existing audio data
-    audio_buffer.clear();
-    std::cout << "Recording started" << std::endl;
+    std::cerr << "Recording started" << std::endl;
     
     return true;  // Return success
 }
 
+void PulseAudioCapture::stop_recording_application(uint32_t sink_input_index) {
+    auto it = streams_.find(sink_input_index);
+    if (it == streams_.end()) {
+        return;
+    }
+
+    pa_threaded_mainloop_lock(mainloop_);
+    destroy_stream(*it->second);
+    pa_threaded_mainloop_unlock(mainloop_);
+
+    // Buffered audio of this source is still recognized and printed
+    if (it->second->context) {
+        pipeline_->remove_stream(it->second->context);
+    }
+    streams_.erase(it);
+}
+
 void PulseAudioCapture::stop_recording() {
     is_recording = false;
-    if (stream_) {
-        pa_threaded_mainloop_lock(mainloop_);
-        pa_stream_disconnect(stream_);
-        pa_stream_unref(stream_);
-        stream_ = nullptr;
-        pa_threaded_mainloop_unlock(mainloop_);
+    while (!streams_.empty()) {
+        stop_recording_application(streams_.begin()->first);
+    }
+
+    // Drain the remaining audio through VAD, ASR and translation
+    if (pipeline_) {
+        pipeline_->stop();
     }
 }
 
-} // namespace linux_pulse 
\ No newline at end of file
+} // namespace linux_pulse
@@ -2,14 +2,20 @@
 
 #include <pulse/pulseaudio.h>
 #include <pulse/thread-mainloop.h>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 #include <audio/audio_capture.h>
 #include <audio/audio_format.h>
+#include <audio/dsp/capture_converter.h>
 #include <common/model_config.h>
+#include <metrics/metrics.h>
 #include "sherpa-onnx/c-api/c-api.h"
 #include "translator/translator.h"
+#include "pipeline/recognition_pipeline.h"
 namespace linux_pulse {
 
 class PulseAudioCapture : public audio::IAudioCapture {
@@ -21,45 +27,72 @@ public:
     // IAudioCapture interface implementation
     bool initialize() override;
     bool start_recording_application(uint32_t app_id) override;
+    void stop_recording_application(uint32_t app_id) override;
     void stop_recording() override;
     void list_applications() override;
+    std::map<uint32_t, std::string> get_applications() override;
+    std::vector<uint32_t> recording_applications() const override;
     void set_model_recognizer(const SherpaOnnxOfflineRecognizer* recognizer) override;
     void set_model_vad(SherpaOnnxVoiceActivityDetector* vad, const int window_size) override;
+    void set_model_online_recognizer(const SherpaOnnxOnlineRecognizer* recognizer,
+                                     const common::StreamingConfig& config) override;
     void set_translate(const translator::ITranslator* translate) override;
+    void set_model_config(const common::ModelConfig& config) override;
+    void set_output(std::shared_ptr<output::OutputWriter> output) override;
+    pipeline::PipelineStats get_pipeline_stats() const override;
 
 private:
+    // One recorded sink input. Each has its own PulseAudio stream, conversion
+    // buffer and pipeline context (ring buffer + VAD state).
+    struct CaptureStream {
+        PulseAudioCapture* owner = nullptr;
+        uint32_t sink_input_index = 0;
+        pa_stream* stream = nullptr;
+        pa_sample_spec spec{};  // Negotiated with the sink, see CaptureConfig::conversion
+        // Mixes, resamples and converts to 16 kHz mono S16; keeps filter state across callbacks
+        std::unique_ptr<dsp::CaptureConverter> converter;
+        std::shared_ptr<pipeline::StreamContext> context;
+    };
+
+    // Result of looking up the sink a sink input plays to
+    struct SinkLookup {
+        PulseAudioCapture* ac = nullptr;
+        bool found = false;
+        uint32_t sink_index = PA_INVALID_INDEX;
+        std::string sink_name;
+        std::string monitor_source;
+        pa_sample_spec sample_spec{};
+        pa_channel_map channel_map{};
+    };
+
     // PulseAudio members
     pa_threaded_mainloop* mainloop_; // PulseAudio main loop
     pa_context* context_; // PulseAudio context
-    pa_stream* stream_; // PulseAudio stream
+    std::map<uint32_t, std::unique_ptr<CaptureStream>> streams_; // Recorded sink inputs by index
     std::string app_name; // Name of the application to record
-    bool is_recording; // Flag to indicate if recording is active
-    std::vector<int16_t> audio_buffer;  // Buffer for audio data
-    
-
-
-    // Speech recognition members
-    // const SherpaOnnxOfflineRecognizer* recognizer_;
-    // const SherpaOnnxOfflineStream* recognition_stream_;
-    // SherpaOnnxVoiceActivityDetector* vad_;
-    // std::mutex recognition_mutex_;
-    // bool recognition_enabled_;
-    std::vector<float> remaining_samples_;  // Buffer for remaining samples between VAD windows
-    
+    std::atomic<bool> is_recording; // Flag to indicate if recording is active
+
     std::map<std::string, std::string> available_sources;
     std::map<uint32_t, std::string> available_applications_;
 
-    // Speech recognition members
-    const SherpaOnnxOfflineRecognizer* recognizer_;
-    const SherpaOnnxOfflineStream* recognition_stream_;
-    SherpaOnnxVoiceActivityDetector* vad_;
-    int window_size_;
-    std::mutex recognition_mutex_;
-    bool recognition_enabled_;
+    // Measured native conversion cost in percent of one core, keyed by rate and channel count
+    std::map<std::pair<uint32_t, uint8_t>, double> native_conversion_cost_;
 
+    // Used to create a VAD for every additional source
+    common::ModelConfig model_config_;
+    bool has_model_config_;
+    // Given to the pipeline when it is created, see set_output
+    std::shared_ptr<output::OutputWriter> output_;
+    // VAD passed to set_model_vad; lent to one source at a time
+    SherpaOnnxVoiceActivityDetector* default_vad_;
+    std::atomic<bool> default_vad_in_use_;
+
+    // Process-wide capture metrics, updated in stream_read_cb
+    metrics::Counter& captured_bytes_;
+    metrics::Counter& audio_holes_;
+    metrics::Counter& audio_hole_bytes_;
+    metrics::Counter& read_errors_;
 
-    // translate
-    const translator::ITranslator* translate_;
     // Audio format settings
     audio::AudioFormat format_;
     pa_sample_spec source_spec_;
@@ -69,23 +102,29 @@ private:
     static constexpr int CHANNELS = 1;         // Mono for speech recognition
     static constexpr int BITS_PER_SAMPLE = 16; // S16LE format
 
-    // Resampling state
-    pa_sample_spec source_spec;
-    pa_sample_spec target_spec;
-
-
     // Callback functions
     static void context_state_cb(pa_context* c, void* userdata);
     static void stream_state_cb(pa_stream* s, void* userdata);
     static void stream_read_cb(pa_stream* s, size_t length, void* userdata);
     static void sink_input_info_cb(pa_context* c, const pa_sink_input_info* i, int eol, void* userdata);
 
-    // process_audio_for_recognition
-    void process_audio_for_recognition(const std::vector<int16_t>& audio_data);
+    // Whether to record a sink with this sample spec natively and convert in
+    // process, per CaptureConfig::conversion; measures the cost once per format.
+    // Call without the mainloop lock: the measurement takes a while.
+    bool use_native_conversion(const pa_sample_spec& sink_spec);
+
+    // Lazily creates the pipeline so set_model_config can still take effect
+    pipeline::RecognitionPipeline& get_pipeline();
+    pipeline::VadPtr acquire_vad();
 
     // Helper functions
     void cleanup();
+    void destroy_stream(CaptureStream& cs);
     bool wait_for_operation(pa_operation* op);
+
+    // Speech recognition runs on the pipeline's worker threads, never in stream_read_cb.
+    // Declared last so it is drained before the members its VAD deleters touch.
+    std::unique_ptr<pipeline::RecognitionPipeline> pipeline_;
 };
 
 } // namespace voice 
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "audio/sources/file_audio_source.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace audio {
+
+namespace {
+
+constexpr uint16_t kWaveFormatPcm = 1;
+constexpr uint16_t kWaveFormatFloat = 3;
+constexpr uint16_t kWaveFormatExtensible = 0xFFFE;
+
+uint16_t read_u16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t read_u32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+        | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+bool read_exact(FILE* file, void* out, size_t n) {
+    return std::fread(out, 1, n, file) == n;
+}
+
+// Reads and discards instead of seeking, so pipes and FIFOs work too
+bool skip_exact(FILE* file, uint64_t n) {
+    char buffer[4096];
+    while (n > 0) {
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(n, sizeof(buffer)));
+        if (!read_exact(file, buffer, chunk)) {
+            return false;
+        }
+        n -= chunk;
+    }
+    return true;
+}
+
+} // namespace
+
+FileAudioSource::FileAudioSource(const std::string& path, Format format)
+    : path_(path)
+    , file_(nullptr)
+    , owns_file_(false)
+    , channels_(1)
+    , bits_per_sample_(16)
+    , is_float_(false)
+    , data_remaining_(std::numeric_limits<uint64_t>::max()) {
+    if (path.empty()) {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        file_ = stdin;
+    } else {
+        file_ = std::fopen(path.c_str(), "rb");
+        if (!file_) {
+            throw std::runtime_error("Failed to open audio file: " + path);
+        }
+        owns_file_ = true;
+    }
+
+    if (format == Format::Wav) {
+        try {
+            parse_wav_header();
+        } catch (...) {
+            if (owns_file_) {
+                std::fclose(file_);
+            }
+            throw;
+        }
+    }
+}
+
+FileAudioSource::~FileAudioSource() {
+    if (owns_file_ && file_) {
+        std::fclose(file_);
+    }
+}
+
+std::string FileAudioSource::name() const {
+    return path_.empty() ? "stdin" : path_;
+}
+
+void FileAudioSource::parse_wav_header() {
+    unsigned char header[12];
+    if (!read_exact(file_, header, sizeof(header))
+        || std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 8, "WAVE", 4) != 0) {
+        throw std::runtime_error("Not a WAV file: " + path_);
+    }
+
+    bool have_format = false;
+    while (true) {
+        unsigned char chunk[8];
+        if (!read_exact(file_, chunk, sizeof(chunk))) {
+            throw std::runtime_error("WAV file has no data chunk: " + path_);
+        }
+        const uint32_t size = read_u32(chunk + 4);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            std::vector<unsigned char> fmt(size);
+            if (size < 16 || !read_exact(file_, fmt.data(), size)) {
+                throw std::runtime_error("Invalid WAV format chunk: " + path_);
+            }
+            uint16_t format_tag = read_u16(&fmt[0]);
+            channels_ = read_u16(&fmt[2]);
+            const uint32_t sample_rate = read_u32(&fmt[4]);
+            bits_per_sample_ = read_u16(&fmt[14]);
+            if (format_tag == kWaveFormatExtensible && size >= 26) {
+                format_tag = read_u16(&fmt[24]);  // First bytes of the sub-format GUID
+            }
+
+            if (format_tag == kWaveFormatPcm && bits_per_sample_ == 16) {
+                is_float_ = false;
+            } else if (format_tag == kWaveFormatFloat && bits_per_sample_ == 32) {
+                is_float_ = true;
+            } else {
+                throw std::runtime_error("Unsupported WAV encoding (need PCM16 or float32): " + path_);
+            }
+            if (channels_ <= 0) {
+                throw std::runtime_error("Invalid WAV channel count: " + path_);
+            }
+            if (static_cast<int>(sample_rate) != SAMPLE_RATE) {
+                throw std::runtime_error("Unsupported WAV sample rate " + std::to_string(sample_rate)
+                                         + " Hz, expected 16000 Hz: " + path_);
+            }
+            if (size % 2) {
+                std::fgetc(file_);
+            }
+            have_format = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!have_format) {
+                throw std::runtime_error("WAV data chunk before format chunk: " + path_);
+            }
+            // Streamed WAVs may carry a placeholder size; read to end of file then
+            if (size != 0 && size != 0xFFFFFFFFu) {
+                data_remaining_ = size;
+            }
+            return;
+        } else {
+            // Skip chunks we do not need (LIST, fact, ...), including the pad byte
+            if (!skip_exact(file_, static_cast<uint64_t>(size) + (size % 2))) {
+                throw std::runtime_error("Truncated WAV file: " + path_);
+            }
+        }
+    }
+}
+
+size_t FileAudioSource::read(int16_t* out, size_t max_samples) {
+    const size_t frame_bytes = static_cast<size_t>(channels_) * (bits_per_sample_ / 8);
+    const size_t frames = static_cast<size_t>(std::min<uint64_t>(max_samples, data_remaining_ / frame_bytes));
+    if (frames == 0) {
+        return 0;
+    }
+
+    frame_buffer_.resize(frames * frame_bytes);
+    const size_t bytes_read = std::fread(frame_buffer_.data(), 1, frame_buffer_.size(), file_);
+    const size_t frames_read = bytes_read / frame_bytes;
+    if (frames_read < frames) {
+        data_remaining_ = 0;  // End of file or read error
+    } else if (data_remaining_ != std::numeric_limits<uint64_t>::max()) {
+        data_remaining_ -= bytes_read;
+    }
+
+    const auto* bytes = reinterpret_cast<const unsigned char*>(frame_buffer_.data());
+    for (size_t i = 0; i < frames_read; ++i, bytes += frame_bytes) {
+        if (channels_ == 1 && !is_float_) {
+            out[i] = static_cast<int16_t>(read_u16(bytes));
+            continue;
+        }
+        float sum = 0.0f;
+        for (int c = 0; c < channels_; ++c) {
+            if (is_float_) {
+                uint32_t bits = read_u32(bytes + c * 4);
+                float value;
+                std::memcpy(&value, &bits, sizeof(value));
+                sum += value * 32768.0f;
+            } else {
+                sum += static_cast<int16_t>(read_u16(bytes + c * 2));
+            }
+        }
+        const float mono = sum / channels_;
+        out[i] = static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, mono)));
+    }
+    return frames_read;
+}
+
+} // namespace audio
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <audio/audio_source.h>
+
+namespace audio {
+
+// Streams a WAV file (PCM16 or IEEE float32, any channel count, downmixed to
+// mono), or headerless s16le mono PCM from a file or stdin. Input must be
+// 16 kHz; other WAV rates are rejected when the file is opened.
+class FileAudioSource : public IAudioSource {
+public:
+    enum class Format { Wav, Raw };
+
+    // An empty path reads from stdin, which is always raw
+    FileAudioSource(const std::string& path, Format format);
+    ~FileAudioSource() override;
+
+    std::string name() const override;
+    size_t read(int16_t* out, size_t max_samples) override;
+
+private:
+    void parse_wav_header();
+
+    std::string path_;
+    FILE* file_;
+    bool owns_file_;
+
+    int channels_;
+    int bits_per_sample_;
+    bool is_float_;
+    uint64_t data_remaining_;  // Bytes left in the WAV data chunk
+    std::vector<char> frame_buffer_;  // Raw bytes of the current read
+};
+
+} // namespace audio
@@ -0,0 +1,75 @@
+#include "audio/sources/synthetic_audio_source.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace audio {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kSyllableHz = 4.0;  // Typical speech syllable rate
+constexpr double kAmplitude = 6000.0;
+
+} // namespace
+
+SyntheticAudioSource::SyntheticAudioSource(double seconds, uint32_t seed)
+    : total_samples_(static_cast<uint64_t>(seconds * SAMPLE_RATE))
+    , position_(0)
+    , rng_(seed)
+    , speaking_(false)
+    , phase_remaining_(0)
+    , pitch_hz_(150.0)
+    , phase_(0.0) {
+}
+
+std::string SyntheticAudioSource::name() const {
+    std::ostringstream name;
+    name << "synth:" << total_samples_ / static_cast<double>(SAMPLE_RATE);
+    return name.str();
+}
+
+void SyntheticAudioSource::next_phrase() {
+    speaking_ = !speaking_;
+    if (speaking_) {
+        // 1-6 s phrases at a voice-like pitch
+        std::uniform_real_distribution<double> length(1.0, 6.0);
+        std::uniform_real_distribution<double> pitch(100.0, 250.0);
+        phase_remaining_ = static_cast<uint64_t>(length(rng_) * SAMPLE_RATE);
+        pitch_hz_ = pitch(rng_);
+    } else {
+        // Pauses well above the default VAD min_silence_duration
+        std::uniform_real_distribution<double> length(0.6, 2.0);
+        phase_remaining_ = static_cast<uint64_t>(length(rng_) * SAMPLE_RATE);
+    }
+}
+
+size_t SyntheticAudioSource::read(int16_t* out, size_t max_samples) {
+    size_t produced = 0;
+    std::normal_distribution<double> noise(0.0, 30.0);
+
+    while (produced < max_samples && position_ < total_samples_) {
+        if (phase_remaining_ == 0) {
+            next_phrase();
+        }
+
+        double sample = noise(rng_);
+        if (speaking_) {
+            const double t = position_ / static_cast<double>(SAMPLE_RATE);
+            const double envelope = 0.5 - 0.5 * std::cos(2.0 * kPi * kSyllableHz * t);
+            phase_ += 2.0 * kPi * pitch_hz_ / SAMPLE_RATE;
+            if (phase_ > 2.0 * kPi) {
+                phase_ -= 2.0 * kPi;
+            }
+            sample += kAmplitude * envelope
+                * (0.6 * std::sin(phase_) + 0.3 * std::sin(2.0 * phase_) + 0.1 * std::sin(3.0 * phase_));
+        }
+
+        out[produced++] = static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, sample)));
+        ++position_;
+        --phase_remaining_;
+    }
+    return produced;
+}
+
+} // namespace audio
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <audio/audio_source.h>
+
+namespace audio {
+
+// Generates speech-like input for load tests: bursts of a few harmonics with
+// a syllable-rate envelope, separated by pauses long enough for the VAD to
+// close a segment. Deterministic for a given seed.
+class SyntheticAudioSource : public IAudioSource {
+public:
+    explicit SyntheticAudioSource(double seconds, uint32_t seed = 1);
+
+    std::string name() const override;
+    size_t read(int16_t* out, size_t max_samples) override;
+
+private:
+    void next_phrase();
+
+    const uint64_t total_samples_;
+    uint64_t position_;
+
+    std::mt19937 rng_;
+    bool speaking_;
+    uint64_t phase_remaining_;  // Samples left in the current burst or pause
+    double pitch_hz_;
+    double phase_;
+};
+
+} // namespace audio
@@ -9,6 +9,8 @@
 #include <audioclient.h>
 #include <ksmedia.h>
 #include <sherpa-onnx/c-api/c-api.h>
+#include <audio/dsp/sample_kernels.h>
+#include <trace/trace.h>
 
 namespace windows_audio {
 
@@ -550,14 +552,13 @@ void WasapiCapture::process_captured_data(const BYTE* buffer, UINT32 frames) {
 
 void WasapiCapture::process_audio_for_recognition(const std::vector<int16_t>& audio_data) {
     if (!recognition_enabled_ || !vad_) return;
+    trace::Span span("process_audio_for_recognition", "capture");
 
     std::lock_guard<std::mutex> lock(recognition_mutex_);
 
     // Convert to float samples
     std::vector<float> float_samples(audio_data.size());
-    for (size_t i = 0; i < audio_data.size(); ++i) {
-        float_samples[i] = audio_data[i] / 32768.0f;
-    }
+    dsp::kernels().s16_to_float(audio_data.data(), float_samples.data(), audio_data.size(), dsp::kS16ToFloat);
 
     // If we have remaining samples from last batch, prepend them
     if (!remaining_samples_.empty()) {
@@ -0,0 +1,24 @@
+#include "common/allocation_counter.h"
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions of the executable so
+// common::thread_allocation_count() sees every allocation, including those
+// made by code in the audio_capture library. The array and nothrow forms
+// forward to these by default.
+
+void* operator new(std::size_t size) {
+    ++common::thread_allocation_count();
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace common {
+
+// Heap allocations made by the calling thread so far. Incremented by the
+// operator new replacement in allocation_counter.cpp; binaries that do not
+// link it (or a counter of their own) always read 0.
+inline uint64_t& thread_allocation_count() {
+    static thread_local uint64_t count = 0;
+    return count;
+}
+
+// Adds the allocations the current thread makes during the scope to total.
+// Used to prove that hot paths such as the capture callback stay allocation-free.
+class AllocationScope {
+public:
+    explicit AllocationScope(std::atomic<uint64_t>& total)
+        : total_(total)
+        , start_(thread_allocation_count()) {}
+
+    ~AllocationScope() {
+        const uint64_t made = thread_allocation_count() - start_;
+        if (made != 0) {
+            total_.fetch_add(made, std::memory_order_relaxed);
+        }
+    }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+private:
+    std::atomic<uint64_t>& total_;
+    const uint64_t start_;
+};
+
+} // namespace common
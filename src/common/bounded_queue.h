@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <vector>
+#include <mutex>
+
+namespace common {
+
+// Bounded multi-producer/multi-consumer queue connecting pipeline stages.
+// try_push() never blocks: when the queue is full the item is dropped and counted,
+// so a slow downstream stage cannot stall the real-time side of the pipeline.
+// push() applies backpressure instead, for stages that must not lose items.
+// Slots are allocated once up front, so steady-state traffic does not touch the heap.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity)
+        : capacity_(capacity == 0 ? 1 : capacity)
+        , slots_(capacity_) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Returns false if the item was dropped because the queue is full or closed
+    bool try_push(T item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_ || count_ >= capacity_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            put(std::move(item));
+        }
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+        cv_.notify_one();
+        return true;
+    }
+
+    // Blocks while the queue is full. Returns false if the queue was closed.
+    bool push(T item) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_full_cv_.wait(lock, [this] { return closed_ || count_ < capacity_; });
+            if (closed_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            put(std::move(item));
+        }
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+        cv_.notify_one();
+        return true;
+    }
+
+    // Blocks until an item is available. Returns false once the queue is closed and drained.
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return closed_ || count_ > 0; });
+        if (count_ == 0) {
+            return false;
+        }
+        take(item);
+        lock.unlock();
+        not_full_cv_.notify_one();
+        return true;
+    }
+
+    // Like pop(), but gives up at the deadline. Returns false on timeout or once closed and drained.
+    bool pop_until(T& item, std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!cv_.wait_until(lock, deadline, [this] { return closed_ || count_ > 0; })) {
+            return false;
+        }
+        if (count_ == 0) {
+            return false;
+        }
+        take(item);
+        lock.unlock();
+        not_full_cv_.notify_one();
+        return true;
+    }
+
+    // Wakes all consumers; remaining items can still be popped
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+        not_full_cv_.notify_all();
+    }
+
+    // Re-opens a closed queue so the owning pipeline can be restarted
+    void reopen() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = false;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+    size_t capacity() const { return capacity_; }
+    uint64_t pushed() const { return pushed_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    // Callers hold mutex_
+    void put(T&& item) {
+        slots_[(head_ + count_) % capacity_] = std::move(item);
+        ++count_;
+    }
+
+    void take(T& item) {
+        item = std::move(slots_[head_]);
+        head_ = (head_ + 1) % capacity_;
+        --count_;
+    }
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable not_full_cv_;
+    std::vector<T> slots_;  // Ring of capacity_ slots
+    size_t head_ = 0;
+    size_t count_ = 0;
+    bool closed_ = false;
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+} // namespace common
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace common {
+
+// Free list of reusable sample buffers. Buffers keep their capacity across
+// uses and grow in powers of two, so once the pool has seen the longest
+// segments no further heap allocations are made. At most max_buffers are
+// kept; extra buffers released beyond that are freed.
+template <typename T>
+class BufferPool {
+public:
+    BufferPool(size_t max_buffers, size_t min_capacity)
+        : max_buffers_(max_buffers)
+        , min_capacity_(min_capacity)
+        , allocations_(0) {
+        free_.reserve(max_buffers_);
+    }
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Returns an empty buffer with room for at least capacity elements
+    std::vector<T> acquire(size_t capacity) {
+        std::vector<T> buffer;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                buffer = std::move(free_.back());
+                free_.pop_back();
+            }
+        }
+        if (buffer.capacity() < capacity) {
+            size_t rounded = min_capacity_ == 0 ? 1 : min_capacity_;
+            while (rounded < capacity) {
+                rounded *= 2;
+            }
+            buffer.reserve(rounded);
+            allocations_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return buffer;
+    }
+
+    void release(std::vector<T>&& buffer) {
+        if (buffer.capacity() == 0) {
+            return;
+        }
+        buffer.clear();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < max_buffers_) {
+            free_.push_back(std::move(buffer));
+        }
+    }
+
+    // Buffers allocated or grown by acquire()
+    uint64_t allocations() const { return allocations_.load(std::memory_order_relaxed); }
+
+private:
+    const size_t max_buffers_;
+    const size_t min_capacity_;
+    std::mutex mutex_;
+    std::vector<std::vector<T>> free_;
+    std::atomic<uint64_t> allocations_;
+};
+
+} // namespace common
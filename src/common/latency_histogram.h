@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace common {
+
+struct LatencySummary {
+    uint64_t count = 0;
+    double mean_ms = 0.0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+};
+
+// Lock-free latency histogram with log-linear buckets: every power of two is
+// split into kSubBuckets linear buckets, so percentiles are accurate to about
+// 12% from 1 us up to days. record() is a few relaxed atomic adds and is safe
+// to call from any thread, including the hot path.
+class LatencyHistogram {
+public:
+    LatencyHistogram() {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(std::chrono::steady_clock::duration elapsed) {
+        const int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        record_us(us < 0 ? 0 : static_cast<uint64_t>(us));
+    }
+
+    void record_us(uint64_t us) {
+        buckets_[bucket_index(us)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_us_.fetch_add(us, std::memory_order_relaxed);
+        uint64_t max = max_us_.load(std::memory_order_relaxed);
+        while (us > max && !max_us_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Reads the counters without stopping writers; a summary taken while
+    // samples are being recorded may be off by the samples in flight
+    LatencySummary summary() const {
+        std::array<uint64_t, kNumBuckets> counts;
+        uint64_t total = 0;
+        for (size_t i = 0; i < kNumBuckets; ++i) {
+            counts[i] = buckets_[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+
+        LatencySummary summary;
+        summary.count = total;
+        if (total == 0) {
+            return summary;
+        }
+        summary.mean_ms = sum_us_.load(std::memory_order_relaxed) / 1000.0 / count_.load(std::memory_order_relaxed);
+        summary.max_ms = max_us_.load(std::memory_order_relaxed) / 1000.0;
+        summary.p50_ms = percentile(counts, total, 0.50);
+        summary.p95_ms = percentile(counts, total, 0.95);
+        summary.p99_ms = percentile(counts, total, 0.99);
+        return summary;
+    }
+
+private:
+    static constexpr size_t kSubBucketBits = 3;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static constexpr size_t kNumBuckets = 64 * kSubBuckets;
+
+    static size_t bucket_index(uint64_t us) {
+        if (us < kSubBuckets) {
+            return static_cast<size_t>(us);
+        }
+        size_t msb = 63;
+        while (!(us >> msb)) {
+            --msb;
+        }
+        const size_t shift = msb - kSubBucketBits;
+        const size_t sub = static_cast<size_t>((us >> shift) & (kSubBuckets - 1));
+        return (msb - kSubBucketBits + 1) * kSubBuckets + sub;
+    }
+
+    // Midpoint of the bucket, in microseconds
+    static double bucket_value(size_t index) {
+        if (index < kSubBuckets) {
+            return static_cast<double>(index);
+        }
+        const size_t shift = index / kSubBuckets - 1;
+        const uint64_t low = static_cast<uint64_t>(kSubBuckets + index % kSubBuckets) << shift;
+        return low + ((uint64_t(1) << shift) - 1) / 2.0;
+    }
+
+    static double percentile(const std::array<uint64_t, kNumBuckets>& counts, uint64_t total, double q) {
+        const uint64_t rank = static_cast<uint64_t>(q * (total - 1));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kNumBuckets; ++i) {
+            seen += counts[i];
+            if (seen > rank) {
+                return bucket_value(i) / 1000.0;
+            }
+        }
+        return bucket_value(kNumBuckets - 1) / 1000.0;
+    }
+
+    std::array<std::atomic<uint64_t>, kNumBuckets> buckets_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_us_{0};
+    std::atomic<uint64_t> max_us_{0};
+};
+
+} // namespace common
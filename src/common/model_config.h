@@ -21,6 +21,8 @@ struct WhisperConfig {
     int language_detection_num_threads = 1;
     std::string language_detection_provider = "cpu";
     bool language_detection_debug = false;
+    int language_detection_recheck_interval_ms = 30000;  // Re-detect a stream's language this often; 0 detects once
+    int language_detection_queue_capacity = 16;           // Segments waiting for detection; extra ones reuse the cached result
 };
 
 struct SenseVoiceConfig {
@@ -31,6 +33,23 @@ struct SenseVoiceConfig {
     bool use_itn = true;
 };
 
+// Online (streaming) models decode audio as it arrives and detect utterance
+// endpoints themselves, so no VAD is needed
+struct StreamingConfig {
+    std::string model_type = "transducer";  // "transducer" or "paraformer"
+    std::string encoder_path;
+    std::string decoder_path;
+    std::string joiner_path;  // Transducer only
+    std::string tokens_path;
+    std::string decoding_method = "greedy_search";  // "greedy_search" or "modified_beam_search" (transducer only)
+    std::string language;  // Spoken language, e.g. "en", used as the translation source; empty disables translation
+    int partial_interval_ms = 200;  // Emit the current hypothesis every this many ms of audio; 0 disables partials
+    // Endpoint rules: trailing silence before any text, trailing silence after text, longest utterance (seconds)
+    float rule1_min_trailing_silence = 2.4f;
+    float rule2_min_trailing_silence = 1.2f;
+    float rule3_min_utterance_length = 20.0f;
+};
+
 struct VadConfig {
     std::string model_path;
     float threshold = 0.3;
@@ -48,10 +67,81 @@ struct DeepLXConfig {
     std::string token;
     std::string target_lang = "ZH";  // Default target language is Chinese
     bool enabled = false;  // Whether translation is enabled
+    int max_concurrent_requests = 4;  // Translations in flight at once
+    int timeout_ms = 3000;  // Per-request timeout, including retries
+    int connect_timeout_ms = 1000;  // Per connection attempt
+    int max_retries = 2;  // Further attempts after a connection error or a 429/5xx answer
+    int retry_backoff_ms = 200;  // Before the first retry, doubling with each further one
+    int dns_cache_seconds = 300;  // How long resolved host names are reused
+    int batch_size = 8;  // Maximum texts sent in one request (1 = never batch)
+    int batch_delay_ms = 0;  // How long a text may wait for others to batch with (0 = only batch what is queued)
+    int batch_max_chars = 1500;  // Maximum combined text length of a batch
+};
+
+struct MockTranslatorConfig {
+    bool enabled = false;  // Translate with an in-process stand-in instead of DeepLX, e.g. for load tests
+    std::string target_lang = "ZH";
+    int latency_ms = 100;  // Time every translation takes
+    int latency_jitter_ms = 0;  // Random extra time, up to this much
+    float error_rate = 0.0f;  // Share of translations that fail (0..1)
+};
+
+struct TranslationCacheConfig {
+    bool enabled = true;
+    int max_memory_mb = 16;  // Recently used translations kept in memory
+    std::string disk_path;   // Memory-mapped file that keeps translations across restarts; empty = memory only
+    int disk_max_mb = 64;    // Size of the file; the oldest translations are dropped when it fills up
+};
+
+struct PipelineConfig {
+    float ring_buffer_seconds = 10.0f;  // PCM buffered between the capture callback and VAD
+    int segment_queue_capacity = 32;    // Speech segments waiting for decoding
+    int result_queue_capacity = 64;     // Recognition results waiting for translation
+    int decode_batch_size = 8;          // Maximum segments decoded in one recognizer call
+    int decode_batch_delay_ms = 0;      // How long a batch may wait for more segments; 0 adds no latency
+    int vad_threads = 1;                // VAD workers shared round-robin by all capture sources
+    int decode_threads = 1;             // Decode workers sharing one recognizer
+    int latency_report_interval_ms = 0; // Periodically print per-stage latency percentiles; 0 disables
+    // Offline models only: re-decode speech the VAD has not closed yet this
+    // often (audio time) and show it as partial text; 0 disables
+    int early_decode_interval_ms = 0;
+    float early_decode_budget_percent = 25.0f;  // Share of decode worker time early decodes may use
+};
+
+struct CaptureConfig {
+    // Where captured audio is converted to 16 kHz mono:
+    //   "native": record float32 at the sink's own rate and channels, convert here
+    //   "server": let PulseAudio resample to 16 kHz S16 stereo
+    //   "auto":   native while its cost, measured once per sink format on this host, fits the budget below
+    std::string conversion = "auto";
+    int channel = -1;                     // Native conversion only: channel to keep; -1 mixes all channels
+    float native_max_cpu_percent = 0.5f;  // "auto" budget per stream, in percent of one core
+};
+
+struct OutputConfig {
+    std::string format = "text";  // "text", "jsonl", "srt" or "vtt"
+    // Empty writes to stdout; "unix:<path>" serves every client connecting to a
+    // Unix domain socket at path; anything else is a file, replaced on start
+    std::string destination;
+    int queue_capacity = 1024;    // Results waiting for the writer thread
+    bool partial_results = true;  // Also write partial results; subtitle formats never do
+};
+
+struct IngestConfig {
+    std::string bind_address = "127.0.0.1";
+    int tcp_port = 0;        // Framed PCM over plain TCP; 0 disables
+    int websocket_port = 0;  // The same audio over WebSocket; 0 disables
+    int threads = 0;         // Event loops, each with its own share of connections; 0 = one per core
+    int max_connections = 256;
+};
+
+struct MetricsConfig {
+    std::string bind_address = "127.0.0.1";
+    int port = 0;  // Prometheus text format on GET /metrics; 0 disables
 };
 
 struct ModelConfig {
-    std::string type;  // "sense_voice" or "whisper"
+    std::string type;  // "sense_voice", "whisper" or "streaming"
     std::string provider = "cpu";
     int num_threads = 4;
     bool debug = false;
@@ -59,8 +149,16 @@ struct ModelConfig {
     // Model specific configurations
     WhisperConfig whisper;
     SenseVoiceConfig sense_voice;
+    StreamingConfig streaming;
     VadConfig vad;
     DeepLXConfig deeplx;  // Add DeepLX configuration
+    MockTranslatorConfig mock_translator;
+    TranslationCacheConfig translation_cache;
+    PipelineConfig pipeline;
+    CaptureConfig capture;
+    OutputConfig output;
+    IngestConfig ingest;
+    MetricsConfig metrics;
 
     // Load configuration from YAML file
     static ModelConfig LoadFromFile(const std::string& config_path) {
@@ -106,22 +204,44 @@ struct ModelConfig {
                         whisper_config["language_detection_provider"].as<std::string>("cpu");
                     model_config.whisper.language_detection_debug = 
                         whisper_config["language_detection_debug"].as<bool>(false);
+                    model_config.whisper.language_detection_recheck_interval_ms =
+                        whisper_config["language_detection_recheck_interval_ms"].as<int>(30000);
+                    model_config.whisper.language_detection_queue_capacity =
+                        whisper_config["language_detection_queue_capacity"].as<int>(16);
                 }
+            } else if (model_config.type == "streaming") {
+                auto streaming_config = config["model"]["streaming"];
+                model_config.streaming.model_type = streaming_config["model_type"].as<std::string>("transducer");
+                model_config.streaming.encoder_path = streaming_config["encoder_path"].as<std::string>();
+                model_config.streaming.decoder_path = streaming_config["decoder_path"].as<std::string>();
+                model_config.streaming.joiner_path = streaming_config["joiner_path"].as<std::string>("");
+                model_config.streaming.tokens_path = streaming_config["tokens_path"].as<std::string>();
+                model_config.streaming.decoding_method = streaming_config["decoding_method"].as<std::string>("greedy_search");
+                model_config.streaming.language = streaming_config["language"].as<std::string>("");
+                model_config.streaming.partial_interval_ms = streaming_config["partial_interval_ms"].as<int>(200);
+                model_config.streaming.rule1_min_trailing_silence =
+                    streaming_config["rule1_min_trailing_silence"].as<float>(2.4f);
+                model_config.streaming.rule2_min_trailing_silence =
+                    streaming_config["rule2_min_trailing_silence"].as<float>(1.2f);
+                model_config.streaming.rule3_min_utterance_length =
+                    streaming_config["rule3_min_utterance_length"].as<float>(20.0f);
             } else {
                 throw std::runtime_error("Unsupported model type: " + model_config.type);
             }
 
-            // Load VAD configuration
+            // Load VAD configuration; streaming models detect endpoints themselves
             auto vad_config = config["vad"];
-            model_config.vad.model_path = vad_config["model_path"].as<std::string>();
-            model_config.vad.threshold = vad_config["threshold"].as<float>(0.3f);
-            model_config.vad.min_silence_duration = vad_config["min_silence_duration"].as<float>(0.25f);
-            model_config.vad.min_speech_duration = vad_config["min_speech_duration"].as<float>(0.1f);
-            model_config.vad.max_speech_duration = vad_config["max_speech_duration"].as<float>(15.0f);
-            model_config.vad.window_size = vad_config["window_size"].as<int>(256);
-            model_config.vad.sample_rate = vad_config["sample_rate"].as<int>(16000);
-            model_config.vad.num_threads = vad_config["num_threads"].as<int>(1);
-            model_config.vad.debug = vad_config["debug"].as<bool>(false);
+            if (vad_config || model_config.type != "streaming") {
+                model_config.vad.model_path = vad_config["model_path"].as<std::string>();
+                model_config.vad.threshold = vad_config["threshold"].as<float>(0.3f);
+                model_config.vad.min_silence_duration = vad_config["min_silence_duration"].as<float>(0.25f);
+                model_config.vad.min_speech_duration = vad_config["min_speech_duration"].as<float>(0.1f);
+                model_config.vad.max_speech_duration = vad_config["max_speech_duration"].as<float>(15.0f);
+                model_config.vad.window_size = vad_config["window_size"].as<int>(256);
+                model_config.vad.sample_rate = vad_config["sample_rate"].as<int>(16000);
+                model_config.vad.num_threads = vad_config["num_threads"].as<int>(1);
+                model_config.vad.debug = vad_config["debug"].as<bool>(false);
+            }
 
             // Load DeepLX configuration if present
             if (config["deeplx"]) {
@@ -131,9 +251,87 @@ struct ModelConfig {
                     model_config.deeplx.url = deeplx_config["url"].as<std::string>();
                     model_config.deeplx.token = deeplx_config["token"].as<std::string>();
                     model_config.deeplx.target_lang = deeplx_config["target_lang"].as<std::string>("ZH");
+                    model_config.deeplx.max_concurrent_requests = deeplx_config["max_concurrent_requests"].as<int>(4);
+                    model_config.deeplx.timeout_ms = deeplx_config["timeout_ms"].as<int>(3000);
+                    model_config.deeplx.connect_timeout_ms = deeplx_config["connect_timeout_ms"].as<int>(1000);
+                    model_config.deeplx.max_retries = deeplx_config["max_retries"].as<int>(2);
+                    model_config.deeplx.retry_backoff_ms = deeplx_config["retry_backoff_ms"].as<int>(200);
+                    model_config.deeplx.dns_cache_seconds = deeplx_config["dns_cache_seconds"].as<int>(300);
+                    model_config.deeplx.batch_size = deeplx_config["batch_size"].as<int>(8);
+                    model_config.deeplx.batch_delay_ms = deeplx_config["batch_delay_ms"].as<int>(0);
+                    model_config.deeplx.batch_max_chars = deeplx_config["batch_max_chars"].as<int>(1500);
                 }
             }
 
+            // Load mock translator configuration if present
+            if (config["mock_translator"]) {
+                auto mock_config = config["mock_translator"];
+                model_config.mock_translator.enabled = mock_config["enabled"].as<bool>(false);
+                model_config.mock_translator.target_lang = mock_config["target_lang"].as<std::string>("ZH");
+                model_config.mock_translator.latency_ms = mock_config["latency_ms"].as<int>(100);
+                model_config.mock_translator.latency_jitter_ms = mock_config["latency_jitter_ms"].as<int>(0);
+                model_config.mock_translator.error_rate = mock_config["error_rate"].as<float>(0.0f);
+            }
+
+            // Load translation cache configuration if present
+            if (config["translation_cache"]) {
+                auto cache_config = config["translation_cache"];
+                model_config.translation_cache.enabled = cache_config["enabled"].as<bool>(true);
+                model_config.translation_cache.max_memory_mb = cache_config["max_memory_mb"].as<int>(16);
+                model_config.translation_cache.disk_path = cache_config["disk_path"].as<std::string>("");
+                model_config.translation_cache.disk_max_mb = cache_config["disk_max_mb"].as<int>(64);
+            }
+
+            // Load pipeline configuration if present
+            if (config["pipeline"]) {
+                auto pipeline_config = config["pipeline"];
+                model_config.pipeline.ring_buffer_seconds = pipeline_config["ring_buffer_seconds"].as<float>(10.0f);
+                model_config.pipeline.segment_queue_capacity = pipeline_config["segment_queue_capacity"].as<int>(32);
+                model_config.pipeline.result_queue_capacity = pipeline_config["result_queue_capacity"].as<int>(64);
+                model_config.pipeline.decode_batch_size = pipeline_config["decode_batch_size"].as<int>(8);
+                model_config.pipeline.decode_batch_delay_ms = pipeline_config["decode_batch_delay_ms"].as<int>(0);
+                model_config.pipeline.vad_threads = pipeline_config["vad_threads"].as<int>(1);
+                model_config.pipeline.decode_threads = pipeline_config["decode_threads"].as<int>(1);
+                model_config.pipeline.latency_report_interval_ms = pipeline_config["latency_report_interval_ms"].as<int>(0);
+                model_config.pipeline.early_decode_interval_ms = pipeline_config["early_decode_interval_ms"].as<int>(0);
+                model_config.pipeline.early_decode_budget_percent =
+                    pipeline_config["early_decode_budget_percent"].as<float>(25.0f);
+            }
+
+            // Load capture configuration if present
+            if (config["capture"]) {
+                auto capture_config = config["capture"];
+                model_config.capture.conversion = capture_config["conversion"].as<std::string>("auto");
+                model_config.capture.channel = capture_config["channel"].as<int>(-1);
+                model_config.capture.native_max_cpu_percent = capture_config["native_max_cpu_percent"].as<float>(0.5f);
+            }
+
+            // Load output configuration if present
+            if (config["output"]) {
+                auto output_config = config["output"];
+                model_config.output.format = output_config["format"].as<std::string>("text");
+                model_config.output.destination = output_config["destination"].as<std::string>("");
+                model_config.output.queue_capacity = output_config["queue_capacity"].as<int>(1024);
+                model_config.output.partial_results = output_config["partial_results"].as<bool>(true);
+            }
+
+            // Load ingest configuration if present
+            if (config["ingest"]) {
+                auto ingest_config = config["ingest"];
+                model_config.ingest.bind_address = ingest_config["bind_address"].as<std::string>("127.0.0.1");
+                model_config.ingest.tcp_port = ingest_config["tcp_port"].as<int>(0);
+                model_config.ingest.websocket_port = ingest_config["websocket_port"].as<int>(0);
+                model_config.ingest.threads = ingest_config["threads"].as<int>(0);
+                model_config.ingest.max_connections = ingest_config["max_connections"].as<int>(256);
+            }
+
+            // Load metrics configuration if present
+            if (config["metrics"]) {
+                auto metrics_config = config["metrics"];
+                model_config.metrics.bind_address = metrics_config["bind_address"].as<std::string>("127.0.0.1");
+                model_config.metrics.port = metrics_config["port"].as<int>(0);
+            }
+
             return model_config;
         } catch (const YAML::Exception& e) {
             throw std::runtime_error("Failed to parse config file: " + std::string(e.what()));
@@ -144,8 +342,8 @@ struct ModelConfig {
         std::string error;
 
         // Validate model type
-        if (type != "sense_voice" && type != "whisper") {
-            error += "Model type must be either 'sense_voice' or 'whisper'\n";
+        if (type != "sense_voice" && type != "whisper" && type != "streaming") {
+            error += "Model type must be 'sense_voice', 'whisper' or 'streaming'\n";
         }
 
         // Validate model-specific configuration
@@ -169,10 +367,41 @@ struct ModelConfig {
             if (whisper.task != "transcribe" && whisper.task != "translate") {
                 error += "Whisper task must be either 'transcribe' or 'translate'\n";
             }
+            if (whisper.enable_language_detection) {
+                if (whisper.language_detection_num_threads <= 0) {
+                    error += "Language detection thread count should be positive\n";
+                }
+                if (whisper.language_detection_recheck_interval_ms < 0) {
+                    error += "Language detection re-check interval should not be negative\n";
+                }
+                if (whisper.language_detection_queue_capacity <= 0) {
+                    error += "Language detection queue capacity should be positive\n";
+                }
+            }
+        } else if (type == "streaming") {
+            if (streaming.model_type != "transducer" && streaming.model_type != "paraformer") {
+                error += "Streaming model type must be either 'transducer' or 'paraformer'\n";
+            }
+            if (streaming.encoder_path.empty() || streaming.decoder_path.empty()) {
+                error += "Streaming encoder or decoder path is empty\n";
+            }
+            if (streaming.model_type == "transducer" && streaming.joiner_path.empty()) {
+                error += "Streaming transducer joiner path is empty\n";
+            }
+            if (streaming.tokens_path.empty()) {
+                error += "Streaming tokens path is empty\n";
+            }
+            if (streaming.partial_interval_ms < 0) {
+                error += "Partial result interval should not be negative\n";
+            }
+            if (streaming.rule1_min_trailing_silence <= 0.0f || streaming.rule2_min_trailing_silence <= 0.0f
+                || streaming.rule3_min_utterance_length <= 0.0f) {
+                error += "Streaming endpoint rules should be positive\n";
+            }
         }
 
-        // Validate VAD configuration
-        if (vad.model_path.empty()) {
+        // Validate VAD configuration; streaming models need none
+        if (vad.model_path.empty() && type != "streaming") {
             error += "VAD model path is empty\n";
         }
         if (vad.threshold < 0.0f || vad.threshold > 1.0f) {
@@ -210,6 +439,123 @@ struct ModelConfig {
             if (deeplx.target_lang.empty()) {
                 error += "DeepLX target language is empty\n";
             }
+            if (deeplx.max_concurrent_requests <= 0) {
+                error += "DeepLX max concurrent requests should be positive\n";
+            }
+            if (deeplx.timeout_ms <= 0) {
+                error += "DeepLX timeout should be positive\n";
+            }
+            if (deeplx.connect_timeout_ms <= 0) {
+                error += "DeepLX connect timeout should be positive\n";
+            }
+            if (deeplx.max_retries < 0) {
+                error += "DeepLX max retries should not be negative\n";
+            }
+            if (deeplx.retry_backoff_ms < 0) {
+                error += "DeepLX retry backoff should not be negative\n";
+            }
+            if (deeplx.dns_cache_seconds < 0) {
+                error += "DeepLX DNS cache time should not be negative\n";
+            }
+            if (deeplx.batch_size <= 0) {
+                error += "DeepLX batch size should be positive\n";
+            }
+            if (deeplx.batch_delay_ms < 0) {
+                error += "DeepLX batch delay should not be negative\n";
+            }
+            if (deeplx.batch_max_chars <= 0) {
+                error += "DeepLX batch max chars should be positive\n";
+            }
+        }
+
+        // Validate mock translator configuration if enabled
+        if (mock_translator.enabled) {
+            if (mock_translator.target_lang.empty()) {
+                error += "Mock translator target language is empty\n";
+            }
+            if (mock_translator.latency_ms < 0 || mock_translator.latency_jitter_ms < 0) {
+                error += "Mock translator latency should not be negative\n";
+            }
+            if (mock_translator.error_rate < 0.0f || mock_translator.error_rate > 1.0f) {
+                error += "Mock translator error rate should be between 0 and 1\n";
+            }
+        }
+
+        // Validate translation cache configuration if enabled
+        if (translation_cache.enabled) {
+            if (translation_cache.max_memory_mb <= 0) {
+                error += "Translation cache memory limit should be positive\n";
+            }
+            if (!translation_cache.disk_path.empty() && translation_cache.disk_max_mb <= 0) {
+                error += "Translation cache file size should be positive\n";
+            }
+        }
+
+        // Validate pipeline configuration
+        if (pipeline.ring_buffer_seconds <= 0.0f) {
+            error += "Pipeline ring buffer duration should be positive\n";
+        }
+        if (pipeline.segment_queue_capacity <= 0 || pipeline.result_queue_capacity <= 0) {
+            error += "Pipeline queue capacities should be positive\n";
+        }
+        if (pipeline.decode_batch_size <= 0) {
+            error += "Decode batch size should be positive\n";
+        }
+        if (pipeline.decode_batch_delay_ms < 0) {
+            error += "Decode batch delay should not be negative\n";
+        }
+        if (pipeline.vad_threads <= 0 || pipeline.decode_threads <= 0) {
+            error += "Pipeline thread counts should be positive\n";
+        }
+        if (pipeline.latency_report_interval_ms < 0) {
+            error += "Latency report interval should not be negative\n";
+        }
+        if (pipeline.early_decode_interval_ms < 0) {
+            error += "Early decode interval should not be negative\n";
+        }
+        if (pipeline.early_decode_budget_percent < 0.0f || pipeline.early_decode_budget_percent > 100.0f) {
+            error += "Early decode budget should be between 0 and 100 percent\n";
+        }
+
+        // Validate capture configuration
+        if (capture.conversion != "native" && capture.conversion != "server" && capture.conversion != "auto") {
+            error += "Capture conversion must be 'native', 'server' or 'auto'\n";
+        }
+        if (capture.channel < -1) {
+            error += "Capture channel should be -1 (mix all) or a channel index\n";
+        }
+        if (capture.native_max_cpu_percent < 0.0f) {
+            error += "Native conversion CPU budget should not be negative\n";
+        }
+
+        // Validate output configuration
+        if (output.format != "text" && output.format != "jsonl" && output.format != "srt" && output.format != "vtt") {
+            error += "Output format must be 'text', 'jsonl', 'srt' or 'vtt'\n";
+        }
+        if (output.destination == "unix:") {
+            error += "Output socket path is empty\n";
+        }
+        if (output.queue_capacity <= 0) {
+            error += "Output queue capacity should be positive\n";
+        }
+
+        // Validate ingest configuration
+        if (ingest.tcp_port < 0 || ingest.tcp_port > 65535 || ingest.websocket_port < 0 || ingest.websocket_port > 65535) {
+            error += "Ingest ports should be between 0 and 65535\n";
+        }
+        if (ingest.tcp_port != 0 && ingest.tcp_port == ingest.websocket_port) {
+            error += "Ingest TCP and WebSocket ports must differ\n";
+        }
+        if (ingest.threads < 0) {
+            error += "Ingest threads should not be negative\n";
+        }
+        if (ingest.max_connections <= 0) {
+            error += "Ingest max connections should be positive\n";
+        }
+
+        // Validate metrics configuration
+        if (metrics.port < 0 || metrics.port > 65535) {
+            error += "Metrics port should be between 0 and 65535\n";
         }
 
         return error;
@@ -244,6 +590,13 @@ struct ModelConfig {
             if (whisper.decoding_method.empty()) {
                 whisper.decoding_method = "greedy_search";
             }
+        } else if (type == "streaming") {
+            if (streaming.model_type.empty()) {
+                streaming.model_type = "transducer";
+            }
+            if (streaming.decoding_method.empty()) {
+                streaming.decoding_method = "greedy_search";
+            }
         }
 
         // Set DeepLX defaults
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace common {
+
+// Lock-free single-producer/single-consumer ring buffer.
+// write() may only be called from one thread and read() from one other thread.
+// Capacity is rounded up to a power of two so indices wrap with a mask.
+template <typename T>
+class SpscRingBuffer {
+public:
+    explicit SpscRingBuffer(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        buffer_.resize(rounded);
+        mask_ = rounded - 1;
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    // Producer side. Writes as many items as fit and returns that count.
+    size_t write(const T* data, size_t n) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t free_space = buffer_.size() - (head - tail);
+        if (n > free_space) {
+            n = free_space;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            buffer_[(head + i) & mask_] = data[i];
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer side. Reads up to n items and returns the count read.
+    size_t read(T* data, size_t n) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t available = head - tail;
+        if (n > available) {
+            n = available;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            data[i] = buffer_[(tail + i) & mask_];
+        }
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // Single-item producer side that moves the item in, for items that own
+    // memory. Returns false, leaving item untouched, if the buffer is full.
+    bool try_push(T& item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == buffer_.size()) {
+            return false;
+        }
+        buffer_[head & mask_] = std::move(item);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Single-item consumer side that moves the item out
+    bool try_pop(T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (head_.load(std::memory_order_acquire) == tail) {
+            return false;
+        }
+        item = std::move(buffer_[tail & mask_]);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate number of buffered items; exact when called from either end.
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return buffer_.size();
+    }
+
+private:
+    std::vector<T> buffer_;
+    size_t mask_;
+
+    // Keep producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<size_t> head_{0};  // next write position
+    alignas(64) std::atomic<size_t> tail_{0};  // next read position
+};
+
+} // namespace common
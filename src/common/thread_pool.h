@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace common {
+
+// Fixed-size work-stealing thread pool. Every worker owns a deque: tasks
+// submitted from a worker go to the back of its own deque and are taken LIFO
+// (cache-warm), tasks submitted from outside are spread round-robin, and an
+// idle worker steals from the front of the other deques. Tasks must not block
+// on futures of other pool tasks; wait for those from outside the pool.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads)
+        : queues_(num_threads == 0 ? 1 : num_threads)
+        , next_queue_(0)
+        , pending_(0)
+        , stopping_(false) {
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            queues_[i] = std::make_unique<WorkQueue>();
+        }
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            stopping_ = true;
+        }
+        wake_cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers_.size(); }
+
+    template <typename F>
+    std::future<typename std::invoke_result<F>::type> submit(F&& fn) {
+        using Result = typename std::invoke_result<F>::type;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+        std::future<Result> future = task->get_future();
+
+        const size_t index = current_worker() == this
+            ? current_index()
+            : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        {
+            std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+            queues_[index]->tasks.emplace_back([task]() { (*task)(); });
+        }
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            ++pending_;
+        }
+        wake_cv_.notify_one();
+        return future;
+    }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    static const ThreadPool*& current_worker() {
+        static thread_local const ThreadPool* pool = nullptr;
+        return pool;
+    }
+
+    static size_t& current_index() {
+        static thread_local size_t index = 0;
+        return index;
+    }
+
+    bool try_pop(size_t index, std::function<void()>& task) {
+        // Own queue first, newest task first
+        {
+            WorkQueue& own = *queues_[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        // Then steal the oldest task of another worker
+        for (size_t k = 1; k < queues_.size(); ++k) {
+            WorkQueue& victim = *queues_[(index + k) % queues_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(size_t index) {
+        current_worker() = this;
+        current_index() = index;
+
+        std::function<void()> task;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                wake_cv_.wait(lock, [this] { return stopping_ || pending_ > 0; });
+                if (pending_ == 0) {
+                    break;  // Stopping and nothing left to run
+                }
+                --pending_;
+            }
+            // pending_ counts queued tasks, so one is guaranteed to be found
+            while (!try_pop(index, task)) {
+                std::this_thread::yield();
+            }
+            task();
+            task = nullptr;
+        }
+    }
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> next_queue_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    size_t pending_;  // Tasks submitted but not yet taken; guarded by wake_mutex_
+    bool stopping_;
+};
+
+} // namespace common
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace common {
+
+// Lets optional work use at most a share of wall-clock time. Each charge()
+// pushes the time the budget is available again forward by spent / share;
+// idle time is credited back, but never more than burst, so a long quiet
+// period cannot be followed by an unbounded spike. Lock-free, callable from
+// any thread.
+class TimeBudget {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // share <= 0 never allows any work
+    TimeBudget(double share, Clock::duration burst)
+        : share_(share)
+        , burst_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(burst).count())
+        , ready_at_ns_(0) {}
+
+    TimeBudget(const TimeBudget&) = delete;
+    TimeBudget& operator=(const TimeBudget&) = delete;
+
+    bool available(Clock::time_point now = Clock::now()) const {
+        return share_ > 0.0 && to_ns(now) >= ready_at_ns_.load(std::memory_order_relaxed);
+    }
+
+    void charge(Clock::duration spent, Clock::time_point now = Clock::now()) {
+        if (share_ <= 0.0) {
+            return;
+        }
+        const int64_t cost = static_cast<int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(spent).count() / share_);
+        const int64_t floor = to_ns(now) - burst_ns_;
+        int64_t ready_at = ready_at_ns_.load(std::memory_order_relaxed);
+        while (!ready_at_ns_.compare_exchange_weak(ready_at, std::max(ready_at, floor) + cost,
+                                                   std::memory_order_relaxed)) {
+        }
+    }
+
+private:
+    static int64_t to_ns(Clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    const double share_;
+    const int64_t burst_ns_;
+    std::atomic<int64_t> ready_at_ns_;
+};
+
+} // namespace common
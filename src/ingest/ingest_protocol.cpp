@@ -0,0 +1,291 @@
+#include "ingest/ingest_protocol.h"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+namespace ingest {
+
+namespace {
+
+// Frame type byte plus 4-byte length
+constexpr size_t kFrameHeaderSize = 5;
+
+// Limits of ParseAudioFormat; anything outside is surely a client bug
+constexpr int kMinRate = 8000;
+constexpr int kMaxRate = 192000;
+constexpr int kMaxChannels = 32;
+
+uint32_t rotate_left(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+// SHA-1, only for the WebSocket handshake
+std::string sha1(const std::string& message) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    std::string data = message;
+    const uint64_t bit_length = static_cast<uint64_t>(message.size()) * 8;
+    data += static_cast<char>(0x80);
+    while (data.size() % 64 != 56) {
+        data += '\0';
+    }
+    for (int i = 7; i >= 0; --i) {
+        data += static_cast<char>((bit_length >> (i * 8)) & 0xff);
+    }
+
+    for (size_t block = 0; block < data.size(); block += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            const auto* p = reinterpret_cast<const unsigned char*>(data.data() + block + i * 4);
+            w[i] = static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16
+                 | static_cast<uint32_t>(p[2]) << 8 | p[3];
+        }
+        for (int i = 16; i < 80; ++i) {
+            w[i] = rotate_left(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            const uint32_t temp = rotate_left(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotate_left(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    std::string digest;
+    for (uint32_t word : h) {
+        for (int i = 3; i >= 0; --i) {
+            digest += static_cast<char>((word >> (i * 8)) & 0xff);
+        }
+    }
+    return digest;
+}
+
+std::string base64(const std::string& data) {
+    static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < data.size(); i += 3) {
+        uint32_t chunk = static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << 16;
+        if (i + 1 < data.size()) {
+            chunk |= static_cast<uint32_t>(static_cast<unsigned char>(data[i + 1])) << 8;
+        }
+        if (i + 2 < data.size()) {
+            chunk |= static_cast<unsigned char>(data[i + 2]);
+        }
+        out += kAlphabet[(chunk >> 18) & 0x3f];
+        out += kAlphabet[(chunk >> 12) & 0x3f];
+        out += i + 1 < data.size() ? kAlphabet[(chunk >> 6) & 0x3f] : '=';
+        out += i + 2 < data.size() ? kAlphabet[chunk & 0x3f] : '=';
+    }
+    return out;
+}
+
+std::string lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    const size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    const size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+bool ParseAudioFormat(const std::string& text, AudioFormat& format, std::string& error) {
+    std::istringstream fields(text);
+    std::string sample_format;
+    long long rate = 0;
+    long long channels = 0;
+    std::string rest;
+    if (!(fields >> sample_format >> rate >> channels) || (fields >> rest)) {
+        error = "Audio format must be \"<s16le|f32le> <rate> <channels>\"";
+        return false;
+    }
+    if (sample_format != "s16le" && sample_format != "f32le") {
+        error = "Unsupported sample format: " + sample_format;
+        return false;
+    }
+    if (rate < kMinRate || rate > kMaxRate) {
+        error = "Unsupported sample rate: " + std::to_string(rate);
+        return false;
+    }
+    if (channels < 1 || channels > kMaxChannels) {
+        error = "Unsupported channel count: " + std::to_string(channels);
+        return false;
+    }
+    format.sample_format = sample_format == "s16le" ? dsp::CaptureConverter::Format::S16
+                                                    : dsp::CaptureConverter::Format::Float32;
+    format.rate = static_cast<int>(rate);
+    format.channels = static_cast<int>(channels);
+    return true;
+}
+
+ParseStatus ParseFrame(const char* data, size_t size, Frame& frame, std::string& error) {
+    if (size < kFrameHeaderSize) {
+        return ParseStatus::Incomplete;
+    }
+    const auto* header = reinterpret_cast<const unsigned char*>(data);
+    const size_t length = static_cast<size_t>(header[1]) | static_cast<size_t>(header[2]) << 8
+                        | static_cast<size_t>(header[3]) << 16 | static_cast<size_t>(header[4]) << 24;
+    if (data[0] != 'F' && data[0] != 'A' && data[0] != 'E') {
+        error = "Unknown frame type";
+        return ParseStatus::Invalid;
+    }
+    if (length > kMaxPayloadSize) {
+        error = "Frame too large";
+        return ParseStatus::Invalid;
+    }
+    if (size < kFrameHeaderSize + length) {
+        return ParseStatus::Incomplete;
+    }
+    frame.type = data[0];
+    frame.payload = data + kFrameHeaderSize;
+    frame.size = length;
+    frame.consumed = kFrameHeaderSize + length;
+    return ParseStatus::Complete;
+}
+
+void AppendFrame(char type, const char* payload, size_t size, std::string& out) {
+    out += type;
+    for (int i = 0; i < 4; ++i) {
+        out += static_cast<char>((size >> (i * 8)) & 0xff);
+    }
+    out.append(payload, size);
+}
+
+namespace websocket {
+
+bool ParseHandshake(const std::string& request, std::string& key) {
+    std::istringstream lines(request);
+    std::string line;
+    if (!std::getline(lines, line) || line.compare(0, 4, "GET ") != 0) {
+        return false;
+    }
+
+    bool upgrade = false;
+    key.clear();
+    while (std::getline(lines, line)) {
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        const std::string name = lower(trim(line.substr(0, colon)));
+        const std::string value = trim(line.substr(colon + 1));
+        if (name == "upgrade") {
+            upgrade = lower(value) == "websocket";
+        } else if (name == "sec-websocket-key") {
+            key = value;
+        }
+    }
+    return upgrade && !key.empty();
+}
+
+std::string HandshakeResponse(const std::string& key) {
+    return "HTTP/1.1 101 Switching Protocols\r\n"
+           "Upgrade: websocket\r\n"
+           "Connection: Upgrade\r\n"
+           "Sec-WebSocket-Accept: " + AcceptKey(key) + "\r\n\r\n";
+}
+
+std::string AcceptKey(const std::string& key) {
+    return base64(sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"));
+}
+
+ParseStatus ParseFrame(char* data, size_t size, Frame& frame, std::string& error) {
+    if (size < 2) {
+        return ParseStatus::Incomplete;
+    }
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    if (!(bytes[1] & 0x80)) {
+        error = "Client frames must be masked";
+        return ParseStatus::Invalid;
+    }
+
+    size_t header_size = 2;
+    uint64_t length = bytes[1] & 0x7f;
+    if (length == 126) {
+        header_size += 2;
+        if (size < header_size) {
+            return ParseStatus::Incomplete;
+        }
+        length = static_cast<uint64_t>(bytes[2]) << 8 | bytes[3];
+    } else if (length == 127) {
+        header_size += 8;
+        if (size < header_size) {
+            return ParseStatus::Incomplete;
+        }
+        length = 0;
+        for (int i = 0; i < 8; ++i) {
+            length = length << 8 | bytes[2 + i];
+        }
+    }
+    if (length > kMaxPayloadSize) {
+        error = "Message too large";
+        return ParseStatus::Invalid;
+    }
+
+    const size_t mask_offset = header_size;
+    header_size += 4;
+    if (size < header_size + length) {
+        return ParseStatus::Incomplete;
+    }
+
+    frame.fin = (bytes[0] & 0x80) != 0;
+    frame.opcode = bytes[0] & 0x0f;
+    frame.payload = data + header_size;
+    frame.size = static_cast<size_t>(length);
+    frame.consumed = header_size + frame.size;
+    for (size_t i = 0; i < frame.size; ++i) {
+        frame.payload[i] = static_cast<char>(frame.payload[i] ^ data[mask_offset + i % 4]);
+    }
+    return ParseStatus::Complete;
+}
+
+void AppendFrame(uint8_t opcode, const char* payload, size_t size, std::string& out) {
+    out += static_cast<char>(0x80 | opcode);
+    if (size < 126) {
+        out += static_cast<char>(size);
+    } else if (size <= 0xffff) {
+        out += static_cast<char>(126);
+        out += static_cast<char>((size >> 8) & 0xff);
+        out += static_cast<char>(size & 0xff);
+    } else {
+        out += static_cast<char>(127);
+        for (int i = 7; i >= 0; --i) {
+            out += static_cast<char>((static_cast<uint64_t>(size) >> (i * 8)) & 0xff);
+        }
+    }
+    out.append(payload, size);
+}
+
+} // namespace websocket
+
+} // namespace ingest
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <audio/dsp/capture_converter.h>
+
+namespace ingest {
+
+// Wire format of the network ingest front end (see IngestServer).
+//
+// Plain TCP carries frames of one type byte, a 4-byte little-endian payload
+// length and the payload:
+//   'F'  audio format as text, "<s16le|f32le> <rate> <channels>"; optional,
+//        before the first audio frame; the default is "s16le 16000 1"
+//   'A'  interleaved samples in that format; a frame need not end on a
+//        sample boundary
+//   'E'  end of audio; results keep coming until {"type":"end"}
+// WebSocket carries the audio as binary messages and the same commands as
+// text messages: "format s16le 48000 2" and "end".
+// Results go back as JSON lines, one text message each over WebSocket: first
+// {"type":"session","source":N}, then the records of JsonlFormat, or
+// {"type":"error","message":"..."} before the server closes the connection.
+
+// Largest frame or WebSocket message payload accepted
+constexpr size_t kMaxPayloadSize = 1 << 20;
+
+struct AudioFormat {
+    dsp::CaptureConverter::Format sample_format = dsp::CaptureConverter::Format::S16;
+    int rate = 16000;
+    int channels = 1;
+};
+
+// Parses "<s16le|f32le> <rate> <channels>"; on failure returns false and sets error
+bool ParseAudioFormat(const std::string& text, AudioFormat& format, std::string& error);
+
+enum class ParseStatus {
+    Incomplete,  // Need more bytes
+    Complete,    // frame is set; consumed bytes can be dropped
+    Invalid,     // The stream is corrupt; error is set
+};
+
+struct Frame {
+    char type = 0;
+    const char* payload = nullptr;
+    size_t size = 0;
+    size_t consumed = 0;  // Header plus payload
+};
+
+// Parses the TCP frame at the start of data
+ParseStatus ParseFrame(const char* data, size_t size, Frame& frame, std::string& error);
+
+// Appends a TCP frame, e.g. for a client
+void AppendFrame(char type, const char* payload, size_t size, std::string& out);
+
+namespace websocket {
+
+enum Opcode : uint8_t {
+    kContinuation = 0x0,
+    kText = 0x1,
+    kBinary = 0x2,
+    kClose = 0x8,
+    kPing = 0x9,
+    kPong = 0xA,
+};
+
+struct Frame {
+    uint8_t opcode = 0;
+    bool fin = false;
+    char* payload = nullptr;  // Unmasked in place
+    size_t size = 0;
+    size_t consumed = 0;
+};
+
+// request is everything up to and including the blank line ending the HTTP
+// headers. Returns false unless it is a WebSocket upgrade; sets key to
+// Sec-WebSocket-Key.
+bool ParseHandshake(const std::string& request, std::string& key);
+
+// The 101 Switching Protocols response to a client's Sec-WebSocket-Key
+std::string HandshakeResponse(const std::string& key);
+
+// Sec-WebSocket-Accept for a Sec-WebSocket-Key (RFC 6455 section 4.2.2)
+std::string AcceptKey(const std::string& key);
+
+// Parses a client frame at the start of data; client frames must be masked
+ParseStatus ParseFrame(char* data, size_t size, Frame& frame, std::string& error);
+
+// Appends an unmasked server frame with FIN set
+void AppendFrame(uint8_t opcode, const char* payload, size_t size, std::string& out);
+
+} // namespace websocket
+
+} // namespace ingest
@@ -0,0 +1,801 @@
+#include "ingest/ingest_server.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include "ingest/ingest_protocol.h"
+#include "trace/trace.h"
+
+namespace ingest {
+
+namespace {
+
+constexpr int kMaxEvents = 64;
+// epoll_wait timeout while some connection waits for ring buffer space
+constexpr int kPausedPollMs = 5;
+// Otherwise; bounds how long stop() waits for the loop
+constexpr int kIdlePollMs = 100;
+constexpr size_t kReadChunk = 64 * 1024;
+// Longest WebSocket upgrade request accepted
+constexpr size_t kMaxHandshakeSize = 8192;
+// Unsent results a client may fall behind by before it is disconnected
+constexpr size_t kMaxPendingOutput = 4 << 20;
+
+// Output side of a connection, shared by its event loop and the output
+// writer thread: the writer appends formatted results, the loop sends them
+struct ConnectionOutput {
+    ConnectionOutput(bool websocket, int wake_fd) : websocket(websocket), wake_fd(wake_fd) {}
+
+    // Appends JSON lines, each as one text message over WebSocket. Call with mutex held.
+    void append_lines(const std::string& lines) {
+        if (!websocket) {
+            pending += lines;
+            return;
+        }
+        size_t begin = 0;
+        while (begin < lines.size()) {
+            size_t end = lines.find('\n', begin);
+            if (end == std::string::npos) {
+                end = lines.size();
+            }
+            websocket::AppendFrame(websocket::kText, lines.data() + begin, end - begin, pending);
+            begin = end + 1;
+        }
+    }
+
+    // Makes the event loop send pending. Call with mutex held, so the loop
+    // cannot close wake_fd in between (see EventLoop::close_connection).
+    void wake() const {
+        const uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    const bool websocket;
+    const int wake_fd;
+
+    std::mutex mutex;
+    std::string pending;      // Not sent yet
+    bool finished = false;    // The end-of-session record is in pending
+    bool overflowed = false;  // The client fell too far behind
+    bool closed = false;      // The connection is gone
+    bool end_seen = false;    // Writer thread only: SessionFormat just wrote the end record
+};
+
+// JSON lines, noting the end of the session for SessionDestination
+class SessionFormat : public output::JsonlFormat {
+public:
+    explicit SessionFormat(std::shared_ptr<ConnectionOutput> connection) : connection_(std::move(connection)) {}
+
+    bool append(const output::OutputRecord& record, std::string& out) override {
+        if (record.end_of_stream) {
+            connection_->end_seen = true;
+        }
+        return JsonlFormat::append(record, out);
+    }
+
+private:
+    std::shared_ptr<ConnectionOutput> connection_;
+};
+
+class SessionDestination : public output::OutputDestination {
+public:
+    explicit SessionDestination(std::shared_ptr<ConnectionOutput> connection) : connection_(std::move(connection)) {}
+
+    void write(const std::string& data) override {
+        std::lock_guard<std::mutex> lock(connection_->mutex);
+        if (connection_->closed) {
+            return;
+        }
+        connection_->append_lines(data);
+        connection_->finished = connection_->end_seen;
+        connection_->overflowed = connection_->pending.size() > kMaxPendingOutput;
+        connection_->wake();
+    }
+
+    bool closed() const override {
+        std::lock_guard<std::mutex> lock(connection_->mutex);
+        return connection_->closed || connection_->overflowed;
+    }
+
+private:
+    std::shared_ptr<ConnectionOutput> connection_;
+};
+
+} // namespace
+
+struct Connection {
+    int fd = -1;
+    bool websocket = false;
+    bool upgraded = false;  // WebSocket handshake done
+    std::shared_ptr<ConnectionOutput> output;
+
+    uint32_t source_id = 0;
+    std::shared_ptr<pipeline::StreamContext> stream;
+    bool stream_removed = false;
+
+    AudioFormat format;
+    std::unique_ptr<dsp::CaptureConverter> converter;  // Created by the first audio
+    std::string input;                  // Received but not parsed yet
+    std::string partial_frame;          // Start of a sample frame split across payloads
+    std::vector<float> staging;         // Payload copied to float alignment for the converter
+    std::vector<int16_t> pending_audio; // Converted audio waiting for ring buffer space
+    size_t pending_offset = 0;
+
+    uint8_t message_opcode = 0;  // WebSocket: type of the message being received
+    std::string text_message;    // WebSocket: text received so far
+
+    bool paused = false;        // Not reading: the ring buffer is full
+    bool end_of_audio = false;  // The client sent its last audio
+    bool closing = false;       // Close once pending output is sent
+    bool close_sent = false;    // WebSocket close frame queued
+    bool dead = false;          // Close now
+    bool registered = false;    // Added to the epoll set
+    uint32_t events = 0;        // Registered epoll events
+};
+
+class EventLoop {
+public:
+    explicit EventLoop(IngestServer& server);
+    ~EventLoop();
+
+    // Adds a listening socket on port, shared with the other loops
+    void listen(int port, bool websocket);
+    void run();
+    void wake();
+    // Closes every connection; call after run() has returned
+    void close_all();
+
+private:
+    void accept_connections(int listener, bool websocket);
+    void start_session(Connection& c);
+    void on_readable(Connection& c);
+    void process_input(Connection& c);
+    void handle_frame(Connection& c, const Frame& frame);
+    void handle_websocket_frame(Connection& c, const websocket::Frame& frame);
+    void handle_command(Connection& c, const std::string& command);
+    void set_format(Connection& c, const std::string& text);
+    void feed_audio(Connection& c, const char* data, size_t size);
+    void push_audio(Connection& c, const int16_t* pcm, size_t n);
+    // Moves pending audio into the ring buffer; true once none is left
+    bool drain_pending_audio(Connection& c);
+    void resume_paused();
+    void end_audio(Connection& c);
+    // Sends an error line and closes the connection once it is out
+    void fail(Connection& c, const std::string& message);
+    void flush(Connection& c);
+    void update_events(Connection& c);
+    void close_connection(int fd);
+
+    IngestServer& server_;
+    int epoll_fd_;
+    int wake_fd_;
+    std::map<int, bool> listeners_;  // fd -> WebSocket
+    std::map<int, std::unique_ptr<Connection>> connections_;
+    size_t paused_count_;
+};
+
+EventLoop::EventLoop(IngestServer& server)
+    : server_(server)
+    , epoll_fd_(::epoll_create1(EPOLL_CLOEXEC))
+    , wake_fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    , paused_count_(0) {
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        const std::string reason = std::strerror(errno);
+        if (epoll_fd_ >= 0) {
+            ::close(epoll_fd_);
+        }
+        if (wake_fd_ >= 0) {
+            ::close(wake_fd_);
+        }
+        throw std::runtime_error("Failed to create ingest event loop: " + reason);
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake_fd_;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+}
+
+EventLoop::~EventLoop() {
+    close_all();
+    for (const auto& listener : listeners_) {
+        ::close(listener.first);
+    }
+    ::close(wake_fd_);
+    ::close(epoll_fd_);
+}
+
+void EventLoop::listen(int port, bool websocket) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    const std::string& host = server_.config_.bind_address;
+    if (::inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        throw std::runtime_error("Invalid ingest bind address: " + host);
+    }
+
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    const int one = 1;
+    if (fd < 0 || ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0
+        || ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0
+        || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(fd, SOMAXCONN) != 0) {
+        const std::string reason = std::strerror(errno);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error("Failed to listen on " + host + ":" + std::to_string(port) + ": " + reason);
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+    listeners_.emplace(fd, websocket);
+}
+
+void EventLoop::wake() {
+    const uint64_t one = 1;
+    ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+    (void)ignored;
+}
+
+void EventLoop::run() {
+    trace::SetThreadName("ingest");
+    epoll_event events[kMaxEvents];
+    while (server_.running_) {
+        const int ready = ::epoll_wait(epoll_fd_, events, kMaxEvents, paused_count_ > 0 ? kPausedPollMs : kIdlePollMs);
+        for (int i = 0; i < ready; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == wake_fd_) {
+                uint64_t count;
+                ssize_t ignored = ::read(wake_fd_, &count, sizeof(count));
+                (void)ignored;
+                // The output writer queued results for some connections
+                for (auto it = connections_.begin(); it != connections_.end();) {
+                    Connection& c = *(it++)->second;
+                    flush(c);
+                    if (c.dead) {
+                        close_connection(c.fd);
+                    }
+                }
+                continue;
+            }
+            auto listener = listeners_.find(fd);
+            if (listener != listeners_.end()) {
+                accept_connections(fd, listener->second);
+                continue;
+            }
+
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            Connection& c = *it->second;
+            if (events[i].events & EPOLLERR) {
+                c.dead = true;
+            }
+            if (!c.dead && (events[i].events & EPOLLIN)) {
+                on_readable(c);
+            } else if (events[i].events & EPOLLHUP) {
+                c.dead = true;  // Gone in both directions; results could not be delivered
+            }
+            if (!c.dead && (events[i].events & EPOLLOUT)) {
+                flush(c);
+            }
+            if (c.dead) {
+                close_connection(fd);
+            }
+        }
+        if (paused_count_ > 0) {
+            resume_paused();
+        }
+    }
+}
+
+void EventLoop::close_all() {
+    while (!connections_.empty()) {
+        close_connection(connections_.begin()->first);
+    }
+}
+
+void EventLoop::accept_connections(int listener, bool websocket) {
+    while (true) {
+        const int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;  // EAGAIN: nobody waiting, or another loop was faster
+        }
+        if (server_.active_.fetch_add(1) >= static_cast<uint64_t>(server_.config_.max_connections)) {
+            server_.active_.fetch_sub(1);
+            server_.rejected_.fetch_add(1, std::memory_order_relaxed);
+            ::close(fd);
+            continue;
+        }
+        server_.accepted_.fetch_add(1, std::memory_order_relaxed);
+
+        // Results are small and latency matters more than packet count
+        const int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto connection = std::make_unique<Connection>();
+        Connection& c = *connection;
+        c.fd = fd;
+        c.websocket = websocket;
+        c.output = std::make_shared<ConnectionOutput>(websocket, wake_fd_);
+        connections_.emplace(fd, std::move(connection));
+        update_events(c);
+        if (!websocket) {
+            start_session(c);
+        }
+        if (c.dead) {
+            close_connection(fd);
+        }
+    }
+}
+
+void EventLoop::start_session(Connection& c) {
+    c.source_id = server_.next_source_id_.fetch_add(1);
+    try {
+        c.stream = server_.pipeline_.add_stream(c.source_id, server_.make_vad_ ? server_.make_vad_() : nullptr);
+    } catch (const std::exception& e) {
+        fail(c, e.what());
+        return;
+    }
+    // Subscribed before any audio is accepted, so no result can be missed
+    server_.output_->add_subscriber(std::make_unique<SessionFormat>(c.output),
+                                    std::make_unique<SessionDestination>(c.output), c.source_id);
+    {
+        std::lock_guard<std::mutex> lock(c.output->mutex);
+        c.output->append_lines("{\"type\":\"session\",\"source\":" + std::to_string(c.source_id) + "}\n");
+    }
+    flush(c);
+}
+
+void EventLoop::on_readable(Connection& c) {
+    if (c.paused || c.end_of_audio || c.closing) {
+        return;
+    }
+    trace::Span span("ingest_read", "ingest");
+    char buffer[kReadChunk];
+    // One read per wakeup, so a fast client cannot starve the others on this loop
+    const ssize_t n = ::recv(c.fd, buffer, sizeof(buffer), 0);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EINTR) {
+            c.dead = true;
+        }
+        return;
+    }
+    if (n == 0) {
+        // A TCP client may shut down its sending side and still read its results
+        if (c.websocket || c.closing) {
+            c.dead = true;
+        } else {
+            end_audio(c);
+        }
+        return;
+    }
+    server_.bytes_received_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+    c.input.append(buffer, static_cast<size_t>(n));
+    process_input(c);
+}
+
+void EventLoop::process_input(Connection& c) {
+    if (c.websocket && !c.upgraded) {
+        const size_t end = c.input.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            if (c.input.size() > kMaxHandshakeSize) {
+                c.dead = true;
+            }
+            return;
+        }
+        std::string key;
+        const bool upgrade = websocket::ParseHandshake(c.input.substr(0, end + 4), key);
+        {
+            std::lock_guard<std::mutex> lock(c.output->mutex);
+            c.output->pending += upgrade ? websocket::HandshakeResponse(key)
+                                         : "HTTP/1.1 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+        }
+        c.input.erase(0, end + 4);
+        if (!upgrade) {
+            c.closing = true;
+            update_events(c);
+            flush(c);
+            return;
+        }
+        c.upgraded = true;
+        start_session(c);
+    }
+
+    size_t offset = 0;
+    std::string error;
+    while (!c.paused && !c.end_of_audio && !c.closing && !c.dead && offset < c.input.size()) {
+        ParseStatus status;
+        size_t consumed = 0;
+        if (c.websocket) {
+            websocket::Frame frame;
+            status = websocket::ParseFrame(&c.input[offset], c.input.size() - offset, frame, error);
+            if (status == ParseStatus::Complete) {
+                handle_websocket_frame(c, frame);
+                consumed = frame.consumed;
+            }
+        } else {
+            Frame frame;
+            status = ParseFrame(c.input.data() + offset, c.input.size() - offset, frame, error);
+            if (status == ParseStatus::Complete) {
+                handle_frame(c, frame);
+                consumed = frame.consumed;
+            }
+        }
+        if (status == ParseStatus::Invalid) {
+            fail(c, error);
+        }
+        if (status != ParseStatus::Complete) {
+            break;
+        }
+        offset += consumed;
+    }
+    c.input.erase(0, offset);
+}
+
+void EventLoop::handle_frame(Connection& c, const Frame& frame) {
+    switch (frame.type) {
+        case 'F':
+            set_format(c, std::string(frame.payload, frame.size));
+            break;
+        case 'A':
+            feed_audio(c, frame.payload, frame.size);
+            break;
+        case 'E':
+            end_audio(c);
+            break;
+    }
+}
+
+void EventLoop::handle_websocket_frame(Connection& c, const websocket::Frame& frame) {
+    switch (frame.opcode) {
+        case websocket::kPing: {
+            std::lock_guard<std::mutex> lock(c.output->mutex);
+            websocket::AppendFrame(websocket::kPong, frame.payload, frame.size, c.output->pending);
+            break;
+        }
+        case websocket::kPong:
+            return;
+        case websocket::kClose: {
+            // The client is leaving; answer and close without waiting for results
+            std::lock_guard<std::mutex> lock(c.output->mutex);
+            if (!c.close_sent) {
+                websocket::AppendFrame(websocket::kClose, nullptr, 0, c.output->pending);
+                c.close_sent = true;
+            }
+            c.closing = true;
+            break;
+        }
+        case websocket::kText:
+        case websocket::kBinary:
+        case websocket::kContinuation:
+            if (frame.opcode != websocket::kContinuation) {
+                c.message_opcode = frame.opcode;
+                c.text_message.clear();
+            }
+            if (c.message_opcode == websocket::kBinary) {
+                feed_audio(c, frame.payload, frame.size);
+            } else if (c.message_opcode == websocket::kText) {
+                if (c.text_message.size() + frame.size > kMaxPayloadSize) {
+                    fail(c, "Message too large");
+                    return;
+                }
+                c.text_message.append(frame.payload, frame.size);
+                if (frame.fin) {
+                    handle_command(c, c.text_message);
+                }
+            } else {
+                fail(c, "Continuation without a message");
+            }
+            return;
+        default:
+            fail(c, "Unknown WebSocket opcode");
+            return;
+    }
+    update_events(c);
+    flush(c);
+}
+
+void EventLoop::handle_command(Connection& c, const std::string& command) {
+    if (command == "end") {
+        end_audio(c);
+    } else if (command.compare(0, 7, "format ") == 0) {
+        set_format(c, command.substr(7));
+    } else {
+        fail(c, "Unknown command: " + command);
+    }
+}
+
+void EventLoop::set_format(Connection& c, const std::string& text) {
+    if (c.converter) {
+        fail(c, "The audio format must be set before the first audio");
+        return;
+    }
+    std::string error;
+    if (!ParseAudioFormat(text, c.format, error)) {
+        fail(c, error);
+    }
+}
+
+void EventLoop::feed_audio(Connection& c, const char* data, size_t size) {
+    if (!c.converter) {
+        c.converter = std::make_unique<dsp::CaptureConverter>(c.format.sample_format, c.format.rate,
+                                                              c.format.channels);
+    }
+
+    const size_t frame_bytes = c.converter->bytes_per_frame();
+    const size_t frames = (c.partial_frame.size() + size) / frame_bytes;
+    if (frames == 0) {
+        c.partial_frame.append(data, size);
+        return;
+    }
+
+    // The converter reads samples in place, so give it aligned memory
+    const size_t bytes = frames * frame_bytes;
+    const size_t used = bytes - c.partial_frame.size();
+    c.staging.resize((bytes + sizeof(float) - 1) / sizeof(float));
+    char* staging = reinterpret_cast<char*>(c.staging.data());
+    std::memcpy(staging, c.partial_frame.data(), c.partial_frame.size());
+    std::memcpy(staging + c.partial_frame.size(), data, used);
+    c.partial_frame.assign(data + used, size - used);
+
+    c.converter->convert(staging, frames, [this, &c](const int16_t* pcm, size_t n) { push_audio(c, pcm, n); });
+    if (c.pending_audio.size() > c.pending_offset && !c.paused) {
+        c.paused = true;
+        ++paused_count_;
+        server_.paused_.fetch_add(1, std::memory_order_relaxed);
+        update_events(c);
+    }
+}
+
+void EventLoop::push_audio(Connection& c, const int16_t* pcm, size_t n) {
+    if (c.pending_audio.size() == c.pending_offset) {
+        const auto& ring = c.stream->ring;
+        const size_t take = std::min(n, ring.capacity() - ring.size());
+        if (take > 0) {
+            server_.pipeline_.push_audio(*c.stream, pcm, take);
+            pcm += take;
+            n -= take;
+        }
+    }
+    c.pending_audio.insert(c.pending_audio.end(), pcm, pcm + n);
+}
+
+bool EventLoop::drain_pending_audio(Connection& c) {
+    const auto& ring = c.stream->ring;
+    const size_t take = std::min(c.pending_audio.size() - c.pending_offset, ring.capacity() - ring.size());
+    if (take > 0) {
+        server_.pipeline_.push_audio(*c.stream, c.pending_audio.data() + c.pending_offset, take);
+        c.pending_offset += take;
+    }
+    if (c.pending_offset < c.pending_audio.size()) {
+        return false;
+    }
+    c.pending_audio.clear();
+    c.pending_offset = 0;
+    return true;
+}
+
+void EventLoop::resume_paused() {
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        Connection& c = *(it++)->second;
+        if (!c.paused || !drain_pending_audio(c)) {
+            continue;
+        }
+        c.paused = false;
+        --paused_count_;
+        // Frames received before the pause; may pause again
+        process_input(c);
+        if (c.end_of_audio) {
+            end_audio(c);
+        }
+        update_events(c);
+        if (c.dead) {
+            close_connection(c.fd);
+        }
+    }
+}
+
+void EventLoop::end_audio(Connection& c) {
+    c.end_of_audio = true;
+    update_events(c);
+    // Audio still waiting for the ring buffer goes first; resume_paused() calls again
+    if (c.paused || c.stream_removed || !c.stream) {
+        return;
+    }
+    c.partial_frame.clear();  // Half a sample frame is no audio
+    server_.pipeline_.remove_stream(c.stream);
+    c.stream_removed = true;
+}
+
+void EventLoop::fail(Connection& c, const std::string& message) {
+    std::string line = "{\"type\":\"error\",\"message\":";
+    output::AppendJsonString(message, line);
+    line += "}\n";
+    {
+        std::lock_guard<std::mutex> lock(c.output->mutex);
+        c.output->append_lines(line);
+        if (c.websocket && !c.close_sent) {
+            websocket::AppendFrame(websocket::kClose, nullptr, 0, c.output->pending);
+            c.close_sent = true;
+        }
+    }
+    c.closing = true;
+    update_events(c);
+    flush(c);
+}
+
+void EventLoop::flush(Connection& c) {
+    bool done;
+    {
+        std::lock_guard<std::mutex> lock(c.output->mutex);
+        std::string& pending = c.output->pending;
+        if (c.output->overflowed) {
+            c.dead = true;
+            return;
+        }
+        if (c.output->finished && c.websocket && !c.close_sent) {
+            websocket::AppendFrame(websocket::kClose, nullptr, 0, pending);
+            c.close_sent = true;
+        }
+
+        size_t sent = 0;
+        while (sent < pending.size()) {
+            const ssize_t n = ::send(c.fd, pending.data() + sent, pending.size() - sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                sent += static_cast<size_t>(n);
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && errno == EAGAIN) {
+                break;
+            } else {
+                c.dead = true;
+                return;
+            }
+        }
+        pending.erase(0, sent);
+        done = pending.empty() && (c.output->finished || c.closing);
+    }
+    if (done) {
+        c.dead = true;
+        return;
+    }
+    update_events(c);
+}
+
+void EventLoop::update_events(Connection& c) {
+    uint32_t events = 0;
+    if (!c.paused && !c.end_of_audio && !c.closing) {
+        events |= EPOLLIN;
+    }
+    {
+        std::lock_guard<std::mutex> lock(c.output->mutex);
+        if (!c.output->pending.empty()) {
+            events |= EPOLLOUT;
+        }
+    }
+    if (c.registered && c.events == events) {
+        return;
+    }
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = c.fd;
+    ::epoll_ctl(epoll_fd_, c.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, c.fd, &event);
+    c.registered = true;
+    c.events = events;
+}
+
+void EventLoop::close_connection(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    Connection& c = *it->second;
+    if (c.stream && !c.stream_removed) {
+        // Audio already in the ring buffer is still recognized; nobody reads the results
+        server_.pipeline_.remove_stream(c.stream);
+    }
+    if (c.paused) {
+        --paused_count_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(c.output->mutex);
+        c.output->closed = true;
+    }
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    // Free the slot first: a client that sees the close may reconnect at once
+    server_.active_.fetch_sub(1);
+    ::close(fd);
+    connections_.erase(it);
+}
+
+IngestServer::IngestServer(const common::IngestConfig& config, pipeline::RecognitionPipeline& pipeline,
+                           std::shared_ptr<output::OutputWriter> output, VadFactory make_vad)
+    : config_(config)
+    , pipeline_(pipeline)
+    , output_(std::move(output))
+    , make_vad_(std::move(make_vad))
+    , running_(false)
+    , next_source_id_(1)
+    , active_(0)
+    , accepted_(0)
+    , rejected_(0)
+    , bytes_received_(0)
+    , paused_(0) {
+}
+
+IngestServer::~IngestServer() {
+    stop();
+}
+
+void IngestServer::start() {
+    if (running_) {
+        return;
+    }
+    if (config_.tcp_port == 0 && config_.websocket_port == 0) {
+        throw std::runtime_error("No ingest port configured; set ingest.tcp_port or ingest.websocket_port");
+    }
+
+    const unsigned int threads = config_.threads > 0 ? static_cast<unsigned int>(config_.threads)
+                                                     : std::max(1u, std::thread::hardware_concurrency());
+    try {
+        for (unsigned int i = 0; i < threads; ++i) {
+            loops_.push_back(std::make_unique<EventLoop>(*this));
+            if (config_.tcp_port != 0) {
+                loops_.back()->listen(config_.tcp_port, false);
+            }
+            if (config_.websocket_port != 0) {
+                loops_.back()->listen(config_.websocket_port, true);
+            }
+        }
+    } catch (...) {
+        loops_.clear();
+        throw;
+    }
+
+    running_ = true;
+    for (auto& loop : loops_) {
+        threads_.emplace_back(&EventLoop::run, loop.get());
+    }
+}
+
+void IngestServer::stop() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    for (auto& loop : loops_) {
+        loop->wake();
+    }
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+    loops_.clear();
+}
+
+IngestStats IngestServer::stats() const {
+    IngestStats stats;
+    stats.active = active_.load();
+    stats.accepted = accepted_.load(std::memory_order_relaxed);
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+    stats.bytes_received = bytes_received_.load(std::memory_order_relaxed);
+    stats.paused = paused_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace ingest
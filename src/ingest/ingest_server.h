@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <common/model_config.h>
+#include <output/output_writer.h>
+#include <pipeline/recognition_pipeline.h>
+
+namespace ingest {
+
+class EventLoop;
+
+struct IngestStats {
+    uint64_t active = 0;          // Open connections
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;        // Turned away at max_connections
+    uint64_t bytes_received = 0;
+    uint64_t paused = 0;          // Times a connection stopped reading because its ring buffer was full
+};
+
+// Network front end for servers without a sound card: every TCP or
+// WebSocket connection is one recognition session, a source of the shared
+// pipeline with its own ring buffer and VAD, and gets its own results back
+// (see ingest_protocol.h for the wire format). Audio is converted to 16 kHz
+// mono on the way in, as PulseAudioCapture does for native capture.
+//
+// Each event loop thread runs its own epoll set and listening sockets on the
+// same ports (SO_REUSEPORT), so the kernel spreads connections across cores
+// and a connection stays on one thread: that thread is the only producer of
+// its ring buffer. When a ring buffer is full the connection stops reading
+// until the pipeline catches up, so TCP flow control slows the client down
+// instead of audio being dropped. Results reach the connection through an
+// output writer subscriber filtered to its source; the writer only appends
+// to a buffer, and the event loop does the socket writes.
+class IngestServer {
+public:
+    // Called on an event loop thread for every new session; may return null
+    // in streaming mode
+    using VadFactory = std::function<pipeline::VadPtr()>;
+
+    IngestServer(const common::IngestConfig& config, pipeline::RecognitionPipeline& pipeline,
+                 std::shared_ptr<output::OutputWriter> output, VadFactory make_vad);
+    ~IngestServer();
+
+    IngestServer(const IngestServer&) = delete;
+    IngestServer& operator=(const IngestServer&) = delete;
+
+    // Throws std::runtime_error if no port is configured or one cannot be bound
+    void start();
+    // Closes every connection; audio already in the pipeline is still recognized
+    void stop();
+
+    IngestStats stats() const;
+
+private:
+    friend class EventLoop;
+
+    common::IngestConfig config_;
+    pipeline::RecognitionPipeline& pipeline_;
+    std::shared_ptr<output::OutputWriter> output_;
+    VadFactory make_vad_;
+
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> running_;
+    std::atomic<uint32_t> next_source_id_;
+
+    std::atomic<uint64_t> active_;
+    std::atomic<uint64_t> accepted_;
+    std::atomic<uint64_t> rejected_;
+    std::atomic<uint64_t> bytes_received_;
+    std::atomic<uint64_t> paused_;
+};
+
+} // namespace ingest
@@ -1,10 +1,15 @@
 // main.cpp
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <csignal>
 #include <thread>
 #include <atomic>
+#include <iomanip>
+#include <sstream>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -12,31 +17,111 @@
 
 #include <common/model_config.h>
 #include <audio/audio_capture.h>
+#include <audio/audio_source.h>
 #include <translator/translator.h>
 #include <sherpa-onnx/c-api/c-api.h>
-#include <recognizer/model_factory.h>
+#include <recognizer/model_registry.h>
+#include <pipeline/batch_transcriber.h>
+#include <pipeline/recognition_pipeline.h>
+#include <output/output_writer.h>
+#include <trace/trace.h>
+#ifndef _WIN32
+#include <service/control_server.h>
+#include <ingest/ingest_server.h>
+#include <metrics/metrics_server.h>
+#endif
 
 std::atomic<bool> g_running{true};
+// Set by SIGUSR1; starting and writing a trace is not async-signal-safe, so
+// the main thread does it in poll_trace_toggle()
+std::atomic<bool> g_trace_toggle{false};
+std::string g_trace_path = "voice-assistant-trace.json";
 
 void signal_handler(int signal) {
-    if (signal == SIGINT) {
+    if (signal == SIGINT || signal == SIGTERM) {
         g_running = false;
     }
+#ifndef _WIN32
+    if (signal == SIGUSR1) {
+        g_trace_toggle = true;
+    }
+#endif
 }
 
+void write_trace() {
+    try {
+        trace::WriteChromeTrace(g_trace_path);
+        const trace::TraceStats stats = trace::Stats();
+        std::cerr << "Trace written to " << g_trace_path << " (" << stats.events << " events from "
+                  << stats.threads << " threads, " << stats.dropped << " dropped)" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+// Called from the wait loops: SIGUSR1 starts a trace, the next one stops it
+// and writes it out
+void poll_trace_toggle() {
+    if (!g_trace_toggle.exchange(false)) {
+        return;
+    }
+    if (trace::Enabled()) {
+        trace::Stop();
+        write_trace();
+    } else {
+        trace::Start();
+        std::cerr << "Tracing started" << std::endl;
+    }
+}
+
+// Writes a trace still running when main returns, e.g. one started by --trace
+struct TraceGuard {
+    ~TraceGuard() {
+        if (trace::Enabled()) {
+            trace::Stop();
+            write_trace();
+        }
+    }
+};
+
 void print_usage() {
     std::cout << "Usage: audio_recorder [OPTIONS]\n"
               << "Options:\n"
               << "  -l, --list                List available audio sources\n"
-              << "  -s, --source <index>      Record from the specified source index\n"
+              << "  -s, --source <index>[,<index>...]\n"
+              << "                            Record from the specified source indexes;\n"
+              << "                            repeat or comma-separate to record several at once\n"
               << "  -m, --model <path>        Use speech recognition model with YAML config at path\n"
+              << "  -f, --file <path>         Transcribe a WAV file or every WAV in a directory\n"
+              << "                            instead of recording; may be repeated\n"
+              << "  -j, --jobs <n>            Worker threads for --file (default: cores / num_threads)\n"
+              << "  -i, --input <source>      Recognize a headless source instead of a sound server; may be\n"
+              << "                            repeated: <file>.wav, file:<path>, raw:<path> (16 kHz s16le),\n"
+              << "                            stdin, synth[:<seconds>]\n"
+              << "      --speed <x>           Playback speed for --input: 1 = real time (default), 0 = unthrottled\n"
+              << "      --serve <path>        Run as a service: load the models once and take commands on the\n"
+              << "                            Unix socket at path (list, start <index>, stop <index>, status,\n"
+              << "                            subscribe [jsonl|text|srt|vtt], help), one per line\n"
+              << "      --ingest              Recognize audio streamed by network clients over TCP or\n"
+              << "                            WebSocket, on the ports of the ingest config section\n"
+              << "      --trace <path>        Trace the hot paths from startup and write a Chrome trace\n"
+              << "                            (chrome://tracing, ui.perfetto.dev) to path on exit; SIGUSR1\n"
+              << "                            also starts a trace and, sent again, writes it to path\n"
+              << "                            (default: voice-assistant-trace.json)\n"
               << "  -h, --help                Show this help message\n"
               << "\nExamples:\n"
               << "  audio_recorder --list\n"
               << "  audio_recorder -s 1 -m config.yaml\n"
+              << "  audio_recorder -s 1,3 -m config.yaml\n"
+              << "  audio_recorder -f test/test_data -m config.yaml\n"
+              << "  audio_recorder -i synth:600 -i synth:600 --speed 4 -m config.yaml\n"
+              << "  audio_recorder --serve /tmp/voice-assistant.sock -m config.yaml\n"
+              << "    then e.g.: echo 'start 12' | socat - UNIX-CONNECT:/tmp/voice-assistant.sock\n"
+              << "  audio_recorder --ingest -m config.yaml\n"
+              << "  audio_recorder -s 1 -m config.yaml --trace trace.json\n"
               << "\nYAML Configuration Example:\n"
               << "  model:\n"
-              << "    type: sense_voice  # or whisper\n"
+              << "    type: sense_voice  # or whisper, streaming\n"
               << "    sense_voice:  # if type is sense_voice\n"
               << "      model_path: path/to/model.onnx\n"
               << "      tokens_path: path/to/tokens.txt\n"
@@ -46,6 +131,13 @@ void print_usage() {
               << "      decoder_path: path/to/decoder.onnx\n"
               << "      tokens_path: path/to/tokens.txt\n"
               << "      language: auto\n"
+              << "    streaming:  # if type is streaming; needs no vad section\n"
+              << "      model_type: transducer  # or paraformer\n"
+              << "      encoder_path: path/to/encoder.onnx\n"
+              << "      decoder_path: path/to/decoder.onnx\n"
+              << "      joiner_path: path/to/joiner.onnx\n"
+              << "      tokens_path: path/to/tokens.txt\n"
+              << "      partial_interval_ms: 200\n"
               << "  vad:\n"
               << "    model_path: path/to/vad.onnx\n"
               << "    threshold: 0.3\n"
@@ -56,6 +148,271 @@ void print_usage() {
               << "    target_lang: ZH\n";
 }
 
+// Transcribes recorded files instead of a live source; no audio server is needed
+int run_batch(const common::ModelConfig& model_config, const std::vector<std::string>& paths, int jobs) {
+    if (model_config.type == "streaming") {
+        std::cerr << "--file needs an offline model; use --input <file> --speed 0 with a streaming model." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> files = pipeline::BatchTranscriber::CollectInputs(paths);
+    if (files.empty()) {
+        std::cerr << "No input files found." << std::endl;
+        return 1;
+    }
+
+    // Each decode already uses num_threads, so by default run just enough
+    // workers to keep every core busy without oversubscribing
+    if (jobs <= 0) {
+        unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+        jobs = std::max(1, static_cast<int>(cores) / std::max(1, model_config.num_threads));
+    }
+
+    recognizer::RecognizerHandle recognizer = recognizer::ModelRegistry::Instance().GetRecognizer(model_config);
+    pipeline::BatchTranscriber transcriber(model_config, recognizer.get(), static_cast<size_t>(jobs));
+
+    int failed = 0;
+    pipeline::BatchStats stats = transcriber.run(files, [&failed](const pipeline::BatchFileResult& file) {
+        std::cout << "\n[File] " << file.path << std::endl;
+        if (!file.error.empty()) {
+            std::cerr << "Error: " << file.error << std::endl;
+            ++failed;
+            return;
+        }
+        std::cout << "Duration: " << std::fixed << std::setprecision(3) << file.duration << "s" << std::endl;
+        for (const auto& segment : file.segments) {
+            if (segment.text.empty()) {
+                continue;
+            }
+            std::cout << "[" << segment.start << "s -- " << segment.end << "s] ";
+            if (segment.language.size() >= 4) {
+                std::cout << segment.language << " ";
+            }
+            std::cout << segment.text << std::endl;
+        }
+        std::cout << std::string(50, '-') << std::endl;
+    });
+
+    std::cout << "\nTranscribed " << stats.files << " files (" << stats.segments << " segments) with "
+              << jobs << " workers\n"
+              << "Audio: " << std::setprecision(2) << stats.audio_seconds << "s, elapsed: "
+              << stats.elapsed_seconds << "s, RTF: " << std::setprecision(4) << stats.rtf() << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+
+// Runs the live recognition pipeline on headless sources (files, stdin,
+// synthetic audio) paced like a capture callback, e.g. for load tests
+int run_sources(const common::ModelConfig& model_config, const std::vector<std::string>& specs, double speed) {
+    auto& registry = recognizer::ModelRegistry::Instance();
+    const bool streaming = model_config.type == "streaming";
+    recognizer::RecognizerHandle recognizer;
+    recognizer::OnlineRecognizerHandle online_recognizer;
+    if (streaming) {
+        online_recognizer = registry.GetOnlineRecognizer(model_config);
+    } else {
+        recognizer = registry.GetRecognizer(model_config);
+    }
+
+    auto translator = translator::CreateTranslator(translator::ConfiguredTranslatorType(model_config), model_config);
+    if (!translator) {
+        std::cerr << "Translation disabled; printing recognized text only." << std::endl;
+    }
+
+    pipeline::RecognitionPipeline recognition(model_config.pipeline);
+    if (streaming) {
+        recognition.set_online_recognizer(online_recognizer.get(), model_config.streaming);
+    } else {
+        recognition.set_window_size(model_config.vad.window_size);
+        recognition.set_recognizer(recognizer.get());
+    }
+    recognition.set_translator(translator.get());
+    recognition.set_output(std::make_shared<output::OutputWriter>(model_config.output));
+
+    std::vector<std::shared_ptr<pipeline::StreamContext>> streams;
+    std::vector<std::unique_ptr<audio::AudioSourcePlayer>> players;
+    for (size_t i = 0; i < specs.size(); ++i) {
+        auto source = audio::IAudioSource::Create(specs[i]);
+        std::cerr << "Source " << i << ": " << source->name() << std::endl;
+        auto stream = recognition.add_stream(static_cast<uint32_t>(i),
+                                             streaming ? nullptr : registry.AcquireVad(model_config));
+        pipeline::StreamContext* context = stream.get();
+        players.push_back(std::make_unique<audio::AudioSourcePlayer>(
+            std::move(source), speed, [&recognition, context](const int16_t* samples, size_t n) {
+                // Retry instead of dropping when playing faster than real time
+                if (context->ring.capacity() - context->ring.size() < n) {
+                    return false;
+                }
+                recognition.push_audio(*context, samples, n);
+                return true;
+            }));
+        streams.push_back(std::move(stream));
+    }
+
+    recognition.start();
+    for (auto& player : players) {
+        player->start();
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    while (g_running) {
+        bool all_finished = std::all_of(players.begin(), players.end(),
+                                        [](const auto& player) { return player->finished(); });
+        if (all_finished) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        poll_trace_toggle();
+    }
+
+    uint64_t samples = 0;
+    for (auto& player : players) {
+        player->stop();
+        samples += player->samples_played();
+    }
+    for (auto& stream : streams) {
+        recognition.remove_stream(stream);
+    }
+    recognition.stop();
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    const double audio_seconds = samples / static_cast<double>(audio::IAudioSource::SAMPLE_RATE);
+    std::cerr << "\nPlayed " << std::fixed << std::setprecision(2) << audio_seconds << "s of audio from "
+              << specs.size() << " sources in " << elapsed << "s" << std::endl;
+    if (model_config.debug) {
+        pipeline::print_latency(std::cerr, recognition.stats().latency);
+        const std::string translator_stats = translator ? translator->stats_summary() : std::string();
+        if (!translator_stats.empty()) {
+            std::cerr << translator_stats << std::endl;
+        }
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+// Service mode: loads the models once, then records whatever the control
+// socket asks for until SIGINT/SIGTERM, so sessions start against warm models
+int run_service(const common::ModelConfig& model_config, const std::string& socket_path) {
+    // Created before the capture, so it outlives the pipeline that drains into it
+    auto translator = translator::CreateTranslator(translator::ConfiguredTranslatorType(model_config), model_config);
+    if (!translator) {
+        std::cerr << "Translation disabled; printing recognized text only." << std::endl;
+    }
+
+    auto audio_capture = audio::IAudioCapture::CreateAudioCapture();
+    if (!audio_capture || !audio_capture->initialize()) {
+        std::cerr << "Failed to initialize audio capture." << std::endl;
+        return 1;
+    }
+
+    auto& registry = recognizer::ModelRegistry::Instance();
+    recognizer::RecognizerHandle recognizer;
+    recognizer::VadHandle vad;
+    recognizer::OnlineRecognizerHandle online_recognizer;
+
+    // One writer for every session, so subscribers stay connected across them
+    auto output = std::make_shared<output::OutputWriter>(model_config.output);
+    audio_capture->set_model_config(model_config);
+    audio_capture->set_output(output);
+
+    if (model_config.type == "streaming") {
+        online_recognizer = registry.GetOnlineRecognizer(model_config);
+        audio_capture->set_model_online_recognizer(online_recognizer.get(), model_config.streaming);
+    } else {
+        recognizer = registry.GetRecognizer(model_config);
+        vad = registry.AcquireVad(model_config);
+        audio_capture->set_model_vad(vad.get(), model_config.vad.window_size);
+        audio_capture->set_model_recognizer(recognizer.get());
+    }
+
+    audio_capture->set_translate(translator.get());
+
+    service::ControlServer server(socket_path, *audio_capture, output);
+    server.start();
+    std::cerr << "Models loaded; listening for commands on " << socket_path << std::endl;
+
+    signal(SIGTERM, signal_handler);
+    bool sessions_active = false;
+    while (g_running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        poll_trace_toggle();
+
+        // A source leaves the pipeline once drained, returning its VAD to the
+        // pool; after the last one, free what only those sessions used
+        const bool active = !audio_capture->get_pipeline_stats().sources.empty();
+        if (sessions_active && !active) {
+            registry.ReleaseUnused();
+        }
+        sessions_active = active;
+    }
+
+    // The server is the only other caller of the capture, so stop it first
+    server.stop();
+    audio_capture->stop_recording();
+    std::cerr << "\nService stopped.\n";
+    return 0;
+}
+
+// Ingest mode: no sound card; every network connection is a session of one
+// shared pipeline until SIGINT/SIGTERM
+int run_ingest(const common::ModelConfig& model_config) {
+    auto& registry = recognizer::ModelRegistry::Instance();
+    const bool streaming = model_config.type == "streaming";
+    recognizer::RecognizerHandle recognizer;
+    recognizer::OnlineRecognizerHandle online_recognizer;
+    if (streaming) {
+        online_recognizer = registry.GetOnlineRecognizer(model_config);
+    } else {
+        recognizer = registry.GetRecognizer(model_config);
+    }
+
+    auto translator = translator::CreateTranslator(translator::ConfiguredTranslatorType(model_config), model_config);
+    if (!translator) {
+        std::cerr << "Translation disabled; printing recognized text only." << std::endl;
+    }
+
+    pipeline::RecognitionPipeline recognition(model_config.pipeline);
+    if (streaming) {
+        recognition.set_online_recognizer(online_recognizer.get(), model_config.streaming);
+    } else {
+        recognition.set_window_size(model_config.vad.window_size);
+        recognition.set_recognizer(recognizer.get());
+    }
+    recognition.set_translator(translator.get());
+    auto output = std::make_shared<output::OutputWriter>(model_config.output);
+    recognition.set_output(output);
+    recognition.start();
+
+    // Sessions reuse idle VADs from the registry's pool
+    ingest::IngestServer server(model_config.ingest, recognition, output,
+                                [&registry, &model_config, streaming]() -> pipeline::VadPtr {
+                                    return streaming ? nullptr : registry.AcquireVad(model_config);
+                                });
+    server.start();
+    std::cerr << "Models loaded; accepting audio on " << model_config.ingest.bind_address;
+    if (model_config.ingest.tcp_port != 0) {
+        std::cerr << " TCP port " << model_config.ingest.tcp_port;
+    }
+    if (model_config.ingest.websocket_port != 0) {
+        std::cerr << " WebSocket port " << model_config.ingest.websocket_port;
+    }
+    std::cerr << std::endl;
+
+    signal(SIGTERM, signal_handler);
+    while (g_running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        poll_trace_toggle();
+    }
+
+    // Connections feed the pipeline, so close them before draining it
+    server.stop();
+    recognition.stop();
+    const ingest::IngestStats stats = server.stats();
+    std::cerr << "\nIngest stopped after " << stats.accepted << " connections (" << stats.rejected
+              << " rejected, " << stats.paused << " backpressure pauses).\n";
+    return 0;
+}
+#endif
+
 int main(int argc, char* argv[]) {
     #ifdef _WIN32
     SetConsoleOutputCP(CP_UTF8);
@@ -71,8 +428,15 @@ int main(int argc, char* argv[]) {
     std::signal(SIGINT, signal_handler);
 
     bool list_sources = false;
-    int source_index = -1;
+    std::vector<int> source_indexes;
     std::string model_config_path;
+    std::vector<std::string> input_files;
+    int jobs = 0;
+    std::vector<std::string> inputs;
+    double speed = 1.0;
+    std::string serve_path;
+    bool ingest = false;
+    bool trace_from_start = false;
 
     // parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -81,12 +445,45 @@ int main(int argc, char* argv[]) {
             list_sources = true;
         } else if (arg == "-s" || arg == "--source") {
             if (i + 1 < argc) {
-                source_index = std::stoi(argv[++i]);
+                std::stringstream ss(argv[++i]);
+                std::string item;
+                while (std::getline(ss, item, ',')) {
+                    if (!item.empty()) {
+                        source_indexes.push_back(std::stoi(item));
+                    }
+                }
             }
         } else if (arg == "-m" || arg == "--model") {
             if (i + 1 < argc) {
                 model_config_path = argv[++i];
             }
+        } else if (arg == "-f" || arg == "--file") {
+            if (i + 1 < argc) {
+                input_files.push_back(argv[++i]);
+            }
+        } else if (arg == "-j" || arg == "--jobs") {
+            if (i + 1 < argc) {
+                jobs = std::stoi(argv[++i]);
+            }
+        } else if (arg == "-i" || arg == "--input") {
+            if (i + 1 < argc) {
+                inputs.push_back(argv[++i]);
+            }
+        } else if (arg == "--speed") {
+            if (i + 1 < argc) {
+                speed = std::stod(argv[++i]);
+            }
+        } else if (arg == "--serve") {
+            if (i + 1 < argc) {
+                serve_path = argv[++i];
+            }
+        } else if (arg == "--ingest") {
+            ingest = true;
+        } else if (arg == "--trace") {
+            if (i + 1 < argc) {
+                g_trace_path = argv[++i];
+                trace_from_start = true;
+            }
         } else if (arg == "-h" || arg == "--help") {
             print_usage();
             return 0;
@@ -97,6 +494,14 @@ int main(int argc, char* argv[]) {
         }
     }
 
+#ifndef _WIN32
+    std::signal(SIGUSR1, signal_handler);
+#endif
+    TraceGuard trace_guard;
+    if (trace_from_start) {
+        trace::Start();
+    }
+
     if (list_sources) {
         std::cout << "Listing available audio sources..." << std::endl;
         // Create audio capture instance
@@ -129,6 +534,46 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
+#ifndef _WIN32
+        // Serves whichever mode runs below until it returns
+        std::unique_ptr<metrics::MetricsServer> metrics_server;
+        if (model_config.metrics.port != 0) {
+            metrics_server = std::make_unique<metrics::MetricsServer>(model_config.metrics);
+            metrics_server->start();
+            std::cerr << "Serving metrics on http://" << model_config.metrics.bind_address << ":"
+                      << metrics_server->port() << "/metrics" << std::endl;
+        }
+#endif
+
+        if (!input_files.empty()) {
+            return run_batch(model_config, input_files, jobs);
+        }
+        if (!inputs.empty()) {
+            return run_sources(model_config, inputs, speed);
+        }
+        if (!serve_path.empty()) {
+#ifndef _WIN32
+            return run_service(model_config, serve_path);
+#else
+            std::cerr << "--serve is not supported on this platform." << std::endl;
+            return 1;
+#endif
+        }
+        if (ingest) {
+#ifndef _WIN32
+            return run_ingest(model_config);
+#else
+            std::cerr << "--ingest is not supported on this platform." << std::endl;
+            return 1;
+#endif
+        }
+
+        // Created before the capture, so it outlives the pipeline that drains into it
+        auto translator = translator::CreateTranslator(translator::ConfiguredTranslatorType(model_config), model_config);
+        if (!translator) {
+            std::cerr << "Translation disabled; printing recognized text only." << std::endl;
+        }
+
         // Create audio capture instance
         auto audio_capture = audio::IAudioCapture::CreateAudioCapture();
         if (!audio_capture) {
@@ -141,59 +586,90 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
-        // create recognizer
-        auto recognizer = recognizer::ModelFactory::CreateModel(model_config);
-        if (!recognizer) {
-            std::cerr << "Failed to create speech recognizer." << std::endl;
-            return 1;
-        }
+        // Models are loaded once by the registry and shared by every source;
+        // the handles keep them alive until the end of main
+        auto& registry = recognizer::ModelRegistry::Instance();
+        recognizer::RecognizerHandle recognizer;
+        recognizer::VadHandle vad;
+        recognizer::OnlineRecognizerHandle online_recognizer;
 
-        // create VAD
-        auto vad = recognizer::ModelFactory::CreateVoiceActivityDetector(model_config);
-        if (!vad) {
-            std::cerr << "Failed to create VAD." << std::endl;
-            return 1;
-        }
+        // Pipeline tuning and per-source VAD settings must be applied before any model is attached
+        audio_capture->set_model_config(model_config);
 
-        // Set VAD first
-        audio_capture->set_model_vad(vad, model_config.vad.window_size);
-        
-        // Then set recognizer
-        audio_capture->set_model_recognizer(recognizer);
+        if (model_config.type == "streaming") {
+            // Streaming models find utterance endpoints themselves, so no VAD is loaded
+            online_recognizer = registry.GetOnlineRecognizer(model_config);
+            audio_capture->set_model_online_recognizer(online_recognizer.get(), model_config.streaming);
+        } else {
+            recognizer = registry.GetRecognizer(model_config);
+            vad = registry.AcquireVad(model_config);
 
-        // create translator
-        auto translator = translator::CreateTranslator(translator::TranslatorType::DeepLX, model_config);
-        if (!translator) {
-            std::cerr << "Failed to create translator." << std::endl;
-            return 1;
+            // Set VAD first
+            audio_capture->set_model_vad(vad.get(), model_config.vad.window_size);
+
+            // Then set recognizer
+            audio_capture->set_model_recognizer(recognizer.get());
         }
-        
+
         audio_capture->set_translate(translator.get());
 
-        if (source_index < 0) {
+        if (source_indexes.empty()) {
             std::cerr << "Please specify a valid source index with -s option." << std::endl;
             return 1;
         }
+        for (int source_index : source_indexes) {
+            if (source_index < 0) {
+                std::cerr << "Please specify a valid source index with -s option." << std::endl;
+                return 1;
+            }
+        }
 
         // Set up signal handler
         signal(SIGINT, signal_handler);
         signal(SIGTERM, signal_handler);
 
-        // Start audio capture
-        if (!audio_capture->start_recording_application(source_index)) {
-            std::cerr << "Failed to start audio capture." << std::endl;
-            return 1;
+        // Start audio capture; all sources share the recognizer and translator
+        for (int source_index : source_indexes) {
+            if (!audio_capture->start_recording_application(source_index)) {
+                std::cerr << "Failed to start audio capture." << std::endl;
+                // Earlier sources are already feeding the pipeline
+                audio_capture->stop_recording();
+                return 1;
+            }
         }
 
         // Main processing loop
         while (g_running) {
             // Sleep for a short duration to prevent busy-waiting
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            poll_trace_toggle();
         }
 
         // Cleanup
         audio_capture->stop_recording();
-        std::cout << "\nRecording stopped.\n";
+        std::cerr << "\nRecording stopped.\n";
+
+        if (model_config.debug) {
+            auto stats = audio_capture->get_pipeline_stats();
+            std::cerr << "Pipeline stats (depth/capacity, processed, dropped):\n"
+                      << "  vad:       " << stats.vad.queue_depth << "/" << stats.vad.queue_capacity
+                      << ", " << stats.vad.processed << ", " << stats.vad.dropped << "\n"
+                      << "  decode:    " << stats.decode.queue_depth << "/" << stats.decode.queue_capacity
+                      << ", " << stats.decode.processed << ", " << stats.decode.dropped
+                      << " (" << stats.decode_batches << " batches)\n"
+                      << "  translate: " << stats.translate.queue_depth << "/" << stats.translate.queue_capacity
+                      << ", " << stats.translate.processed << ", " << stats.translate.dropped << "\n"
+                      << "  output:    " << stats.output.queue_depth << "/" << stats.output.queue_capacity
+                      << ", " << stats.output.processed << ", " << stats.output.dropped << "\n"
+                      << "Partial results: " << stats.partial_results << " (" << stats.early_decodes << " early decodes)\n"
+                      << "Heap allocations: capture path " << stats.capture_allocations
+                      << ", segment buffers " << stats.segment_buffer_allocations << "\n";
+            pipeline::print_latency(std::cerr, stats.latency);
+            const std::string translator_stats = translator ? translator->stats_summary() : std::string();
+            if (!translator_stats.empty()) {
+                std::cerr << translator_stats << std::endl;
+            }
+        }
 
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
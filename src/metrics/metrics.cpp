@@ -0,0 +1,251 @@
+#include "metrics/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace metrics {
+
+namespace {
+
+constexpr const char* kCounter = "counter";
+constexpr const char* kGauge = "gauge";
+constexpr const char* kHistogram = "histogram";
+
+bool valid_name(const std::string& name) {
+    if (name.empty() || (name[0] >= '0' && name[0] <= '9')) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == ':';
+    });
+}
+
+void append_value(double value, std::string& out) {
+    if (std::isinf(value)) {
+        out += value > 0 ? "+Inf" : "-Inf";
+        return;
+    }
+    if (std::isnan(value)) {
+        out += "NaN";
+        return;
+    }
+    char buffer[32];
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        std::snprintf(buffer, sizeof(buffer), "%.0f", value);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    }
+    out += buffer;
+}
+
+// Label values escape backslash, quote and newline; HELP text only backslash and newline
+void append_escaped(const std::string& text, bool quote, std::string& out) {
+    for (char c : text) {
+        if (c == '\\') {
+            out += "\\\\";
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '"' && quote) {
+            out += "\\\"";
+        } else {
+            out += c;
+        }
+    }
+}
+
+void append_labels(const Labels& labels, const std::pair<std::string, std::string>* extra, std::string& out) {
+    if (labels.empty() && !extra) {
+        return;
+    }
+    out += '{';
+    bool first = true;
+    auto append = [&out, &first](const std::pair<std::string, std::string>& label) {
+        out += first ? "" : ",";
+        out += label.first + "=\"";
+        append_escaped(label.second, true, out);
+        out += '"';
+        first = false;
+    };
+    for (const auto& label : labels) {
+        append(label);
+    }
+    if (extra) {
+        append(*extra);
+    }
+    out += '}';
+}
+
+void append_sample(const std::string& name, const Labels& labels,
+                   const std::pair<std::string, std::string>* extra, double value, std::string& out) {
+    out += name;
+    append_labels(labels, extra, out);
+    out += ' ';
+    append_value(value, out);
+    out += '\n';
+}
+
+void add(std::atomic<double>& target, double delta) {
+    double value = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(value, value + delta, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+Histogram::Histogram(std::vector<double> bounds)
+    : bounds_(std::move(bounds))
+    , counts_(new std::atomic<uint64_t>[bounds_.size() + 1]) {
+    if (!std::is_sorted(bounds_.begin(), bounds_.end())) {
+        throw std::invalid_argument("Histogram bounds must be ascending");
+    }
+    for (size_t i = 0; i <= bounds_.size(); ++i) {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::observe(double value) {
+    // Buckets are upper-inclusive, as Prometheus' le label says
+    const size_t bucket = static_cast<size_t>(
+        std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin());
+    counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+    add(sum_, value);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.bounds = bounds_;
+    snapshot.counts.resize(bounds_.size() + 1);
+    uint64_t total = 0;
+    for (size_t i = 0; i <= bounds_.size(); ++i) {
+        total += counts_[i].load(std::memory_order_relaxed);
+        snapshot.counts[i] = total;
+    }
+    snapshot.sum = sum_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+Exposition::Family& Exposition::family(const std::string& name, const char* type, const std::string& help) {
+    auto it = families_.find(name);
+    if (it == families_.end()) {
+        it = families_.emplace(name, Family{type, help, std::string()}).first;
+    }
+    return it->second;
+}
+
+void Exposition::counter(const std::string& name, const std::string& help, const Labels& labels, double value) {
+    append_sample(name, labels, nullptr, value, family(name, kCounter, help).samples);
+}
+
+void Exposition::gauge(const std::string& name, const std::string& help, const Labels& labels, double value) {
+    append_sample(name, labels, nullptr, value, family(name, kGauge, help).samples);
+}
+
+void Exposition::histogram(const std::string& name, const std::string& help, const Labels& labels,
+                           const Histogram::Snapshot& snapshot) {
+    std::string& out = family(name, kHistogram, help).samples;
+    for (size_t i = 0; i < snapshot.counts.size(); ++i) {
+        std::string bound;
+        append_value(i < snapshot.bounds.size() ? snapshot.bounds[i] : INFINITY, bound);
+        const std::pair<std::string, std::string> le("le", bound);
+        append_sample(name + "_bucket", labels, &le, static_cast<double>(snapshot.counts[i]), out);
+    }
+    append_sample(name + "_sum", labels, nullptr, snapshot.sum, out);
+    append_sample(name + "_count", labels, nullptr, static_cast<double>(snapshot.counts.back()), out);
+}
+
+std::string Exposition::text() const {
+    std::string out;
+    for (const auto& family : families_) {
+        out += "# HELP " + family.first + " ";
+        append_escaped(family.second.help, false, out);
+        out += "\n# TYPE " + family.first + " " + family.second.type + "\n";
+        out += family.second.samples;
+    }
+    return out;
+}
+
+Registry& Registry::Instance() {
+    static Registry instance;
+    return instance;
+}
+
+Registry::Entry& Registry::entry(const std::string& name, const std::string& help, const Labels& labels,
+                                 const char* type) {
+    if (!valid_name(name)) {
+        throw std::invalid_argument("Invalid metric name: " + name);
+    }
+    auto type_it = types_.emplace(name, type).first;
+    if (type_it->second != type) {
+        throw std::invalid_argument("Metric " + name + " is already a " + type_it->second);
+    }
+
+    std::string key = name;
+    append_labels(labels, nullptr, key);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        it = entries_.emplace(key, Entry{name, help, labels, nullptr, nullptr, nullptr}).first;
+    }
+    return it->second;
+}
+
+Counter& Registry::counter(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& e = entry(name, help, labels, kCounter);
+    if (!e.counter) {
+        e.counter = std::make_unique<Counter>();
+    }
+    return *e.counter;
+}
+
+Gauge& Registry::gauge(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& e = entry(name, help, labels, kGauge);
+    if (!e.gauge) {
+        e.gauge = std::make_unique<Gauge>();
+    }
+    return *e.gauge;
+}
+
+Histogram& Registry::histogram(const std::string& name, const std::string& help, const std::vector<double>& bounds,
+                               const Labels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& e = entry(name, help, labels, kHistogram);
+    if (!e.histogram) {
+        e.histogram = std::make_unique<Histogram>(bounds);
+    }
+    return *e.histogram;
+}
+
+uint64_t Registry::add_collector(Collector collector) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint64_t id = next_collector_id_++;
+    collectors_.emplace(id, std::move(collector));
+    return id;
+}
+
+void Registry::remove_collector(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    collectors_.erase(id);
+}
+
+std::string Registry::render() const {
+    Exposition exposition;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& item : entries_) {
+        const Entry& e = item.second;
+        if (e.counter) {
+            exposition.counter(e.name, e.help, e.labels, static_cast<double>(e.counter->value()));
+        } else if (e.gauge) {
+            exposition.gauge(e.name, e.help, e.labels, e.gauge->value());
+        } else if (e.histogram) {
+            exposition.histogram(e.name, e.help, e.labels, e.histogram->snapshot());
+        }
+    }
+    for (const auto& collector : collectors_) {
+        collector.second(exposition);
+    }
+    return exposition.text();
+}
+
+} // namespace metrics
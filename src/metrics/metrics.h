@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace metrics {
+
+// Process-wide counters, gauges and histograms for alerting, rendered in the
+// Prometheus text exposition format (see MetricsServer for the endpoint).
+// Updates are relaxed atomic operations, cheap enough for the capture
+// callback; registration takes a lock, so hot paths look their metrics up
+// once and keep the reference.
+
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+class Counter {
+public:
+    void inc(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+class Gauge {
+public:
+    void set(double value) { value_.store(value, std::memory_order_relaxed); }
+    void add(double delta) {
+        double value = value_.load(std::memory_order_relaxed);
+        while (!value_.compare_exchange_weak(value, value + delta, std::memory_order_relaxed)) {
+        }
+    }
+    double value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+class Histogram {
+public:
+    struct Snapshot {
+        std::vector<double> bounds;    // Upper bounds, ascending; +Inf is implied
+        std::vector<uint64_t> counts;  // Cumulative, one per bound plus +Inf
+        double sum = 0.0;
+    };
+
+    explicit Histogram(std::vector<double> bounds);
+
+    void observe(double value);
+    // Reads without stopping writers; may be off by the observations in flight
+    Snapshot snapshot() const;
+
+private:
+    const std::vector<double> bounds_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;  // Per bucket, not cumulative
+    std::atomic<double> sum_{0.0};
+};
+
+// Samples of one scrape, grouped into families by metric name
+class Exposition {
+public:
+    void counter(const std::string& name, const std::string& help, const Labels& labels, double value);
+    void gauge(const std::string& name, const std::string& help, const Labels& labels, double value);
+    void histogram(const std::string& name, const std::string& help, const Labels& labels,
+                   const Histogram::Snapshot& snapshot);
+
+    // Families sorted by name, each with its HELP and TYPE lines
+    std::string text() const;
+
+private:
+    struct Family {
+        const char* type;
+        std::string help;
+        std::string samples;
+    };
+
+    Family& family(const std::string& name, const char* type, const std::string& help);
+
+    std::map<std::string, Family> families_;
+};
+
+class Registry {
+public:
+    // Fills in values that live elsewhere, e.g. pipeline queue depths, at scrape time
+    using Collector = std::function<void(Exposition&)>;
+
+    static Registry& Instance();
+
+    // Return the metric with this name and labels, creating it on first use.
+    // Throw std::invalid_argument if the name is invalid or already has another type.
+    // References stay valid for the life of the process.
+    Counter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+    Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels = {});
+    Histogram& histogram(const std::string& name, const std::string& help, const std::vector<double>& bounds,
+                         const Labels& labels = {});
+
+    // Collectors run on the scraping thread; once remove_collector() returns
+    // the collector is not running and will not run again
+    uint64_t add_collector(Collector collector);
+    void remove_collector(uint64_t id);
+
+    std::string render() const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::string help;
+        Labels labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    Entry& entry(const std::string& name, const std::string& help, const Labels& labels, const char* type);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Entry> entries_;  // Keyed by name and labels
+    std::map<std::string, const char*> types_;
+    std::map<uint64_t, Collector> collectors_;
+    uint64_t next_collector_id_ = 1;
+};
+
+} // namespace metrics
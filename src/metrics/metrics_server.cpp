@@ -0,0 +1,159 @@
+#include "metrics/metrics_server.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include "metrics/metrics.h"
+
+namespace metrics {
+
+namespace {
+
+// How often the server thread checks whether it should stop
+constexpr int kPollTimeoutMs = 100;
+
+// A client gets this long to send its request, so a stalled one cannot block scrapes
+constexpr int kRequestTimeoutMs = 1000;
+
+// Longest request header accepted
+constexpr size_t kMaxRequestSize = 8192;
+
+bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+std::string response(const char* status, const char* content_type, const std::string& body) {
+    return std::string("HTTP/1.0 ") + status + "\r\nContent-Type: " + content_type
+         + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+}
+
+} // namespace
+
+MetricsServer::MetricsServer(const common::MetricsConfig& config)
+    : config_(config)
+    , listener_(-1)
+    , port_(0)
+    , running_(false) {
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::start() {
+    if (running_) {
+        return;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(config_.port));
+    if (::inet_pton(AF_INET, config_.bind_address.c_str(), &address.sin_addr) != 1) {
+        throw std::runtime_error("Invalid metrics bind address: " + config_.bind_address);
+    }
+
+    listener_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    const int one = 1;
+    socklen_t length = sizeof(address);
+    if (listener_ < 0 || ::setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0
+        || ::bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(listener_, 16) != 0
+        || ::getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        const std::string reason = std::strerror(errno);
+        if (listener_ >= 0) {
+            ::close(listener_);
+            listener_ = -1;
+        }
+        throw std::runtime_error("Failed to listen for metrics on " + config_.bind_address + ":"
+                                 + std::to_string(config_.port) + ": " + reason);
+    }
+    port_ = ntohs(address.sin_port);
+
+    running_ = true;
+    thread_ = std::thread(&MetricsServer::serve_loop, this);
+}
+
+void MetricsServer::stop() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    ::close(listener_);
+    listener_ = -1;
+}
+
+void MetricsServer::serve_loop() {
+    while (running_) {
+        pollfd fd{listener_, POLLIN, 0};
+        if (::poll(&fd, 1, kPollTimeoutMs) <= 0) {
+            continue;  // Timeout or EINTR
+        }
+        const int client = ::accept4(listener_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client >= 0) {
+            serve_client(client);
+            ::close(client);
+        }
+    }
+}
+
+void MetricsServer::serve_client(int fd) {
+    timeval timeout{kRequestTimeoutMs / 1000, (kRequestTimeoutMs % 1000) * 1000};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // Only the request line matters, but read the whole header so closing
+    // does not reset the connection before the client reads the response
+    std::string request;
+    char chunk[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos) {
+        const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0 || request.size() + static_cast<size_t>(n) > kMaxRequestSize) {
+            return;
+        }
+        request.append(chunk, static_cast<size_t>(n));
+    }
+
+    const std::string line = request.substr(0, request.find_first_of("\r\n"));
+    const size_t method_end = line.find(' ');
+    const size_t target_end = line.find(' ', method_end + 1);
+    const std::string method = line.substr(0, method_end);
+    const std::string target = method_end == std::string::npos
+        ? std::string() : line.substr(method_end + 1, target_end - method_end - 1);
+    const std::string path = target.substr(0, target.find('?'));
+
+    if (path != "/metrics") {
+        send_all(fd, response("404 Not Found", "text/plain", "Not found; metrics are at /metrics\n"));
+    } else if (method != "GET" && method != "HEAD") {
+        send_all(fd, response("405 Method Not Allowed", "text/plain", "Only GET is supported\n"));
+    } else {
+        std::string reply = response("200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                                     Registry::Instance().render());
+        if (method == "HEAD") {
+            reply.erase(reply.find("\r\n\r\n") + 4);
+        }
+        send_all(fd, reply);
+    }
+}
+
+} // namespace metrics
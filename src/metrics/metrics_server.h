@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <common/model_config.h>
+
+namespace metrics {
+
+// Minimal HTTP/1.0 endpoint for Prometheus: GET /metrics answers with
+// Registry::Instance().render(), anything else with 404 or 405. Scrapes
+// are rare, so one thread serves them one at a time and closes each
+// connection after the response.
+class MetricsServer {
+public:
+    explicit MetricsServer(const common::MetricsConfig& config);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Throws std::runtime_error if the address cannot be bound. Port 0 binds
+    // any free port, see port().
+    void start();
+    void stop();
+
+    // The bound port once started
+    int port() const { return port_; }
+
+private:
+    void serve_loop();
+    void serve_client(int fd);
+
+    common::MetricsConfig config_;
+    int listener_;
+    int port_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+} // namespace metrics
@@ -0,0 +1,203 @@
+#include "output/output_destination.h"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace output {
+
+namespace {
+
+const char kSocketPrefix[] = "unix:";
+
+class StdoutDestination : public OutputDestination {
+public:
+    explicit StdoutDestination(const std::string& header) {
+        write(header);
+    }
+
+    void write(const std::string& data) override {
+        std::cout.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    void flush() override {
+        std::cout.flush();
+    }
+};
+
+class FileDestination : public OutputDestination {
+public:
+    FileDestination(const std::string& path, const std::string& header)
+        : file_(path, std::ios::binary | std::ios::trunc) {
+        if (!file_) {
+            throw std::runtime_error("Failed to open output file " + path);
+        }
+        write(header);
+    }
+
+    void write(const std::string& data) override {
+        file_.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    void flush() override {
+        file_.flush();
+    }
+
+private:
+    std::ofstream file_;
+};
+
+#ifndef _WIN32
+// Sends without blocking; false if the socket buffer filled up or the peer left
+bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// One connected client. A client that cannot keep up is disconnected, as in
+// UnixSocketDestination.
+class SocketDestination : public OutputDestination {
+public:
+    SocketDestination(int fd, const std::string& header)
+        : fd_(fd) {
+        write(header);
+    }
+
+    ~SocketDestination() override {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    void write(const std::string& data) override {
+        if (fd_ >= 0 && !data.empty() && !send_all(fd_, data)) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    bool closed() const override {
+        return fd_ < 0;
+    }
+
+private:
+    int fd_;
+};
+
+// Listens on a Unix domain socket and sends everything to each connected
+// client. Clients are accepted between writes; one whose socket buffer is
+// full is disconnected rather than waited for, since a record cut short
+// would corrupt its stream.
+class UnixSocketDestination : public OutputDestination {
+public:
+    UnixSocketDestination(const std::string& path, const std::string& header)
+        : path_(path)
+        , header_(header)
+        , listener_(-1) {
+        sockaddr_un address{};
+        if (path.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Output socket path is too long: " + path);
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        listener_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        ::unlink(path.c_str());  // Left behind by an earlier run
+        if (listener_ < 0 || ::bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+            || ::listen(listener_, 16) != 0) {
+            const std::string reason = std::strerror(errno);
+            if (listener_ >= 0) {
+                ::close(listener_);
+            }
+            throw std::runtime_error("Failed to listen on output socket " + path + ": " + reason);
+        }
+    }
+
+    ~UnixSocketDestination() override {
+        for (int client : clients_) {
+            ::close(client);
+        }
+        ::close(listener_);
+        ::unlink(path_.c_str());
+    }
+
+    void write(const std::string& data) override {
+        accept_clients();
+        for (size_t i = 0; i < clients_.size();) {
+            if (send_all(clients_[i], data)) {
+                ++i;
+            } else {
+                ::close(clients_[i]);
+                clients_.erase(clients_.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+        }
+    }
+
+    void flush() override {
+        accept_clients();
+    }
+
+private:
+    void accept_clients() {
+        while (true) {
+            const int client = ::accept4(listener_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (client < 0) {
+                return;  // EAGAIN: nobody waiting
+            }
+            if (!header_.empty() && !send_all(client, header_)) {
+                ::close(client);
+                continue;
+            }
+            clients_.push_back(client);
+        }
+    }
+
+    std::string path_;
+    std::string header_;
+    int listener_;
+    std::vector<int> clients_;
+};
+#endif
+
+} // namespace
+
+std::unique_ptr<OutputDestination> OutputDestination::Create(const std::string& destination,
+                                                             const std::string& header) {
+    if (destination.empty()) {
+        return std::make_unique<StdoutDestination>(header);
+    }
+    if (destination.compare(0, sizeof(kSocketPrefix) - 1, kSocketPrefix) == 0) {
+#ifndef _WIN32
+        return std::make_unique<UnixSocketDestination>(destination.substr(sizeof(kSocketPrefix) - 1), header);
+#else
+        throw std::runtime_error("Unix domain socket output is not supported on this platform");
+#endif
+    }
+    return std::make_unique<FileDestination>(destination, header);
+}
+
+#ifndef _WIN32
+std::unique_ptr<OutputDestination> OutputDestination::FromSocket(int fd, const std::string& header) {
+    return std::make_unique<SocketDestination>(fd, header);
+}
+#endif
+
+} // namespace output
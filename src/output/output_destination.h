@@ -0,0 +1,33 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace output {
+
+// Where formatted output goes. Only the output writer thread calls into a
+// destination, so implementations may block without stalling recognition.
+class OutputDestination {
+public:
+    virtual ~OutputDestination() = default;
+
+    // Empty: stdout. "unix:<path>": a Unix domain socket at path. Anything
+    // else: a file, replaced. header starts every stream, e.g. "WEBVTT".
+    // Throws std::runtime_error if the destination cannot be opened.
+    static std::unique_ptr<OutputDestination> Create(const std::string& destination, const std::string& header);
+
+#ifndef _WIN32
+    // A connected stream socket, e.g. a control client that subscribed to
+    // results. Takes ownership of fd; see closed().
+    static std::unique_ptr<OutputDestination> FromSocket(int fd, const std::string& header);
+#endif
+
+    // data is one or more complete records
+    virtual void write(const std::string& data) = 0;
+    virtual void flush() {}
+
+    // True once the reader went away or fell behind; nothing more is written
+    virtual bool closed() const { return false; }
+};
+
+} // namespace output
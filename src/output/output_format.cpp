@@ -0,0 +1,175 @@
+#include "output/output_format.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace output {
+
+namespace {
+
+void append_seconds(float seconds, std::string& out) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", seconds);
+    out += buffer;
+}
+
+// HH:MM:SS,mmm for SRT, HH:MM:SS.mmm for WebVTT
+void append_cue_time(float seconds, char separator, std::string& out) {
+    const int64_t ms = std::llround(std::max(0.0f, seconds) * 1000.0);
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%02" PRId64 ":%02d:%02d%c%03d",
+                  ms / 3600000, static_cast<int>(ms / 60000 % 60), static_cast<int>(ms / 1000 % 60),
+                  separator, static_cast<int>(ms % 1000));
+    out += buffer;
+}
+
+// A cue ends at its first blank line, so keep each text on one line
+void append_cue_line(const std::string& text, std::string& out) {
+    for (char c : text) {
+        out += (c == '\n' || c == '\r') ? ' ' : c;
+    }
+    out += '\n';
+}
+
+} // namespace
+
+std::unique_ptr<OutputFormat> OutputFormat::Create(const std::string& name) {
+    if (name == "text") {
+        return std::make_unique<TextFormat>();
+    }
+    if (name == "jsonl") {
+        return std::make_unique<JsonlFormat>();
+    }
+    if (name == "srt" || name == "vtt") {
+        return std::make_unique<SubtitleFormat>(name == "vtt");
+    }
+    throw std::invalid_argument("Unknown output format: " + name);
+}
+
+bool TextFormat::append(const OutputRecord& record, std::string& out) {
+    if (record.end_of_stream) {
+        return false;
+    }
+    if (record.partial) {
+        // Text the previous partial agreed on is settled; the rest is bracketed as tentative
+        out += "[Partial] Source " + std::to_string(record.source_id) + " ";
+        append_seconds(record.start, out);
+        out += "s -- ";
+        append_seconds(record.end, out);
+        out += "s: ";
+        out.append(record.text, 0, record.stable_size);
+        if (record.stable_size < record.text.size()) {
+            out += "[";
+            out.append(record.text, record.stable_size, std::string::npos);
+            out += "]";
+        }
+        out += "\n";
+        return true;
+    }
+
+    out += "\n[Recognition Result]\nSource: " + std::to_string(record.source_id) + "\nTime: ";
+    append_seconds(record.start, out);
+    out += "s -- ";
+    append_seconds(record.end, out);
+    out += "s\nText: " + record.text + "\n";
+    if (!record.language.empty()) {
+        out += "Language Code: " + record.language + "\n";
+    }
+    if (!record.target_lang.empty()) {
+        out += "Target Language: " + record.target_lang + "\n";
+    }
+    if (!record.translation.empty()) {
+        out += "Translated Text: " + record.translation + "\n";
+    }
+    if (!record.translation_error.empty()) {
+        out += "Translation Error: " + record.translation_error + "\n";
+    }
+    out += std::string(50, '-') + "\n";
+    return true;
+}
+
+bool JsonlFormat::append(const OutputRecord& record, std::string& out) {
+    if (record.end_of_stream) {
+        out += "{\"type\":\"end\",\"source\":" + std::to_string(record.source_id) + "}\n";
+        return true;
+    }
+    out += record.partial ? "{\"type\":\"partial\"" : "{\"type\":\"final\"";
+    out += ",\"source\":" + std::to_string(record.source_id);
+    out += ",\"sequence\":" + std::to_string(record.sequence);
+    out += ",\"start\":";
+    append_seconds(record.start, out);
+    out += ",\"end\":";
+    append_seconds(record.end, out);
+    out += ",\"text\":";
+    AppendJsonString(record.text, out);
+    if (record.partial) {
+        out += ",\"stable_length\":" + std::to_string(record.stable_size);
+    }
+    if (!record.language.empty()) {
+        out += ",\"language\":";
+        AppendJsonString(record.language, out);
+    }
+    if (!record.target_lang.empty()) {
+        out += ",\"target_language\":";
+        AppendJsonString(record.target_lang, out);
+    }
+    if (!record.translation.empty()) {
+        out += ",\"translation\":";
+        AppendJsonString(record.translation, out);
+    }
+    if (!record.translation_error.empty()) {
+        out += ",\"translation_error\":";
+        AppendJsonString(record.translation_error, out);
+    }
+    out += "}\n";
+    return true;
+}
+
+std::string SubtitleFormat::header() const {
+    return vtt_ ? "WEBVTT\n\n" : std::string();
+}
+
+bool SubtitleFormat::append(const OutputRecord& record, std::string& out) {
+    if (record.partial || record.end_of_stream || record.text.empty()) {
+        return false;
+    }
+    const char separator = vtt_ ? '.' : ',';
+    out += std::to_string(next_index_++) + "\n";
+    append_cue_time(record.start, separator, out);
+    out += " --> ";
+    append_cue_time(record.end, separator, out);
+    out += "\n";
+    append_cue_line(record.text, out);
+    if (!record.translation.empty()) {
+        append_cue_line(record.translation, out);
+    }
+    out += "\n";
+    return true;
+}
+
+void AppendJsonString(const std::string& text, std::string& out) {
+    static const char kHex[] = "0123456789abcdef";
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += "\\u00";
+                    out += kHex[(c >> 4) & 0xf];
+                    out += kHex[c & 0xf];
+                } else {
+                    out += c;  // UTF-8 passes through unchanged
+                }
+        }
+    }
+    out += '"';
+}
+
+} // namespace output
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace output {
+
+// One recognition result as handed to the output writer. Translation has
+// already finished, so formatting never waits on the network.
+struct OutputRecord {
+    uint32_t source_id = 0;
+    uint64_t sequence = 0;   // Per-session order of final results
+    bool partial = false;    // Hypothesis of a still open utterance
+    bool end_of_stream = false;  // The session ended; nothing more follows for it
+    size_t stable_size = 0;  // Partials: leading bytes of text the previous partial agreed on
+    float start = 0.0f;      // Seconds since the session started
+    float end = 0.0f;
+    std::string text;
+    std::string language;           // Upper-case code, empty if unknown
+    std::string target_lang;        // Empty when no translation was requested
+    std::string translation;        // Empty if not translated
+    std::string translation_error;  // Why the translation failed, if it did
+};
+
+// Turns records into the bytes of one output format. Formats keep state
+// (e.g. subtitle numbering), so each is used by one writer thread only.
+class OutputFormat {
+public:
+    virtual ~OutputFormat() = default;
+
+    // Throws std::invalid_argument for names other than "text", "jsonl", "srt" and "vtt"
+    static std::unique_ptr<OutputFormat> Create(const std::string& name);
+
+    // Written once at the start of every output stream, e.g. to each socket client
+    virtual std::string header() const { return std::string(); }
+
+    // Appends the record to out; returns false if the format skips records of its kind
+    virtual bool append(const OutputRecord& record, std::string& out) = 0;
+};
+
+// The human-readable layout printed to the console
+class TextFormat : public OutputFormat {
+public:
+    bool append(const OutputRecord& record, std::string& out) override;
+};
+
+// One JSON object per line; empty fields are left out. The end of a
+// session is written as {"type":"end","source":N}.
+class JsonlFormat : public OutputFormat {
+public:
+    bool append(const OutputRecord& record, std::string& out) override;
+};
+
+// SRT or WebVTT cues of final results, the translation on a second line.
+// Cue times are per session, so mixing several sources in one file only
+// makes sense for players that accept overlapping cues.
+class SubtitleFormat : public OutputFormat {
+public:
+    explicit SubtitleFormat(bool vtt) : vtt_(vtt), next_index_(1) {}
+
+    std::string header() const override;
+    bool append(const OutputRecord& record, std::string& out) override;
+
+private:
+    bool vtt_;
+    uint64_t next_index_;
+};
+
+// Appends text as a quoted JSON string
+void AppendJsonString(const std::string& text, std::string& out);
+
+} // namespace output
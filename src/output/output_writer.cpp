@@ -0,0 +1,149 @@
+#include "output/output_writer.h"
+#include "trace/trace.h"
+#include <chrono>
+
+namespace output {
+
+namespace {
+
+// How long the writer sleeps when nothing is queued. Output is for people
+// and subtitle players, so a few milliseconds are not noticeable.
+constexpr auto kWritePollInterval = std::chrono::milliseconds(5);
+
+// How long submit() waits between attempts while the queue is full
+constexpr auto kSubmitRetryInterval = std::chrono::milliseconds(1);
+
+} // namespace
+
+OutputWriter::OutputWriter(const common::OutputConfig& config)
+    : format_(OutputFormat::Create(config.format))
+    , destination_(OutputDestination::Create(config.destination, format_->header()))
+    , partial_results_(config.partial_results)
+    , has_new_subscribers_(false)
+    , subscriber_count_(0)
+    , queue_(static_cast<size_t>(config.queue_capacity > 0 ? config.queue_capacity : 1))
+    , running_(false)
+    , stopping_(false)
+    , written_(0)
+    , dropped_(0) {
+}
+
+OutputWriter::~OutputWriter() {
+    stop();
+}
+
+void OutputWriter::start() {
+    if (running_) {
+        return;
+    }
+    stopping_ = false;
+    running_ = true;
+    thread_ = std::thread(&OutputWriter::write_loop, this);
+}
+
+void OutputWriter::stop() {
+    if (!running_) {
+        return;
+    }
+    stopping_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    running_ = false;
+}
+
+bool OutputWriter::try_submit(OutputRecord& record) {
+    if (!queue_.try_push(record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void OutputWriter::submit(OutputRecord& record) {
+    while (!queue_.try_push(record)) {
+        if (!running_ || stopping_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::this_thread::sleep_for(kSubmitRetryInterval);
+    }
+}
+
+void OutputWriter::add_subscriber(std::unique_ptr<OutputFormat> format,
+                                  std::unique_ptr<OutputDestination> destination,
+                                  std::optional<uint32_t> source) {
+    std::lock_guard<std::mutex> lock(new_subscribers_mutex_);
+    new_subscribers_.push_back(Subscriber{std::move(format), std::move(destination), source, std::string()});
+    subscriber_count_.fetch_add(1, std::memory_order_relaxed);
+    has_new_subscribers_.store(true, std::memory_order_release);
+}
+
+size_t OutputWriter::subscribers() const {
+    return subscriber_count_.load(std::memory_order_relaxed);
+}
+
+void OutputWriter::take_new_subscribers() {
+    if (!has_new_subscribers_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(new_subscribers_mutex_);
+    for (auto& subscriber : new_subscribers_) {
+        subscribers_.push_back(std::move(subscriber));
+    }
+    new_subscribers_.clear();
+    has_new_subscribers_.store(false, std::memory_order_relaxed);
+}
+
+void OutputWriter::write_loop() {
+    trace::SetThreadName("output_writer");
+    OutputRecord record;
+    std::string buffer;
+    while (true) {
+        // Read stopping_ first: records submitted before stop() are then
+        // guaranteed to be seen by the drain below
+        const bool stopping = stopping_.load();
+        take_new_subscribers();
+        uint64_t records = 0;
+        while (queue_.try_pop(record)) {
+            format_->append(record, buffer);
+            for (auto& subscriber : subscribers_) {
+                if (!subscriber.source || *subscriber.source == record.source_id) {
+                    subscriber.format->append(record, subscriber.buffer);
+                }
+            }
+            ++records;
+        }
+        if (!buffer.empty()) {
+            trace::Span span("output_write", "output");
+            destination_->write(buffer);
+            destination_->flush();
+            buffer.clear();
+        }
+        for (size_t i = 0; i < subscribers_.size();) {
+            Subscriber& subscriber = subscribers_[i];
+            if (!subscriber.buffer.empty()) {
+                subscriber.destination->write(subscriber.buffer);
+                subscriber.destination->flush();
+                subscriber.buffer.clear();
+            }
+            if (subscriber.destination->closed()) {
+                subscribers_.erase(subscribers_.begin() + static_cast<std::ptrdiff_t>(i));
+                subscriber_count_.fetch_sub(1, std::memory_order_relaxed);
+            } else {
+                ++i;
+            }
+        }
+        written_.fetch_add(records, std::memory_order_relaxed);
+
+        if (records == 0) {
+            if (stopping) {
+                break;
+            }
+            std::this_thread::sleep_for(kWritePollInterval);
+        }
+    }
+    destination_->flush();
+}
+
+} // namespace output
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <common/model_config.h>
+#include <common/spsc_ring_buffer.h>
+#include "output/output_destination.h"
+#include "output/output_format.h"
+
+namespace output {
+
+// Hands recognition results to a writer thread that formats them and does
+// all output I/O, so a slow terminal, file or socket client never holds up
+// the pipeline. The handoff is a lock-free SPSC ring: submissions come from
+// one thread (the pipeline's output worker) and never take a lock. The
+// writer formats everything queued into one buffer and writes and flushes
+// it once, instead of flushing every line.
+class OutputWriter {
+public:
+    // Throws if the format is unknown or the destination cannot be opened
+    explicit OutputWriter(const common::OutputConfig& config);
+    ~OutputWriter();
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    void start();
+    // Writes everything already submitted, then joins the writer thread
+    void stop();
+
+    // Producer side, one thread only. Never blocks: returns false and counts
+    // a drop when the queue is full. For partial results, which the next one
+    // supersedes anyway.
+    bool try_submit(OutputRecord& record);
+    // Waits for room instead of dropping, for final results; this only holds
+    // up the calling output worker, never recognition itself
+    void submit(OutputRecord& record);
+
+    // Also writes every later record to destination in its own format, e.g.
+    // for a control client that subscribed to results; with source set, only
+    // the records of that source. Dropped once the destination reports
+    // closed(). Thread-safe.
+    void add_subscriber(std::unique_ptr<OutputFormat> format, std::unique_ptr<OutputDestination> destination,
+                        std::optional<uint32_t> source = std::nullopt);
+    size_t subscribers() const;
+
+    bool partial_results() const { return partial_results_; }
+
+    size_t queue_depth() const { return queue_.size(); }
+    size_t queue_capacity() const { return queue_.capacity(); }
+    uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Subscriber {
+        std::unique_ptr<OutputFormat> format;
+        std::unique_ptr<OutputDestination> destination;
+        std::optional<uint32_t> source;
+        std::string buffer;
+    };
+
+    void write_loop();
+    // Moves newly added subscribers into the writer thread's list
+    void take_new_subscribers();
+
+    std::unique_ptr<OutputFormat> format_;
+    std::unique_ptr<OutputDestination> destination_;
+    bool partial_results_;
+
+    std::vector<Subscriber> subscribers_;  // Writer thread only
+    mutable std::mutex new_subscribers_mutex_;
+    std::vector<Subscriber> new_subscribers_;
+    std::atomic<bool> has_new_subscribers_;
+    std::atomic<size_t> subscriber_count_;
+
+    common::SpscRingBuffer<OutputRecord> queue_;
+    std::atomic<bool> running_;
+    std::atomic<bool> stopping_;
+    std::thread thread_;
+
+    std::atomic<uint64_t> written_;
+    std::atomic<uint64_t> dropped_;
+};
+
+} // namespace output
@@ -0,0 +1,146 @@
+#include "pipeline/batch_transcriber.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <recognizer/model_registry.h>
+
+namespace pipeline {
+
+BatchTranscriber::BatchTranscriber(const common::ModelConfig& config,
+                                   const SherpaOnnxOfflineRecognizer* recognizer,
+                                   size_t num_threads)
+    : config_(config)
+    , recognizer_(recognizer)
+    , scheduler_(config.pipeline.decode_batch_size, 0)
+    , pool_(num_threads) {
+}
+
+std::vector<std::string> BatchTranscriber::CollectInputs(const std::vector<std::string>& paths) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    for (const auto& path : paths) {
+        if (!fs::is_directory(path)) {
+            files.push_back(path);
+            continue;
+        }
+        std::vector<std::string> entries;
+        for (const auto& entry : fs::directory_iterator(path)) {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if (entry.is_regular_file() && extension == ".wav") {
+                entries.push_back(entry.path().string());
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+        files.insert(files.end(), entries.begin(), entries.end());
+    }
+    return files;
+}
+
+BatchStats BatchTranscriber::run(const std::vector<std::string>& files,
+                                 const std::function<void(const BatchFileResult&)>& on_file) {
+    const auto started = std::chrono::steady_clock::now();
+
+    std::vector<std::future<FileJob>> jobs;
+    jobs.reserve(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        jobs.push_back(pool_.submit([this, &files, i]() { return split_file(files[i], i); }));
+    }
+
+    // Only this thread waits on futures, so pool workers never block on each other
+    BatchStats stats;
+    for (auto& job_future : jobs) {
+        FileJob job = job_future.get();
+        for (auto& chunk : job.chunks) {
+            try {
+                std::vector<RecognitionResult> results = chunk.get();
+                for (auto& result : results) {
+                    job.result.segments.push_back(std::move(result));
+                }
+            } catch (const std::exception& e) {
+                job.result.error = e.what();
+            }
+        }
+
+        ++stats.files;
+        stats.segments += job.result.segments.size();
+        stats.audio_seconds += job.result.duration;
+        on_file(job.result);
+    }
+
+    stats.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return stats;
+}
+
+BatchTranscriber::FileJob BatchTranscriber::split_file(const std::string& path, uint64_t file_index) {
+    FileJob job;
+    job.result.path = path;
+
+    const SherpaOnnxWave* wave = SherpaOnnxReadWave(path.c_str());
+    if (!wave) {
+        job.result.error = "Failed to read wave file";
+        return job;
+    }
+    if (wave->sample_rate != SAMPLE_RATE) {
+        job.result.error = "Unsupported sample rate " + std::to_string(wave->sample_rate)
+            + " Hz, expected " + std::to_string(SAMPLE_RATE) + " Hz";
+        SherpaOnnxFreeWave(wave);
+        return job;
+    }
+    job.result.duration = wave->num_samples / static_cast<double>(SAMPLE_RATE);
+
+    std::vector<SpeechSegment> segments;
+    try {
+        recognizer::VadHandle vad = recognizer::ModelRegistry::Instance().AcquireVad(config_);
+        const int32_t window_size = config_.vad.window_size;
+
+        auto drain = [&]() {
+            while (!SherpaOnnxVoiceActivityDetectorEmpty(vad.get())) {
+                const SherpaOnnxSpeechSegment* segment = SherpaOnnxVoiceActivityDetectorFront(vad.get());
+                if (segment) {
+                    SpeechSegment item;
+                    item.source_id = static_cast<uint32_t>(file_index);
+                    item.session_id = file_index;
+                    item.sequence = segments.size();
+                    item.start = segment->start;
+                    item.samples.assign(segment->samples, segment->samples + segment->n);
+                    segments.push_back(std::move(item));
+                    SherpaOnnxDestroySpeechSegment(segment);
+                }
+                SherpaOnnxVoiceActivityDetectorPop(vad.get());
+            }
+        };
+
+        for (int32_t offset = 0; offset + window_size <= wave->num_samples; offset += window_size) {
+            SherpaOnnxVoiceActivityDetectorAcceptWaveform(vad.get(), wave->samples + offset, window_size);
+            drain();
+        }
+        SherpaOnnxVoiceActivityDetectorFlush(vad.get());
+        drain();
+    } catch (const std::exception& e) {
+        job.result.error = e.what();
+    }
+    SherpaOnnxFreeWave(wave);
+
+    // Decode in batches on the pool; submitted from a worker, so they land on
+    // this worker's deque and idle workers steal them
+    const size_t batch_size = static_cast<size_t>(std::max(1, config_.pipeline.decode_batch_size));
+    for (size_t begin = 0; begin < segments.size(); begin += batch_size) {
+        const size_t end = std::min(segments.size(), begin + batch_size);
+        auto chunk = std::make_shared<std::vector<SpeechSegment>>(
+            std::make_move_iterator(segments.begin() + begin),
+            std::make_move_iterator(segments.begin() + end));
+        job.chunks.push_back(pool_.submit([this, chunk]() { return decode_chunk(*chunk); }));
+    }
+    return job;
+}
+
+std::vector<RecognitionResult> BatchTranscriber::decode_chunk(const std::vector<SpeechSegment>& segments) const {
+    std::vector<RecognitionResult> results;
+    scheduler_.decode(recognizer_, segments, SAMPLE_RATE, results);
+    return results;
+}
+
+} // namespace pipeline
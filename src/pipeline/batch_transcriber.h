@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <common/model_config.h>
+#include <common/thread_pool.h>
+#include "pipeline/pipeline_types.h"
+#include "pipeline/decode_scheduler.h"
+#include "sherpa-onnx/c-api/c-api.h"
+
+namespace pipeline {
+
+struct BatchFileResult {
+    std::string path;
+    double duration = 0.0;  // Seconds of audio in the file
+    std::vector<RecognitionResult> segments;
+    std::string error;  // Non-empty if the file could not be transcribed
+};
+
+struct BatchStats {
+    size_t files = 0;
+    size_t segments = 0;
+    double audio_seconds = 0.0;
+    double elapsed_seconds = 0.0;
+
+    // Real-time factor: processing time per second of audio, lower is faster
+    double rtf() const { return audio_seconds > 0.0 ? elapsed_seconds / audio_seconds : 0.0; }
+};
+
+// Offline transcription of recorded files. Each file is split into VAD
+// segments on a pool worker, and the segments are decoded in batches of
+// decode_batch_size as further pool tasks, so a long file spreads over all
+// workers while short files keep idle workers busy through work stealing.
+// Results are delivered in input order.
+class BatchTranscriber {
+public:
+    static constexpr int SAMPLE_RATE = 16000;
+
+    BatchTranscriber(const common::ModelConfig& config,
+                     const SherpaOnnxOfflineRecognizer* recognizer,
+                     size_t num_threads);
+
+    // Calls on_file from the calling thread, in input order, as soon as a file
+    // and all files before it are done
+    BatchStats run(const std::vector<std::string>& files,
+                   const std::function<void(const BatchFileResult&)>& on_file);
+
+    // Expands directories to the .wav files they contain, sorted by name
+    static std::vector<std::string> CollectInputs(const std::vector<std::string>& paths);
+
+private:
+    struct FileJob {
+        BatchFileResult result;
+        std::vector<std::future<std::vector<RecognitionResult>>> chunks;
+    };
+
+    FileJob split_file(const std::string& path, uint64_t file_index);
+    std::vector<RecognitionResult> decode_chunk(const std::vector<SpeechSegment>& segments) const;
+
+    common::ModelConfig config_;
+    const SherpaOnnxOfflineRecognizer* recognizer_;
+    DecodeScheduler scheduler_;
+    common::ThreadPool pool_;
+};
+
+} // namespace pipeline
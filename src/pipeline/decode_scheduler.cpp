@@ -0,0 +1,93 @@
+#include "pipeline/decode_scheduler.h"
+#include <algorithm>
+#include <iostream>
+
+namespace pipeline {
+
+DecodeScheduler::DecodeScheduler(int max_batch_size, int max_delay_ms)
+    : max_batch_size_(static_cast<size_t>(std::max(1, max_batch_size)))
+    , max_delay_(std::max(0, max_delay_ms)) {
+}
+
+bool DecodeScheduler::next_batch(common::BoundedQueue<SpeechSegment>& queue,
+                                 std::vector<SpeechSegment>& batch) const {
+    batch.clear();
+
+    SpeechSegment segment;
+    if (!queue.pop(segment)) {
+        return false;
+    }
+    batch.push_back(std::move(segment));
+
+    const auto deadline = std::chrono::steady_clock::now() + max_delay_;
+    while (batch.size() < max_batch_size_ && queue.pop_until(segment, deadline)) {
+        batch.push_back(std::move(segment));
+    }
+    return true;
+}
+
+void DecodeScheduler::decode(const SherpaOnnxOfflineRecognizer* recognizer,
+                             const std::vector<SpeechSegment>& batch,
+                             int sample_rate,
+                             std::vector<RecognitionResult>& results) const {
+    results.assign(batch.size(), RecognitionResult());
+    const auto decode_start = SegmentTimestamps::Clock::now();
+
+    std::vector<const SherpaOnnxOfflineStream*> streams(batch.size(), nullptr);
+    std::vector<const SherpaOnnxOfflineStream*> ready;
+    ready.reserve(batch.size());
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        // End-of-stream markers carry no audio and only pass through
+        if (batch[i].end_of_stream || batch[i].samples.empty()) {
+            continue;
+        }
+        const SherpaOnnxOfflineStream* stream = SherpaOnnxCreateOfflineStream(recognizer);
+        if (!stream) {
+            std::cerr << "[ERROR] Failed to create stream for speech segment" << std::endl;
+            continue;
+        }
+        SherpaOnnxAcceptWaveformOffline(
+            stream,
+            sample_rate,
+            batch[i].samples.data(),
+            static_cast<int32_t>(batch[i].samples.size())
+        );
+        streams[i] = stream;
+        ready.push_back(stream);
+    }
+
+    if (!ready.empty()) {
+        SherpaOnnxDecodeMultipleOfflineStreams(recognizer, ready.data(), static_cast<int32_t>(ready.size()));
+    }
+    const auto decode_end = SegmentTimestamps::Clock::now();
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        RecognitionResult& item = results[i];
+        item.source_id = batch[i].source_id;
+        item.session_id = batch[i].session_id;
+        item.sequence = batch[i].sequence;
+        item.end_of_stream = batch[i].end_of_stream;
+        item.start = batch[i].start / static_cast<float>(sample_rate);
+        item.end = item.start + batch[i].samples.size() / static_cast<float>(sample_rate);
+        item.timestamps = batch[i].timestamps;
+        item.timestamps.decode_start = decode_start;
+        item.timestamps.decode_end = decode_end;
+
+        if (!streams[i]) {
+            continue;
+        }
+
+        const SherpaOnnxOfflineRecognizerResult* result = SherpaOnnxGetOfflineStreamResult(streams[i]);
+        if (result && result->text) {
+            item.text = result->text;
+            if (result->lang) {
+                item.language = result->lang;
+            }
+        }
+        SherpaOnnxDestroyOfflineRecognizerResult(result);
+        SherpaOnnxDestroyOfflineStream(streams[i]);
+    }
+}
+
+} // namespace pipeline
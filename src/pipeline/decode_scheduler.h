@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <common/bounded_queue.h>
+#include "pipeline/pipeline_types.h"
+#include "sherpa-onnx/c-api/c-api.h"
+
+namespace pipeline {
+
+// Groups ready speech segments so they are decoded with a single
+// SherpaOnnxDecodeMultipleOfflineStreams call. A batch is closed when it
+// reaches max_batch_size or when max_delay has passed since its first segment;
+// a zero delay only batches segments that are already queued, adding no latency.
+class DecodeScheduler {
+public:
+    DecodeScheduler(int max_batch_size, int max_delay_ms);
+
+    // Blocks for the first segment, then gathers more until the batch is full
+    // or the deadline passes. Returns false once the queue is closed and drained.
+    bool next_batch(common::BoundedQueue<SpeechSegment>& queue, std::vector<SpeechSegment>& batch) const;
+
+    // Decodes the batch in one call. results[i] corresponds to batch[i] and
+    // keeps its ordering fields and timestamps, with decode start and end
+    // stamped for the whole batch; segments that produced no text are reported
+    // with an empty text, and end-of-stream markers are passed through.
+    void decode(const SherpaOnnxOfflineRecognizer* recognizer,
+                const std::vector<SpeechSegment>& batch,
+                int sample_rate,
+                std::vector<RecognitionResult>& results) const;
+
+private:
+    size_t max_batch_size_;
+    std::chrono::milliseconds max_delay_;
+};
+
+} // namespace pipeline
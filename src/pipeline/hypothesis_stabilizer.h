@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace pipeline {
+
+// Tracks the successive partial hypotheses of one open utterance. Text that
+// two consecutive hypotheses agree on is reported as stable: a re-decode with
+// more audio rarely changes it again, so it can be shown as settled while the
+// rest of the hypothesis is still marked as tentative.
+class HypothesisStabilizer {
+public:
+    // Takes the next hypothesis and returns how many leading bytes of it are
+    // stable. The cut never splits a UTF-8 character, nor a word of
+    // space-separated text.
+    size_t update(const std::string& text) {
+        size_t n = 0;
+        const size_t limit = text.size() < previous_.size() ? text.size() : previous_.size();
+        while (n < limit && text[n] == previous_[n]) {
+            ++n;
+        }
+
+        if (n < text.size() && n < previous_.size()) {
+            // Back off to the start of the character the two disagree in
+            while (n > 0 && is_continuation(text[n])) {
+                --n;
+            }
+            // and to the start of the word, if the disagreement is inside one
+            while (n > 0 && is_word_byte(text[n - 1]) && is_word_byte(text[n])) {
+                --n;
+            }
+        } else if (n < text.size() && is_word_byte(text[n])) {
+            // The previous hypothesis ended here; its last word may still grow
+            while (n > 0 && is_word_byte(text[n - 1])) {
+                --n;
+            }
+        }
+
+        previous_ = text;
+        return n;
+    }
+
+    void reset() { previous_.clear(); }
+
+private:
+    static bool is_continuation(char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+    }
+
+    // ASCII letters and digits; CJK text has no spaces, so every character stands alone
+    static bool is_word_byte(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '\'';
+    }
+
+    std::string previous_;
+};
+
+} // namespace pipeline
@@ -0,0 +1,93 @@
+#include "pipeline/language_id_service.h"
+#include <iostream>
+#include <recognizer/model_factory.h>
+
+namespace pipeline {
+
+namespace {
+
+std::shared_future<std::string> ready_future(const std::string& value) {
+    std::promise<std::string> promise;
+    promise.set_value(value);
+    return promise.get_future().share();
+}
+
+bool is_ready(const std::shared_future<std::string>& future) {
+    return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+} // namespace
+
+LanguageIdService::LanguageIdService(LanguageIdHandle slid, int recheck_interval_ms, size_t queue_capacity)
+    : slid_(std::move(slid))
+    , recheck_interval_(recheck_interval_ms)
+    , queue_(queue_capacity)
+    , detections_(0)
+    , cache_hits_(0) {
+    worker_ = std::thread(&LanguageIdService::worker_loop, this);
+}
+
+LanguageIdService::~LanguageIdService() {
+    queue_.close();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+std::shared_future<std::string> LanguageIdService::detect(uint64_t stream_id, const std::vector<float>& samples) {
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    CacheEntry& entry = cache_[stream_id];
+    if (is_ready(entry.next)) {
+        entry.current = std::move(entry.next);
+        entry.next = std::shared_future<std::string>();
+    }
+
+    const bool checked = entry.current.valid();
+    const bool due = !checked
+        || (recheck_interval_.count() > 0 && !entry.next.valid() && now - entry.checked_at >= recheck_interval_);
+    if (!due) {
+        cache_hits_.fetch_add(1, std::memory_order_relaxed);
+        return entry.current;
+    }
+
+    Job job;
+    job.samples = samples;
+    std::shared_future<std::string> result = job.promise.get_future().share();
+    if (!queue_.try_push(std::move(job))) {
+        // Detection is behind; keep the last result and try again with a later segment
+        return checked ? entry.current : ready_future("");
+    }
+
+    entry.checked_at = now;
+    if (checked) {
+        entry.next = std::move(result);
+        cache_hits_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        entry.current = std::move(result);
+    }
+    return entry.current;
+}
+
+void LanguageIdService::forget(uint64_t stream_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_.erase(stream_id);
+}
+
+void LanguageIdService::worker_loop() {
+    Job job;
+    while (queue_.pop(job)) {
+        try {
+            std::string language = recognizer::ModelFactory::DetectLanguage(
+                slid_.get(), job.samples.data(), static_cast<int32_t>(job.samples.size()));
+            job.promise.set_value(language);
+            detections_.fetch_add(1, std::memory_order_relaxed);
+        } catch (const std::exception& e) {
+            std::cerr << "Language detection failed: " << e.what() << std::endl;
+            job.promise.set_value("");
+        }
+    }
+}
+
+} // namespace pipeline
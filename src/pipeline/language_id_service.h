@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <common/bounded_queue.h>
+#include "sherpa-onnx/c-api/c-api.h"
+
+namespace pipeline {
+
+// Long-lived spoken-language identification. The model is loaded once by the
+// caller (see recognizer::ModelRegistry) and used from a single worker thread,
+// so detection runs on the model's own thread budget
+// (language_detection_num_threads) next to the decoder instead of inside it.
+// The detected language is cached per stream and only re-checked after
+// recheck_interval; until a re-check completes callers keep getting the
+// previous result, so only a stream's first segment ever waits on detection.
+class LanguageIdService {
+public:
+    using LanguageIdHandle = std::shared_ptr<const SherpaOnnxSpokenLanguageIdentification>;
+
+    LanguageIdService(LanguageIdHandle slid, int recheck_interval_ms, size_t queue_capacity);
+    ~LanguageIdService();
+
+    LanguageIdService(const LanguageIdService&) = delete;
+    LanguageIdService& operator=(const LanguageIdService&) = delete;
+
+    // Returns the stream's language, e.g. "en", queueing the segment for detection
+    // if the stream has no cached result or it is due for a re-check. The future
+    // yields an empty string if detection failed or the queue was full.
+    std::shared_future<std::string> detect(uint64_t stream_id, const std::vector<float>& samples);
+
+    // Drops the cached language of a finished stream
+    void forget(uint64_t stream_id);
+
+    uint64_t detections() const { return detections_.load(std::memory_order_relaxed); }
+    uint64_t cache_hits() const { return cache_hits_.load(std::memory_order_relaxed); }
+
+private:
+    struct Job {
+        std::vector<float> samples;
+        std::promise<std::string> promise;
+    };
+
+    struct CacheEntry {
+        std::shared_future<std::string> current;  // Result handed out to callers
+        std::shared_future<std::string> next;     // Re-check in flight, promoted once ready
+        std::chrono::steady_clock::time_point checked_at;
+    };
+
+    void worker_loop();
+
+    LanguageIdHandle slid_;
+    const std::chrono::milliseconds recheck_interval_;
+
+    std::mutex mutex_;
+    std::map<uint64_t, CacheEntry> cache_;
+
+    common::BoundedQueue<Job> queue_;
+    std::thread worker_;
+
+    std::atomic<uint64_t> detections_;
+    std::atomic<uint64_t> cache_hits_;
+};
+
+} // namespace pipeline
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+#include <common/latency_histogram.h>
+
+namespace pipeline {
+
+// Counters for one pipeline stage, measured at the stage's input queue
+struct StageStats {
+    size_t queue_depth = 0;
+    size_t queue_capacity = 0;
+    uint64_t processed = 0;
+    uint64_t dropped = 0;
+};
+
+// Per-stage latency of recognized segments, see SegmentTimestamps for the stage boundaries
+struct LatencyStats {
+    common::LatencySummary vad;             // captured -> vad_closed
+    common::LatencySummary decode_wait;     // vad_closed -> decode_start
+    common::LatencySummary decode;          // decode_start -> decode_end
+    common::LatencySummary translate_wait;  // decode_end -> translate_start (reordering and queueing)
+    common::LatencySummary translate;       // translate_start -> translate_end, translated segments only
+    common::LatencySummary end_to_end;      // captured -> output
+};
+
+struct PipelineStats {
+    StageStats vad;        // PCM ring buffers of all sources, counted in samples
+    StageStats decode;     // Speech segments waiting for ASR
+    StageStats translate;  // Recognition results waiting for translation
+    StageStats output;     // Results waiting for the output writer; partials are dropped when full
+    uint64_t decode_batches = 0;  // Batched decoder calls; decode.processed / decode_batches is the mean batch size
+    std::map<uint32_t, StageStats> sources;  // Per-source ring buffer counters, keyed by source id
+    uint64_t capture_allocations = 0;        // Heap allocations on the capture path; stays 0 once running
+    uint64_t segment_buffer_allocations = 0;  // Segment sample buffers allocated or grown; levels off
+    uint64_t partial_results = 0;            // Hypotheses written out ahead of their final result
+    uint64_t early_decodes = 0;              // Open segments decoded ahead of the VAD, see early_decode_interval_ms
+    LatencyStats latency;
+};
+
+// Points in a segment's life, stamped as it moves through the pipeline
+struct SegmentTimestamps {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point captured;         // Estimated arrival in stream_read_cb of the audio that closed the segment
+    Clock::time_point vad_closed;       // VAD emitted the segment; in streaming mode, the closing audio reached the decoder
+    Clock::time_point decode_start;
+    Clock::time_point decode_end;
+    Clock::time_point translate_start;  // Translation submitted, or skipped
+    Clock::time_point translate_end;    // Translation available to the output stage
+    Clock::time_point output;           // Result written out
+};
+
+struct SpeechSegment {
+    uint32_t source_id = 0;   // Capture source the audio came from, e.g. a sink input index
+    uint64_t session_id = 0;  // Unique per add_stream() call, so a reused source id starts fresh
+    uint64_t sequence = 0;    // Per-session order, used to restore order after parallel decoding
+    bool end_of_stream = false;  // Marker sent once after the session's last segment
+    bool partial = false;        // Early decode of speech the VAD has not closed; sequence is the segment it previews
+    int32_t start = 0;  // Offset of the first sample in the VAD timeline
+    std::vector<float> samples;
+    SegmentTimestamps timestamps;
+};
+
+struct RecognitionResult {
+    uint32_t source_id = 0;
+    uint64_t session_id = 0;
+    uint64_t sequence = 0;
+    bool end_of_stream = false;
+    // Hypothesis of a still open utterance, shown but never translated. It
+    // carries the sequence of the result it previews and is superseded by it.
+    bool partial = false;
+    size_t stable_size = 0;  // Partials: leading bytes of text the previous partial agreed on
+    float start = 0.0f;
+    float end = 0.0f;
+    std::string text;      // Empty if the segment produced no text
+    std::string language;  // Raw language tag from the recognizer, e.g. "<|en|>"
+    std::shared_future<std::string> detected_language;  // From LanguageIdService, for recognizers that report no language
+    SegmentTimestamps timestamps;
+};
+
+} // namespace pipeline
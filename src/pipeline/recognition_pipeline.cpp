@@ -0,0 +1,894 @@
+#include "pipeline/recognition_pipeline.h"
+#include "pipeline/hypothesis_stabilizer.h"
+#include "audio/dsp/sample_kernels.h"
+#include "trace/trace.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace pipeline {
+
+namespace {
+
+// How long a VAD worker sleeps when no source has a full window buffered.
+// PulseAudio delivers 25 ms fragments, so this keeps added latency well below one fragment.
+constexpr auto kVadPollInterval = std::chrono::milliseconds(5);
+
+// Windows a VAD worker processes for one source before moving on to the next
+constexpr size_t kWindowsPerTurn = 8;
+
+// Smallest pooled segment buffer: one second of audio
+constexpr size_t kMinSegmentBufferSamples = 16000;
+
+// Unused early decode time that may be saved up for later
+constexpr auto kEarlyDecodeBurst = std::chrono::seconds(1);
+
+// Most audio a streaming source feeds its online stream per read: 100 ms
+constexpr size_t kOnlineChunkSamples = 1600;
+
+// Audio still buffered behind what was just read arrived last, so that audio
+// was captured about that much earlier than the latest push
+SegmentTimestamps::Clock::time_point estimate_capture_time(const StreamContext& stream, int sample_rate) {
+    const auto last_push = SegmentTimestamps::Clock::time_point(SegmentTimestamps::Clock::duration(
+        stream.last_push_ns.load(std::memory_order_relaxed)));
+    return last_push - std::chrono::microseconds(
+        static_cast<int64_t>(stream.ring.size()) * 1000000 / sample_rate);
+}
+
+} // namespace
+
+RecognitionPipeline::RecognitionPipeline(const common::PipelineConfig& config)
+    : config_(config)
+    , recognizer_(nullptr)
+    , online_recognizer_(nullptr)
+    , partial_interval_samples_(0)
+    , window_size_(0)
+    , translator_(nullptr)
+    , streams_version_(0)
+    , next_session_id_(1)
+    , segment_queue_(static_cast<size_t>(config.segment_queue_capacity))
+    , result_queue_(static_cast<size_t>(config.result_queue_capacity))
+    , output_queue_(static_cast<size_t>(config.result_queue_capacity))
+    // Enough for a full segment queue plus the batches being decoded
+    , segment_buffers_(static_cast<size_t>(config.segment_queue_capacity
+                                           + config.decode_threads * config.decode_batch_size),
+                       kMinSegmentBufferSamples)
+    , scheduler_(config.decode_batch_size, config.decode_batch_delay_ms)
+    , early_decode_interval_samples_(static_cast<size_t>(std::max(0, config.early_decode_interval_ms)) * SAMPLE_RATE / 1000)
+    // The budget is a share of every decode worker's time
+    , early_decode_budget_(config.early_decode_budget_percent / 100.0 * std::max(1, config.decode_threads),
+                           kEarlyDecodeBurst)
+    , running_(false)
+    , stopping_(false)
+    , samples_processed_(0)
+    , samples_dropped_(0)
+    , segments_decoded_(0)
+    , decode_batches_(0)
+    , results_translated_(0)
+    , partial_results_(0)
+    , early_decodes_(0)
+    , capture_allocations_(0)
+    , vad_segments_(metrics::Registry::Instance().counter(
+          "voice_assistant_vad_segments_total", "Speech segments the VAD closed, including dropped ones"))
+    , vad_segment_seconds_(metrics::Registry::Instance().histogram(
+          "voice_assistant_vad_segment_seconds", "Length of speech segments the VAD closed",
+          {0.5, 1, 2, 3, 5, 8, 13, 20, 30}))
+    , decode_rtf_(metrics::Registry::Instance().histogram(
+          "voice_assistant_decode_rtf", "Real-time factor of batched decodes: decode time over audio length",
+          {0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1, 2, 5}))
+    , metrics_collector_(0) {
+}
+
+RecognitionPipeline::~RecognitionPipeline() {
+    stop();
+}
+
+void RecognitionPipeline::set_recognizer(const SherpaOnnxOfflineRecognizer* recognizer) {
+    recognizer_ = recognizer;
+}
+
+void RecognitionPipeline::set_online_recognizer(const SherpaOnnxOnlineRecognizer* recognizer,
+                                                const common::StreamingConfig& config) {
+    online_recognizer_ = recognizer;
+    partial_interval_samples_ = static_cast<size_t>(config.partial_interval_ms) * SAMPLE_RATE / 1000;
+    // Streaming models report no language; tag results like SenseVoice does so they can be translated
+    online_language_ = config.language.empty() ? std::string() : "<|" + config.language + "|>";
+}
+
+void RecognitionPipeline::set_window_size(int window_size) {
+    window_size_ = window_size;
+}
+
+void RecognitionPipeline::set_translator(const translator::ITranslator* translator) {
+    translator_ = translator;
+}
+
+void RecognitionPipeline::set_language_identifier(std::shared_ptr<LanguageIdService> language_id) {
+    language_id_ = std::move(language_id);
+}
+
+void RecognitionPipeline::set_output(std::shared_ptr<output::OutputWriter> output) {
+    output_ = std::move(output);
+}
+
+bool RecognitionPipeline::ready() const {
+    return (recognizer_ != nullptr && window_size_ > 0) || online_recognizer_ != nullptr;
+}
+
+void RecognitionPipeline::start() {
+    if (running_ || !ready()) {
+        return;
+    }
+
+    stopping_ = false;
+    segment_queue_.reopen();
+    result_queue_.reopen();
+    output_queue_.reopen();
+    running_ = true;
+
+    const int vad_threads = std::max(1, config_.vad_threads);
+    for (int i = 0; i < vad_threads; ++i) {
+        vad_threads_.emplace_back(&RecognitionPipeline::vad_loop, this, static_cast<size_t>(i));
+    }
+    // Streaming results skip the segment queue, so there is nothing to decode in batches
+    const int decode_threads = streaming() ? 0 : std::max(1, config_.decode_threads);
+    for (int i = 0; i < decode_threads; ++i) {
+        decode_threads_.emplace_back(&RecognitionPipeline::decode_loop, this);
+    }
+    translate_thread_ = std::thread(&RecognitionPipeline::translate_loop, this);
+    if (!output_) {
+        output_ = std::make_shared<output::OutputWriter>(common::OutputConfig());
+    }
+    output_->start();
+    output_thread_ = std::thread(&RecognitionPipeline::output_loop, this);
+    if (config_.latency_report_interval_ms > 0) {
+        latency_report_thread_ = std::thread(&RecognitionPipeline::latency_report_loop, this);
+    }
+    metrics_collector_ = metrics::Registry::Instance().add_collector(
+        [this](metrics::Exposition& out) { collect_metrics(out); });
+}
+
+void RecognitionPipeline::stop() {
+    if (!running_) {
+        return;
+    }
+    metrics::Registry::Instance().remove_collector(metrics_collector_);
+    metrics_collector_ = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(streams_mutex_);
+        for (auto& stream : streams_) {
+            stream->closing.store(true, std::memory_order_release);
+        }
+    }
+
+    // Each stage exits once its input queue is closed and drained, so closing
+    // the queues in order flushes every buffered sample through to the output
+    stopping_ = true;
+    for (auto& thread : vad_threads_) {
+        thread.join();
+    }
+    vad_threads_.clear();
+    segment_queue_.close();
+
+    for (auto& thread : decode_threads_) {
+        thread.join();
+    }
+    decode_threads_.clear();
+    result_queue_.close();
+
+    if (translate_thread_.joinable()) {
+        translate_thread_.join();
+    }
+    output_queue_.close();
+
+    if (output_thread_.joinable()) {
+        output_thread_.join();
+    }
+    output_->stop();
+
+    {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        running_ = false;
+    }
+    report_cv_.notify_all();
+    if (latency_report_thread_.joinable()) {
+        latency_report_thread_.join();
+    }
+}
+
+std::shared_ptr<StreamContext> RecognitionPipeline::add_stream(uint32_t source_id, VadPtr vad) {
+    auto stream = std::make_shared<StreamContext>(
+        source_id,
+        next_session_id_.fetch_add(1),
+        std::move(vad),
+        static_cast<size_t>(config_.ring_buffer_seconds * SAMPLE_RATE)
+    );
+    if (online_recognizer_) {
+        stream->online = OnlineStreamPtr(SherpaOnnxCreateOnlineStream(online_recognizer_),
+                                         SherpaOnnxDestroyOnlineStream);
+        if (!stream->online) {
+            throw std::runtime_error("Failed to create online stream");
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(streams_mutex_);
+    streams_.push_back(stream);
+    streams_version_.fetch_add(1, std::memory_order_release);
+    return stream;
+}
+
+void RecognitionPipeline::remove_stream(const std::shared_ptr<StreamContext>& stream) {
+    if (stream) {
+        stream->closing.store(true, std::memory_order_release);
+    }
+}
+
+bool RecognitionPipeline::push_audio(StreamContext& stream, const int16_t* samples, size_t n) {
+    common::AllocationScope allocations(capture_allocations_);
+    size_t written = stream.ring.write(samples, n);
+    stream.last_push_ns.store(SegmentTimestamps::Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    if (written < n) {
+        stream.samples_dropped.fetch_add(n - written, std::memory_order_relaxed);
+        samples_dropped_.fetch_add(n - written, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+PipelineStats RecognitionPipeline::stats() const {
+    PipelineStats stats;
+
+    {
+        std::lock_guard<std::mutex> lock(streams_mutex_);
+        for (const auto& stream : streams_) {
+            StageStats& source = stats.sources[stream->source_id];
+            source.queue_depth = stream->ring.size();
+            source.queue_capacity = stream->ring.capacity();
+            source.processed = stream->samples_processed.load(std::memory_order_relaxed);
+            source.dropped = stream->samples_dropped.load(std::memory_order_relaxed);
+
+            stats.vad.queue_depth += source.queue_depth;
+            stats.vad.queue_capacity += source.queue_capacity;
+        }
+    }
+    stats.vad.processed = samples_processed_.load(std::memory_order_relaxed);
+    stats.vad.dropped = samples_dropped_.load(std::memory_order_relaxed);
+
+    stats.decode.queue_depth = segment_queue_.size();
+    stats.decode.queue_capacity = segment_queue_.capacity();
+    stats.decode.processed = segments_decoded_.load(std::memory_order_relaxed);
+    stats.decode.dropped = segment_queue_.dropped();
+    stats.decode_batches = decode_batches_.load(std::memory_order_relaxed);
+    stats.capture_allocations = capture_allocations_.load(std::memory_order_relaxed);
+    stats.segment_buffer_allocations = segment_buffers_.allocations();
+    stats.partial_results = partial_results_.load(std::memory_order_relaxed);
+    stats.early_decodes = early_decodes_.load(std::memory_order_relaxed);
+
+    stats.translate.queue_depth = result_queue_.size();
+    stats.translate.queue_capacity = result_queue_.capacity();
+    stats.translate.processed = results_translated_.load(std::memory_order_relaxed);
+    stats.translate.dropped = result_queue_.dropped();
+
+    if (output_) {
+        stats.output.queue_depth = output_->queue_depth();
+        stats.output.queue_capacity = output_->queue_capacity();
+        stats.output.processed = output_->written();
+        stats.output.dropped = output_->dropped();
+    }
+
+    stats.latency.vad = vad_latency_.summary();
+    stats.latency.decode_wait = decode_wait_latency_.summary();
+    stats.latency.decode = decode_latency_.summary();
+    stats.latency.translate_wait = translate_wait_latency_.summary();
+    stats.latency.translate = translate_latency_.summary();
+    stats.latency.end_to_end = end_to_end_latency_.summary();
+
+    return stats;
+}
+
+void RecognitionPipeline::vad_loop(size_t worker_index) {
+    trace::SetThreadName("vad");
+    const size_t window_size = streaming() ? kOnlineChunkSamples : static_cast<size_t>(window_size_);
+    std::vector<int16_t> pcm(window_size);
+    std::vector<float> window(window_size);
+
+    std::vector<std::shared_ptr<StreamContext>> snapshot;
+    uint64_t snapshot_version = 0;
+    bool have_snapshot = false;
+    // Start each worker at a different source so workers spread out
+    size_t offset = worker_index;
+
+    while (true) {
+        const uint64_t version = streams_version_.load(std::memory_order_acquire);
+        if (!have_snapshot || version != snapshot_version) {
+            std::lock_guard<std::mutex> lock(streams_mutex_);
+            snapshot = streams_;
+            snapshot_version = streams_version_.load(std::memory_order_relaxed);
+            have_snapshot = true;
+        }
+
+        if (snapshot.empty()) {
+            if (stopping_) {
+                break;
+            }
+            std::this_thread::sleep_for(kVadPollInterval);
+            continue;
+        }
+
+        bool did_work = false;
+        for (size_t k = 0; k < snapshot.size(); ++k) {
+            StreamContext& stream = *snapshot[(offset + k) % snapshot.size()];
+            if (stream.busy.exchange(true, std::memory_order_acquire)) {
+                continue;
+            }
+            // Only turns that found audio are traced; idle polls would flood the trace
+            const int64_t start_ns = trace::Enabled() ? trace::NowNs() : 0;
+            const bool worked = streaming() ? process_online_stream(stream, pcm, window)
+                                            : process_stream(stream, pcm, window);
+            if (worked && start_ns != 0) {
+                trace::RecordSpan(streaming() ? "online_decode" : "vad", "pipeline", start_ns, trace::NowNs());
+            }
+            did_work |= worked;
+            stream.busy.store(false, std::memory_order_release);
+        }
+        ++offset;
+
+        if (!did_work) {
+            std::this_thread::sleep_for(kVadPollInterval);
+        }
+    }
+}
+
+bool RecognitionPipeline::process_stream(StreamContext& stream,
+                                         std::vector<int16_t>& pcm,
+                                         std::vector<float>& window) {
+    if (stream.finished) {
+        return false;
+    }
+
+    const size_t window_size = pcm.size();
+    size_t windows = 0;
+    while (windows < kWindowsPerTurn && stream.ring.size() >= window_size) {
+        stream.ring.read(pcm.data(), window_size);
+        const auto captured = estimate_capture_time(stream, SAMPLE_RATE);
+        dsp::kernels().s16_to_float(pcm.data(), window.data(), window_size, dsp::kS16ToFloat);
+
+        SherpaOnnxVoiceActivityDetectorAcceptWaveform(stream.vad.get(), window.data(), window_size_);
+        stream.samples_processed.fetch_add(window_size, std::memory_order_relaxed);
+        samples_processed_.fetch_add(window_size, std::memory_order_relaxed);
+        drain_vad(stream, captured);
+        if (early_decode_interval_samples_ > 0 && SherpaOnnxVoiceActivityDetectorDetected(stream.vad.get())) {
+            stream.open_speech.insert(stream.open_speech.end(), window.begin(), window.end());
+            decode_early(stream, captured);
+        }
+        ++windows;
+    }
+
+    if (windows == 0 && stream.closing.load(std::memory_order_acquire)
+        && stream.ring.size() < window_size) {
+        // Emit whatever speech is still open so stopping does not lose the last utterance
+        SherpaOnnxVoiceActivityDetectorFlush(stream.vad.get());
+        drain_vad(stream, SegmentTimestamps::Clock::time_point(SegmentTimestamps::Clock::duration(
+            stream.last_push_ns.load(std::memory_order_relaxed))));
+
+        finish_stream(stream);
+        return true;
+    }
+
+    return windows > 0;
+}
+
+bool RecognitionPipeline::process_online_stream(StreamContext& stream,
+                                                std::vector<int16_t>& pcm,
+                                                std::vector<float>& chunk) {
+    if (stream.finished) {
+        return false;
+    }
+
+    // No window alignment is needed, so take whatever is buffered to keep partials current
+    size_t chunks = 0;
+    while (chunks < kWindowsPerTurn && stream.ring.size() > 0) {
+        const size_t n = stream.ring.read(pcm.data(), pcm.size());
+        const auto captured = estimate_capture_time(stream, SAMPLE_RATE);
+        dsp::kernels().s16_to_float(pcm.data(), chunk.data(), n, dsp::kS16ToFloat);
+
+        SherpaOnnxOnlineStreamAcceptWaveform(stream.online.get(), SAMPLE_RATE, chunk.data(), static_cast<int32_t>(n));
+        stream.online_samples += n;
+        stream.samples_processed.fetch_add(n, std::memory_order_relaxed);
+        samples_processed_.fetch_add(n, std::memory_order_relaxed);
+        decode_online(stream, captured, false);
+        ++chunks;
+    }
+
+    if (chunks == 0 && stream.closing.load(std::memory_order_acquire) && stream.ring.size() == 0) {
+        // Decode the remaining frames so stopping does not lose the last utterance
+        SherpaOnnxOnlineStreamInputFinished(stream.online.get());
+        decode_online(stream, SegmentTimestamps::Clock::time_point(SegmentTimestamps::Clock::duration(
+            stream.last_push_ns.load(std::memory_order_relaxed))), true);
+        finish_stream(stream);
+        return true;
+    }
+
+    return chunks > 0;
+}
+
+void RecognitionPipeline::decode_online(StreamContext& stream,
+                                        SegmentTimestamps::Clock::time_point captured,
+                                        bool end_of_input) {
+    const SherpaOnnxOnlineStream* online = stream.online.get();
+    const auto decode_start = SegmentTimestamps::Clock::now();
+    while (SherpaOnnxIsOnlineStreamReady(online_recognizer_, online)) {
+        SherpaOnnxDecodeOnlineStream(online_recognizer_, online);
+    }
+
+    const bool endpoint = end_of_input || SherpaOnnxOnlineStreamIsEndpoint(online_recognizer_, online);
+    const bool partial_due = partial_interval_samples_ > 0
+        && stream.online_samples - stream.last_partial_sample >= partial_interval_samples_;
+    if (!endpoint && !partial_due) {
+        return;
+    }
+
+    RecognitionResult result;
+    const SherpaOnnxOnlineRecognizerResult* decoded = SherpaOnnxGetOnlineStreamResult(online_recognizer_, online);
+    if (decoded) {
+        result.text = decoded->text ? decoded->text : "";
+        SherpaOnnxDestroyOnlineRecognizerResult(decoded);
+    }
+    result.source_id = stream.source_id;
+    result.session_id = stream.session_id;
+    result.sequence = stream.next_sequence;
+    result.start = static_cast<float>(stream.utterance_start) / SAMPLE_RATE;
+    result.end = static_cast<float>(stream.online_samples) / SAMPLE_RATE;
+    result.language = online_language_;
+    result.timestamps.captured = captured;
+    result.timestamps.vad_closed = decode_start;
+    result.timestamps.decode_start = decode_start;
+    result.timestamps.decode_end = SegmentTimestamps::Clock::now();
+    stream.last_partial_sample = stream.online_samples;
+
+    if (endpoint) {
+        SherpaOnnxOnlineStreamReset(online_recognizer_, online);
+        stream.utterance_start = stream.online_samples;
+        stream.partial_text.clear();
+        // Trailing silence ends an utterance too; only one with text takes a sequence number
+        if (!result.text.empty()) {
+            ++stream.next_sequence;
+            segments_decoded_.fetch_add(1, std::memory_order_relaxed);
+            // Backpressure rather than drop, so per-source sequences stay gap-free
+            result_queue_.push(std::move(result));
+        }
+        return;
+    }
+
+    if (result.text.empty() || result.text == stream.partial_text) {
+        return;
+    }
+    stream.partial_text = result.text;
+    result.partial = true;
+    // Partials are only a preview: skip them rather than crowd out final results
+    if (result_queue_.size() * 2 < result_queue_.capacity()) {
+        result_queue_.try_push(std::move(result));
+    }
+}
+
+void RecognitionPipeline::finish_stream(StreamContext& stream) {
+    if (streaming()) {
+        RecognitionResult marker;
+        marker.source_id = stream.source_id;
+        marker.session_id = stream.session_id;
+        marker.sequence = stream.next_sequence++;
+        marker.end_of_stream = true;
+        result_queue_.push(std::move(marker));
+    } else {
+        SpeechSegment marker;
+        marker.source_id = stream.source_id;
+        marker.session_id = stream.session_id;
+        marker.sequence = stream.next_sequence++;
+        marker.end_of_stream = true;
+        segment_queue_.push(std::move(marker));
+    }
+
+    stream.finished = true;
+    stream.vad.reset();
+    stream.online.reset();
+
+    std::lock_guard<std::mutex> lock(streams_mutex_);
+    streams_.erase(std::remove_if(streams_.begin(), streams_.end(),
+                                  [&stream](const std::shared_ptr<StreamContext>& s) {
+                                      return s.get() == &stream;
+                                  }),
+                   streams_.end());
+    streams_version_.fetch_add(1, std::memory_order_release);
+}
+
+void RecognitionPipeline::drain_vad(StreamContext& stream, SegmentTimestamps::Clock::time_point captured) {
+    SherpaOnnxVoiceActivityDetector* vad = stream.vad.get();
+    while (!SherpaOnnxVoiceActivityDetectorEmpty(vad)) {
+        const SherpaOnnxSpeechSegment* segment = SherpaOnnxVoiceActivityDetectorFront(vad);
+        if (segment) {
+            vad_segments_.inc();
+            vad_segment_seconds_.observe(static_cast<double>(segment->n) / SAMPLE_RATE);
+            SpeechSegment item;
+            item.source_id = stream.source_id;
+            item.session_id = stream.session_id;
+            item.sequence = stream.next_sequence;
+            item.start = segment->start;
+            item.samples = segment_buffers_.acquire(static_cast<size_t>(segment->n));
+            item.samples.assign(segment->samples, segment->samples + segment->n);
+            item.timestamps.captured = captured;
+            item.timestamps.vad_closed = SegmentTimestamps::Clock::now();
+            // Only consume a sequence number if the segment was queued, so the
+            // per-source ordering downstream never waits on a dropped segment
+            if (segment_queue_.try_push(std::move(item))) {
+                ++stream.next_sequence;
+            }
+            SherpaOnnxDestroySpeechSegment(segment);
+        }
+        SherpaOnnxVoiceActivityDetectorPop(vad);
+        stream.open_speech.clear();
+        stream.open_speech_decoded = 0;
+    }
+}
+
+void RecognitionPipeline::decode_early(StreamContext& stream, SegmentTimestamps::Clock::time_point captured) {
+    if (stream.open_speech.size() - stream.open_speech_decoded < early_decode_interval_samples_) {
+        return;
+    }
+    // Keep the cadence even when this decode is skipped, so a busy decoder is
+    // not hit by a burst of early decodes once it catches up
+    stream.open_speech_decoded = stream.open_speech.size();
+    // Final segments come first: leave room for them in the queue
+    if (!early_decode_budget_.available() || segment_queue_.size() * 2 >= segment_queue_.capacity()) {
+        return;
+    }
+
+    SpeechSegment item;
+    item.source_id = stream.source_id;
+    item.session_id = stream.session_id;
+    item.sequence = stream.next_sequence;
+    item.partial = true;
+    item.start = static_cast<int32_t>(stream.samples_processed.load(std::memory_order_relaxed)
+                                      - stream.open_speech.size());
+    item.samples = segment_buffers_.acquire(stream.open_speech.size());
+    item.samples.assign(stream.open_speech.begin(), stream.open_speech.end());
+    item.timestamps.captured = captured;
+    item.timestamps.vad_closed = SegmentTimestamps::Clock::now();
+    segment_queue_.try_push(std::move(item));
+}
+
+void RecognitionPipeline::decode_loop() {
+    std::vector<SpeechSegment> batch;
+    std::vector<RecognitionResult> results;
+    std::vector<std::shared_future<std::string>> languages;
+    batch.reserve(static_cast<size_t>(std::max(1, config_.decode_batch_size)));
+    trace::SetThreadName("decode");
+
+    while (scheduler_.next_batch(segment_queue_, batch)) {
+        trace::Span span("decode_batch", "pipeline");
+        // Queue language detection first so it runs alongside the decode
+        languages.assign(batch.size(), std::shared_future<std::string>());
+        if (language_id_) {
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (!batch[i].end_of_stream && !batch[i].partial && !batch[i].samples.empty()) {
+                    languages[i] = language_id_->detect(batch[i].session_id, batch[i].samples);
+                }
+            }
+        }
+
+        scheduler_.decode(recognizer_, batch, SAMPLE_RATE, results);
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (results[i].language.empty()) {
+                results[i].detected_language = std::move(languages[i]);
+            }
+        }
+
+        size_t total_samples = 0;
+        size_t early_samples = 0;
+        size_t early_segments = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            total_samples += batch[i].samples.size();
+            if (batch[i].partial) {
+                early_samples += batch[i].samples.size();
+                ++early_segments;
+                results[i].partial = true;
+            }
+        }
+        if (total_samples > 0) {
+            const auto elapsed = results.front().timestamps.decode_end - results.front().timestamps.decode_start;
+            decode_rtf_.observe(std::chrono::duration<double>(elapsed).count()
+                                / (static_cast<double>(total_samples) / SAMPLE_RATE));
+        }
+        if (early_samples > 0) {
+            // Charge early decodes their share of the batch, by audio length
+            const auto elapsed = results.front().timestamps.decode_end - results.front().timestamps.decode_start;
+            early_decode_budget_.charge(std::chrono::duration_cast<SegmentTimestamps::Clock::duration>(
+                elapsed * (static_cast<double>(early_samples) / total_samples)));
+        }
+
+        for (RecognitionResult& result : results) {
+            if (result.partial) {
+                result_queue_.try_push(std::move(result));
+            } else {
+                // Backpressure rather than drop, so per-source sequences stay gap-free
+                result_queue_.push(std::move(result));
+            }
+        }
+        for (SpeechSegment& segment : batch) {
+            segment_buffers_.release(std::move(segment.samples));
+        }
+
+        segments_decoded_.fetch_add(batch.size() - early_segments, std::memory_order_relaxed);
+        early_decodes_.fetch_add(early_segments, std::memory_order_relaxed);
+        decode_batches_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void RecognitionPipeline::translate_loop() {
+    // Decode workers may finish segments out of order; restore per-source order here
+    struct ReorderState {
+        uint64_t next_sequence = 0;
+        std::map<uint64_t, RecognitionResult> pending;
+        // Partial results of the segment they preview
+        uint64_t partial_sequence = std::numeric_limits<uint64_t>::max();
+        float partial_end = 0.0f;
+        HypothesisStabilizer stabilizer;
+    };
+    std::map<uint64_t, ReorderState> sessions;
+    trace::SetThreadName("translate");
+
+    RecognitionResult result;
+    while (result_queue_.pop(result)) {
+        if (result.partial) {
+            // Show a partial only while everything before the result it previews
+            // has been written out, and only if it covers more audio than the
+            // last one shown; a stale one would jump back in the transcript
+            ReorderState& state = sessions.emplace(result.session_id, ReorderState()).first->second;
+            if (result.sequence != state.next_sequence
+                || (result.sequence == state.partial_sequence && result.end <= state.partial_end)) {
+                continue;
+            }
+            if (result.sequence != state.partial_sequence) {
+                state.partial_sequence = result.sequence;
+                state.stabilizer.reset();
+            }
+            state.partial_end = result.end;
+            if (result.text.empty()) {
+                continue;
+            }
+            result.stable_size = state.stabilizer.update(result.text);
+
+            PendingOutput output;
+            output.result = std::move(result);
+            output_queue_.try_push(std::move(output));
+            continue;
+        }
+
+        auto it = sessions.emplace(result.session_id, ReorderState()).first;
+        ReorderState& state = it->second;
+        state.pending.emplace(result.sequence, std::move(result));
+
+        bool session_finished = false;
+        while (!state.pending.empty() && state.pending.begin()->first == state.next_sequence) {
+            RecognitionResult ready = std::move(state.pending.begin()->second);
+            state.pending.erase(state.pending.begin());
+            ++state.next_sequence;
+
+            if (ready.end_of_stream) {
+                if (language_id_) {
+                    language_id_->forget(ready.session_id);
+                }
+                // Tells output readers, e.g. a network client, that the session is complete
+                PendingOutput end;
+                end.result = std::move(ready);
+                output_queue_.push(std::move(end));
+                session_finished = true;
+                break;
+            }
+            if (ready.text.empty()) {
+                std::cerr << "No recognition result or empty text" << std::endl;
+                continue;
+            }
+            submit_translation(std::move(ready));
+        }
+
+        if (session_finished) {
+            sessions.erase(it);
+        }
+    }
+}
+
+void RecognitionPipeline::submit_translation(RecognitionResult result) {
+    trace::Span span("translate_submit", "pipeline");
+    PendingOutput output;
+
+    if (result.language.empty() && result.detected_language.valid()) {
+        std::string language = result.detected_language.get();
+        if (!language.empty()) {
+            result.language = "<|" + language + "|>";
+        }
+    }
+
+    // SenseVoice reports the language as "<|xx|>"
+    if (result.language.size() >= 4) {
+        output.language_code = result.language.substr(2, 2);
+        std::transform(output.language_code.begin(), output.language_code.end(),
+                       output.language_code.begin(), ::toupper);
+    }
+
+    result.timestamps.translate_start = SegmentTimestamps::Clock::now();
+    if (!output.language_code.empty() && translator_) {
+        std::string target_lang = translator_->get_target_language();
+        std::transform(target_lang.begin(), target_lang.end(), target_lang.begin(), ::toupper);
+        output.target_lang = target_lang;
+
+        if (target_lang != output.language_code) {
+            try {
+                output.translation = translator_->translate_async(result.text, output.language_code);
+            } catch (const std::exception& e) {
+                std::cerr << "Error translating text: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    result.timestamps.translate_end = result.timestamps.translate_start;
+    output.result = std::move(result);
+    // Backpressure rather than drop: the result is already decoded
+    output_queue_.push(std::move(output));
+}
+
+void RecognitionPipeline::output_loop() {
+    trace::SetThreadName("output");
+    PendingOutput output;
+    while (output_queue_.pop(output)) {
+        // Includes waiting for the translation
+        trace::Span span("output_record", "pipeline");
+        if (output.result.partial) {
+            if (output_->partial_results()) {
+                output::OutputRecord record = make_record(output);
+                if (output_->try_submit(record)) {
+                    partial_results_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            continue;
+        }
+        if (output.result.end_of_stream) {
+            output::OutputRecord record = make_record(output);
+            output_->submit(record);
+            continue;
+        }
+        const bool translated = output.translation.valid();
+        output::OutputRecord record = make_record(output);
+        output_->submit(record);
+        output.result.timestamps.output = SegmentTimestamps::Clock::now();
+        record_latency(output.result.timestamps, translated);
+        results_translated_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void RecognitionPipeline::record_latency(const SegmentTimestamps& timestamps, bool translated) {
+    vad_latency_.record(timestamps.vad_closed - timestamps.captured);
+    decode_wait_latency_.record(timestamps.decode_start - timestamps.vad_closed);
+    decode_latency_.record(timestamps.decode_end - timestamps.decode_start);
+    translate_wait_latency_.record(timestamps.translate_start - timestamps.decode_end);
+    if (translated) {
+        translate_latency_.record(timestamps.translate_end - timestamps.translate_start);
+    }
+    end_to_end_latency_.record(timestamps.output - timestamps.captured);
+}
+
+void RecognitionPipeline::latency_report_loop() {
+    const auto interval = std::chrono::milliseconds(config_.latency_report_interval_ms);
+    std::unique_lock<std::mutex> lock(report_mutex_);
+    while (!report_cv_.wait_for(lock, interval, [this] { return !running_; })) {
+        print_latency(std::cerr, stats().latency);
+    }
+}
+
+void RecognitionPipeline::collect_metrics(metrics::Exposition& out) const {
+    const PipelineStats snapshot = stats();
+    const std::pair<const char*, const StageStats*> stages[] = {
+        {"vad", &snapshot.vad},
+        {"decode", &snapshot.decode},
+        {"translate", &snapshot.translate},
+        {"output", &snapshot.output},
+    };
+    for (const auto& stage : stages) {
+        const metrics::Labels labels = {{"stage", stage.first}};
+        out.gauge("voice_assistant_queue_depth", "Items waiting at a pipeline stage's input queue",
+                  labels, static_cast<double>(stage.second->queue_depth));
+        out.gauge("voice_assistant_queue_capacity", "Capacity of a pipeline stage's input queue",
+                  labels, static_cast<double>(stage.second->queue_capacity));
+        out.counter("voice_assistant_stage_processed_total",
+                    "Items a pipeline stage processed: samples for vad, segments for decode, results after",
+                    labels, static_cast<double>(stage.second->processed));
+        out.counter("voice_assistant_stage_dropped_total", "Items dropped at a pipeline stage's full input queue",
+                    labels, static_cast<double>(stage.second->dropped));
+    }
+    for (const auto& source : snapshot.sources) {
+        const metrics::Labels labels = {{"source", std::to_string(source.first)}};
+        out.gauge("voice_assistant_source_queue_depth", "Samples waiting in a source's ring buffer",
+                  labels, static_cast<double>(source.second.queue_depth));
+        out.counter("voice_assistant_source_dropped_samples_total", "Samples a source lost to a full ring buffer",
+                    labels, static_cast<double>(source.second.dropped));
+    }
+    out.counter("voice_assistant_decode_batches_total", "Batched decoder calls", {},
+                static_cast<double>(snapshot.decode_batches));
+    out.counter("voice_assistant_partial_results_total", "Hypotheses written out ahead of their final result", {},
+                static_cast<double>(snapshot.partial_results));
+    out.counter("voice_assistant_early_decodes_total", "Open segments decoded ahead of the VAD", {},
+                static_cast<double>(snapshot.early_decodes));
+
+    const std::pair<const char*, const common::LatencySummary*> latencies[] = {
+        {"vad", &snapshot.latency.vad},
+        {"decode_wait", &snapshot.latency.decode_wait},
+        {"decode", &snapshot.latency.decode},
+        {"translate_wait", &snapshot.latency.translate_wait},
+        {"translate", &snapshot.latency.translate},
+        {"end_to_end", &snapshot.latency.end_to_end},
+    };
+    for (const auto& latency : latencies) {
+        const std::pair<const char*, double> quantiles[] = {
+            {"0.5", latency.second->p50_ms}, {"0.95", latency.second->p95_ms}, {"0.99", latency.second->p99_ms}};
+        for (const auto& quantile : quantiles) {
+            out.gauge("voice_assistant_latency_seconds", "Per-stage latency of results written out, since start",
+                      {{"stage", latency.first}, {"quantile", quantile.first}}, quantile.second / 1000.0);
+        }
+    }
+}
+
+void print_latency(std::ostream& out, const LatencyStats& latency) {
+    const std::pair<const char*, const common::LatencySummary*> stages[] = {
+        {"vad", &latency.vad},
+        {"decode_wait", &latency.decode_wait},
+        {"decode", &latency.decode},
+        {"translate_wait", &latency.translate_wait},
+        {"translate", &latency.translate},
+        {"end_to_end", &latency.end_to_end},
+    };
+
+    std::ostringstream text;
+    text << "[Latency] p50/p95/p99/max ms (count)\n" << std::fixed << std::setprecision(1);
+    for (const auto& stage : stages) {
+        const common::LatencySummary& s = *stage.second;
+        text << "  " << std::left << std::setw(15) << stage.first << std::right
+             << s.p50_ms << "/" << s.p95_ms << "/" << s.p99_ms << "/" << s.max_ms
+             << " (" << s.count << ")\n";
+    }
+    // One write so concurrent output does not interleave inside the report
+    out << text.str() << std::flush;
+}
+
+output::OutputRecord RecognitionPipeline::make_record(PendingOutput& output) const {
+    RecognitionResult& result = output.result;
+    output::OutputRecord record;
+    record.source_id = result.source_id;
+    record.sequence = result.sequence;
+    record.partial = result.partial;
+    record.end_of_stream = result.end_of_stream;
+    record.stable_size = result.stable_size;
+    record.start = result.start;
+    record.end = result.end;
+    record.text = std::move(result.text);
+    record.language = std::move(output.language_code);
+    record.target_lang = std::move(output.target_lang);
+
+    if (output.translation.valid()) {
+        output.translation.wait();
+        result.timestamps.translate_end = SegmentTimestamps::Clock::now();
+        try {
+            record.translation = output.translation.get();
+        } catch (const std::exception& e) {
+            record.translation_error = e.what();
+        }
+    }
+    return record;
+}
+
+} // namespace pipeline
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <common/model_config.h>
+#include <common/spsc_ring_buffer.h>
+#include <common/allocation_counter.h>
+#include <common/buffer_pool.h>
+#include <common/bounded_queue.h>
+#include <common/latency_histogram.h>
+#include <common/time_budget.h>
+#include <metrics/metrics.h>
+#include "pipeline/pipeline_types.h"
+#include "pipeline/decode_scheduler.h"
+#include "pipeline/language_id_service.h"
+#include "output/output_writer.h"
+#include "sherpa-onnx/c-api/c-api.h"
+#include "translator/translator.h"
+
+namespace pipeline {
+
+using VadPtr = std::shared_ptr<SherpaOnnxVoiceActivityDetector>;
+using OnlineStreamPtr = std::shared_ptr<const SherpaOnnxOnlineStream>;
+
+// Per-source state: the capture side writes into ring, one VAD worker at a
+// time (guarded by busy) reads from it and owns the VAD instance, or in
+// streaming mode the online stream.
+struct StreamContext {
+    StreamContext(uint32_t source_id, uint64_t session_id, VadPtr vad, size_t ring_capacity)
+        : source_id(source_id)
+        , session_id(session_id)
+        , ring(ring_capacity)
+        , vad(std::move(vad)) {}
+
+    const uint32_t source_id;
+    const uint64_t session_id;
+    common::SpscRingBuffer<int16_t> ring;
+    VadPtr vad;
+    OnlineStreamPtr online;  // Streaming mode only
+
+    // Streaming mode, guarded by busy: positions in samples since the stream started
+    uint64_t online_samples = 0;       // Fed to the online stream
+    uint64_t utterance_start = 0;      // Start of the open utterance
+    uint64_t last_partial_sample = 0;  // When the hypothesis was last checked for a partial result
+    std::string partial_text;          // Last partial result sent
+
+    // Early decoding, guarded by busy: speech the VAD has detected but not yet
+    // emitted as a segment, and its length when it was last decoded
+    std::vector<float> open_speech;
+    size_t open_speech_decoded = 0;
+
+    std::atomic<bool> busy{false};     // Claimed by a VAD worker
+    std::atomic<bool> closing{false};  // No more audio will be pushed
+    bool finished = false;             // End-of-stream marker sent; guarded by busy
+    uint64_t next_sequence = 0;        // Guarded by busy
+
+    std::atomic<uint64_t> samples_processed{0};
+    std::atomic<uint64_t> samples_dropped{0};
+    // steady_clock time of the last push_audio, used to estimate when buffered audio was captured
+    std::atomic<int64_t> last_push_ns{0};
+};
+
+// Writes one line per stage: p50/p95/p99/max in milliseconds and the sample count
+void print_latency(std::ostream& out, const LatencyStats& latency);
+
+// Staged recognition pipeline shared by any number of capture sources:
+//   capture callback -> per-source SPSC ring buffer -> VAD worker pool
+//   -> segment queue -> decode workers (batched, see DecodeScheduler)
+//   -> result queue -> translate worker -> output queue -> output worker
+//   -> output writer (see output::OutputWriter) -> stdout, file or socket
+// The capture side only copies PCM into its ring buffer and never blocks,
+// so ASR and network latency no longer run on the audio thread. VAD workers
+// visit sources round-robin a few windows at a time so one busy source cannot
+// starve the others; all sources share one recognizer and one translator.
+// With a streaming recognizer the same workers feed each source's online
+// stream instead of a VAD: partial hypotheses go straight to the output, and
+// the final text of an utterance enters the result queue at its endpoint, so
+// the segment queue and decode workers are bypassed.
+// Results are put back into per-source order before translation is
+// submitted, and the output worker waits on translations in submission
+// order, so several translations are in flight while output stays ordered.
+// Formatting and output I/O happen on the output writer's own thread.
+// With early decoding enabled, VAD workers also queue the speech of a still
+// open segment every early_decode_interval_ms; its text is shown as a partial
+// result until the VAD closes the segment, within a share of decode time.
+class RecognitionPipeline {
+public:
+    static constexpr int SAMPLE_RATE = 16000;
+
+    explicit RecognitionPipeline(const common::PipelineConfig& config);
+    ~RecognitionPipeline();
+
+    RecognitionPipeline(const RecognitionPipeline&) = delete;
+    RecognitionPipeline& operator=(const RecognitionPipeline&) = delete;
+
+    void set_recognizer(const SherpaOnnxOfflineRecognizer* recognizer);
+    // Switches the pipeline to streaming mode; use instead of set_recognizer
+    void set_online_recognizer(const SherpaOnnxOnlineRecognizer* recognizer, const common::StreamingConfig& config);
+    void set_window_size(int window_size);
+    void set_translator(const translator::ITranslator* translator);
+    // Optional; used to find the source language when the recognizer reports none (Whisper)
+    void set_language_identifier(std::shared_ptr<LanguageIdService> language_id);
+    // Where results are written; without one, start() writes text to stdout
+    void set_output(std::shared_ptr<output::OutputWriter> output);
+
+    // True once the recognizer and VAD window size, or a streaming recognizer, are set
+    bool ready() const;
+    bool streaming() const { return online_recognizer_ != nullptr; }
+
+    void start();
+    // Drains buffered audio of every source through all stages, then joins the workers
+    void stop();
+
+    // Registers a source. The pipeline keeps the VAD until the source is drained;
+    // in streaming mode no VAD is used and vad may be null.
+    std::shared_ptr<StreamContext> add_stream(uint32_t source_id, VadPtr vad);
+    // Stops accepting audio for the source; buffered audio is still recognized
+    void remove_stream(const std::shared_ptr<StreamContext>& stream);
+
+    // Called from the capture thread with 16 kHz mono PCM. Never blocks or
+    // allocates; returns false if the ring buffer was full and samples were dropped.
+    bool push_audio(StreamContext& stream, const int16_t* samples, size_t n);
+
+    // Capture callbacks add their own allocations here (see common::AllocationScope)
+    // so stats().capture_allocations covers the whole capture path
+    std::atomic<uint64_t>& capture_allocations() { return capture_allocations_; }
+
+    PipelineStats stats() const;
+
+private:
+    struct PendingOutput {
+        RecognitionResult result;
+        std::string language_code;  // Upper-case code, empty if unknown
+        std::string target_lang;    // Empty when no translation was requested
+        std::future<std::string> translation;
+    };
+
+    void vad_loop(size_t worker_index);
+    bool process_stream(StreamContext& stream, std::vector<int16_t>& pcm, std::vector<float>& window);
+    void drain_vad(StreamContext& stream, SegmentTimestamps::Clock::time_point captured);
+    // Queues the open speech of the stream for a speculative decode when one is due
+    void decode_early(StreamContext& stream, SegmentTimestamps::Clock::time_point captured);
+    bool process_online_stream(StreamContext& stream, std::vector<int16_t>& pcm, std::vector<float>& chunk);
+    // Decodes what the online stream has buffered, then emits a partial result
+    // if one is due, or the final result if an endpoint was reached or end_of_input
+    void decode_online(StreamContext& stream, SegmentTimestamps::Clock::time_point captured, bool end_of_input);
+    // Queues the end-of-stream marker and drops the source from the worker rotation
+    void finish_stream(StreamContext& stream);
+    void decode_loop();
+    void translate_loop();
+    void submit_translation(RecognitionResult result);
+    void output_loop();
+    // Waits for the translation, if any, and stamps translate_end
+    output::OutputRecord make_record(PendingOutput& output) const;
+    void record_latency(const SegmentTimestamps& timestamps, bool translated);
+    void latency_report_loop();
+    // Queue depths and stage counters from stats(), at scrape time
+    void collect_metrics(metrics::Exposition& out) const;
+
+    common::PipelineConfig config_;
+
+    const SherpaOnnxOfflineRecognizer* recognizer_;
+    const SherpaOnnxOnlineRecognizer* online_recognizer_;
+    size_t partial_interval_samples_;  // 0 disables partial results
+    std::string online_language_;      // Language tag given to streaming results, e.g. "<|en|>"
+    int window_size_;
+    const translator::ITranslator* translator_;
+    std::shared_ptr<LanguageIdService> language_id_;
+    std::shared_ptr<output::OutputWriter> output_;
+
+    mutable std::mutex streams_mutex_;
+    std::vector<std::shared_ptr<StreamContext>> streams_;
+    std::atomic<uint64_t> streams_version_;  // Bumped on add/remove so workers refresh their snapshot
+    std::atomic<uint64_t> next_session_id_;
+
+    common::BoundedQueue<SpeechSegment> segment_queue_;
+    common::BoundedQueue<RecognitionResult> result_queue_;
+    common::BoundedQueue<PendingOutput> output_queue_;
+    // Sample buffers of queued segments, returned after decoding
+    common::BufferPool<float> segment_buffers_;
+    DecodeScheduler scheduler_;
+    size_t early_decode_interval_samples_;  // 0 disables early decoding
+    common::TimeBudget early_decode_budget_;
+
+    std::atomic<bool> running_;
+    std::atomic<bool> stopping_;
+    std::vector<std::thread> vad_threads_;
+    std::vector<std::thread> decode_threads_;
+    std::thread translate_thread_;
+    std::thread output_thread_;
+    std::thread latency_report_thread_;
+    std::mutex report_mutex_;
+    std::condition_variable report_cv_;
+
+    // Totals across all sources, including ones already removed
+    std::atomic<uint64_t> samples_processed_;
+    std::atomic<uint64_t> samples_dropped_;
+    std::atomic<uint64_t> segments_decoded_;
+    std::atomic<uint64_t> decode_batches_;
+    std::atomic<uint64_t> results_translated_;
+    std::atomic<uint64_t> partial_results_;
+    std::atomic<uint64_t> early_decodes_;
+    std::atomic<uint64_t> capture_allocations_;
+
+    // Per-stage latency of every result written out
+    common::LatencyHistogram vad_latency_;
+    common::LatencyHistogram decode_wait_latency_;
+    common::LatencyHistogram decode_latency_;
+    common::LatencyHistogram translate_wait_latency_;
+    common::LatencyHistogram translate_latency_;
+    common::LatencyHistogram end_to_end_latency_;
+
+    // Process-wide metrics updated as segments pass; the rest come from collect_metrics
+    metrics::Counter& vad_segments_;
+    metrics::Histogram& vad_segment_seconds_;
+    metrics::Histogram& decode_rtf_;
+    uint64_t metrics_collector_;  // Registered while running, 0 otherwise
+};
+
+} // namespace pipeline
@@ -4,35 +4,23 @@
 #include <string>
 #include <iostream>
 #include "common/model_config.h"
+#include "trace/trace.h"
 #include <sherpa-onnx/c-api/c-api.h>
 
 namespace recognizer {
 
 class ModelFactory {
 public:
-    static std::string DetectLanguage(const common::ModelConfig& config, const float* samples, int32_t n) {
-        // Create language identification config using whisper configuration
-        SherpaOnnxSpokenLanguageIdentificationConfig slid_config = {};
-        
-        // Use whisper configuration for language detection
-        slid_config.whisper.encoder = config.whisper.encoder_path.c_str();
-        slid_config.whisper.decoder = config.whisper.decoder_path.c_str();
-        slid_config.num_threads = config.whisper.language_detection_num_threads;
-        slid_config.provider = config.whisper.language_detection_provider.c_str();
-        slid_config.debug = config.whisper.language_detection_debug ? 1 : 0;
-
-        // Create language identification instance
-        const SherpaOnnxSpokenLanguageIdentification* slid = 
-            SherpaOnnxCreateSpokenLanguageIdentification(&slid_config);
-        if (!slid) {
-            throw std::runtime_error("Failed to create language identification");
-        }
+    // Detects the spoken language with the shared language identification model
+    // from ModelRegistry, loading it on first use
+    static std::string DetectLanguage(const common::ModelConfig& config, const float* samples, int32_t n);
 
+    static std::string DetectLanguage(const SherpaOnnxSpokenLanguageIdentification* slid, const float* samples, int32_t n) {
+        trace::Span span("detect_language", "model");
         // Create stream for language identification
         SherpaOnnxOfflineStream* stream = 
             SherpaOnnxSpokenLanguageIdentificationCreateOfflineStream(slid);
         if (!stream) {
-            SherpaOnnxDestroySpokenLanguageIdentification(slid);
             throw std::runtime_error("Failed to create stream for language identification");
         }
 
@@ -44,7 +32,6 @@ public:
             SherpaOnnxSpokenLanguageIdentificationCompute(slid, stream);
         if (!result) {
             SherpaOnnxDestroyOfflineStream(stream);
-            SherpaOnnxDestroySpokenLanguageIdentification(slid);
             throw std::runtime_error("Failed to detect language");
         }
 
@@ -53,15 +40,30 @@ public:
         // Cleanup
         SherpaOnnxDestroySpokenLanguageIdentificationResult(result);
         SherpaOnnxDestroyOfflineStream(stream);
-        SherpaOnnxDestroySpokenLanguageIdentification(slid);
 
         return detected_language;
     }
 
+    static const SherpaOnnxSpokenLanguageIdentification* CreateLanguageIdentifier(const common::ModelConfig& config) {
+        trace::Span span("create_language_identifier", "model");
+        // Create language identification config using whisper configuration
+        SherpaOnnxSpokenLanguageIdentificationConfig slid_config = {};
+        
+        // Use whisper configuration for language detection
+        slid_config.whisper.encoder = config.whisper.encoder_path.c_str();
+        slid_config.whisper.decoder = config.whisper.decoder_path.c_str();
+        slid_config.num_threads = config.whisper.language_detection_num_threads;
+        slid_config.provider = config.whisper.language_detection_provider.c_str();
+        slid_config.debug = config.whisper.language_detection_debug ? 1 : 0;
+
+        return SherpaOnnxCreateSpokenLanguageIdentification(&slid_config);
+    }
+
     static const SherpaOnnxOfflineRecognizer* CreateModel(
         const common::ModelConfig& config,
         const float* samples = nullptr,
         int32_t n = 0) {
+        trace::Span span("create_model", "model");
         // Zero initialization
         SherpaOnnxOfflineRecognizerConfig recognizer_config = {};
         SherpaOnnxOfflineModelConfig model_config = {};
@@ -95,7 +97,7 @@ public:
             if (language == "auto" && config.whisper.enable_language_detection && samples != nullptr && n > 0) {
                 try {
                     language = DetectLanguage(config, samples, n);
-                    std::cout << "Detected language: " << language << std::endl;
+                    std::cerr << "Detected language: " << language << std::endl;
                 } catch (const std::exception& e) {
                     std::cerr << "Language detection failed: " << e.what() << std::endl;
                     language = "en";  // Default to English on failure
@@ -116,8 +118,49 @@ public:
         recognizer_config.model_config = model_config;
         return SherpaOnnxCreateOfflineRecognizer(&recognizer_config);
     }
+    // Streaming recognizer for model type "streaming". Endpoint detection is
+    // enabled so each stream reports where an utterance ends.
+    static const SherpaOnnxOnlineRecognizer* CreateOnlineModel(const common::ModelConfig& config) {
+        trace::Span span("create_online_model", "model");
+        if (config.type != "streaming") {
+            throw std::runtime_error("Not a streaming model type: " + config.type);
+        }
+        const common::StreamingConfig& streaming = config.streaming;
+
+        SherpaOnnxOnlineRecognizerConfig recognizer_config = {};
+        recognizer_config.feat_config.sample_rate = 16000;
+        recognizer_config.feat_config.feature_dim = 80;
+
+        SherpaOnnxOnlineModelConfig model_config = {};
+        model_config.debug = config.debug ? 1 : 0;
+        model_config.num_threads = config.num_threads;
+        model_config.provider = config.provider.c_str();
+        model_config.tokens = streaming.tokens_path.c_str();
+
+        if (streaming.model_type == "transducer") {
+            model_config.transducer.encoder = streaming.encoder_path.c_str();
+            model_config.transducer.decoder = streaming.decoder_path.c_str();
+            model_config.transducer.joiner = streaming.joiner_path.c_str();
+        } else if (streaming.model_type == "paraformer") {
+            model_config.paraformer.encoder = streaming.encoder_path.c_str();
+            model_config.paraformer.decoder = streaming.decoder_path.c_str();
+        } else {
+            throw std::runtime_error("Unsupported streaming model type: " + streaming.model_type);
+        }
+
+        recognizer_config.model_config = model_config;
+        recognizer_config.decoding_method = streaming.decoding_method.c_str();
+        recognizer_config.max_active_paths = 4;
+        recognizer_config.enable_endpoint = 1;
+        recognizer_config.rule1_min_trailing_silence = streaming.rule1_min_trailing_silence;
+        recognizer_config.rule2_min_trailing_silence = streaming.rule2_min_trailing_silence;
+        recognizer_config.rule3_min_utterance_length = streaming.rule3_min_utterance_length;
+        return SherpaOnnxCreateOnlineRecognizer(&recognizer_config);
+    }
+
     //  CreateVoiceActivityDetector
     static SherpaOnnxVoiceActivityDetector* CreateVoiceActivityDetector(const common::ModelConfig& config) {
+        trace::Span span("create_vad", "model");
         try
         {
             // model_path empty
@@ -147,4 +190,4 @@ public:
     }
 };
 
-} // namespace recognizer 
\ No newline at end of file
+} // namespace recognizer 
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "common/model_config.h"
+#include "recognizer/model_factory.h"
+#include <sherpa-onnx/c-api/c-api.h>
+
+namespace recognizer {
+
+using RecognizerHandle = std::shared_ptr<const SherpaOnnxOfflineRecognizer>;
+using OnlineRecognizerHandle = std::shared_ptr<const SherpaOnnxOnlineRecognizer>;
+using LanguageIdHandle = std::shared_ptr<const SherpaOnnxSpokenLanguageIdentification>;
+using VadHandle = std::shared_ptr<SherpaOnnxVoiceActivityDetector>;
+
+// Process-wide cache of loaded models, keyed by the config fields that affect
+// the loaded model. Recognizers and language identifiers are stateless once
+// loaded and are shared by every session with an equal config; streaming
+// recognizers keep their decoder state in per-session online streams, so they
+// are shared the same way. A VAD carries
+// per-stream state, so VADs are pooled instead: each session holds its own
+// instance and returns it, reset, to the pool when the handle is released.
+class ModelRegistry {
+public:
+    static ModelRegistry& Instance() {
+        static ModelRegistry registry;
+        return registry;
+    }
+
+    ModelRegistry(const ModelRegistry&) = delete;
+    ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+    // Loads the recognizer on first use. Whisper with language "auto" resolves to
+    // "en" here; use ModelFactory::CreateModel with samples for per-call detection.
+    RecognizerHandle GetRecognizer(const common::ModelConfig& config);
+
+    // Loads the streaming recognizer of a "streaming" model type on first use
+    OnlineRecognizerHandle GetOnlineRecognizer(const common::ModelConfig& config);
+
+    LanguageIdHandle GetLanguageIdentifier(const common::ModelConfig& config);
+
+    // Takes an idle VAD from the pool, creating one if none is idle
+    VadHandle AcquireVad(const common::ModelConfig& config);
+
+    // Drops models no session holds a handle to, and destroys idle VADs
+    void ReleaseUnused();
+
+    static std::string RecognizerKey(const common::ModelConfig& config);
+    static std::string LanguageIdKey(const common::ModelConfig& config);
+    static std::string VadKey(const common::ModelConfig& config);
+
+private:
+    // Idle VADs for one config. Shared with outstanding handles so they can be
+    // returned safely even after the registry itself is gone.
+    struct VadPool {
+        std::mutex mutex;
+        std::vector<SherpaOnnxVoiceActivityDetector*> idle;
+
+        ~VadPool() {
+            for (auto* vad : idle) {
+                SherpaOnnxDestroyVoiceActivityDetector(vad);
+            }
+        }
+    };
+
+    ModelRegistry() = default;
+
+    std::mutex mutex_;
+    std::map<std::string, RecognizerHandle> recognizers_;
+    std::map<std::string, OnlineRecognizerHandle> online_recognizers_;
+    std::map<std::string, LanguageIdHandle> language_ids_;
+    std::map<std::string, std::shared_ptr<VadPool>> vad_pools_;
+};
+
+inline std::string ModelRegistry::RecognizerKey(const common::ModelConfig& config) {
+    std::ostringstream key;
+    key << config.type << '|' << config.provider << '|' << config.num_threads << '|' << config.debug << '|';
+    if (config.type == "sense_voice") {
+        key << config.sense_voice.model_path << '|' << config.sense_voice.tokens_path << '|'
+            << config.sense_voice.language << '|' << config.sense_voice.decoding_method << '|'
+            << config.sense_voice.use_itn;
+    } else if (config.type == "whisper") {
+        key << config.whisper.encoder_path << '|' << config.whisper.decoder_path << '|'
+            << config.whisper.tokens_path << '|' << config.whisper.language << '|'
+            << config.whisper.task << '|' << config.whisper.tail_paddings << '|'
+            << config.whisper.decoding_method;
+    } else if (config.type == "streaming") {
+        key << config.streaming.model_type << '|' << config.streaming.encoder_path << '|'
+            << config.streaming.decoder_path << '|' << config.streaming.joiner_path << '|'
+            << config.streaming.tokens_path << '|' << config.streaming.decoding_method << '|'
+            << config.streaming.rule1_min_trailing_silence << '|' << config.streaming.rule2_min_trailing_silence << '|'
+            << config.streaming.rule3_min_utterance_length;
+    }
+    return key.str();
+}
+
+inline std::string ModelRegistry::LanguageIdKey(const common::ModelConfig& config) {
+    std::ostringstream key;
+    key << config.whisper.encoder_path << '|' << config.whisper.decoder_path << '|'
+        << config.whisper.language_detection_num_threads << '|'
+        << config.whisper.language_detection_provider << '|' << config.whisper.language_detection_debug;
+    return key.str();
+}
+
+inline std::string ModelRegistry::VadKey(const common::ModelConfig& config) {
+    std::ostringstream key;
+    key << config.vad.model_path << '|' << config.vad.threshold << '|'
+        << config.vad.min_silence_duration << '|' << config.vad.min_speech_duration << '|'
+        << config.vad.max_speech_duration << '|' << config.vad.window_size << '|'
+        << config.vad.sample_rate << '|' << config.vad.num_threads << '|' << config.vad.debug;
+    return key.str();
+}
+
+inline RecognizerHandle ModelRegistry::GetRecognizer(const common::ModelConfig& config) {
+    const std::string key = RecognizerKey(config);
+    // Loading under the lock keeps concurrent first callers from loading the model twice
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = recognizers_.find(key);
+    if (it != recognizers_.end()) {
+        return it->second;
+    }
+
+    const SherpaOnnxOfflineRecognizer* recognizer = ModelFactory::CreateModel(config);
+    if (!recognizer) {
+        throw std::runtime_error("Failed to create speech recognizer");
+    }
+    RecognizerHandle handle(recognizer, SherpaOnnxDestroyOfflineRecognizer);
+    recognizers_[key] = handle;
+    return handle;
+}
+
+inline OnlineRecognizerHandle ModelRegistry::GetOnlineRecognizer(const common::ModelConfig& config) {
+    const std::string key = RecognizerKey(config);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = online_recognizers_.find(key);
+    if (it != online_recognizers_.end()) {
+        return it->second;
+    }
+
+    const SherpaOnnxOnlineRecognizer* recognizer = ModelFactory::CreateOnlineModel(config);
+    if (!recognizer) {
+        throw std::runtime_error("Failed to create streaming speech recognizer");
+    }
+    OnlineRecognizerHandle handle(recognizer, SherpaOnnxDestroyOnlineRecognizer);
+    online_recognizers_[key] = handle;
+    return handle;
+}
+
+inline LanguageIdHandle ModelRegistry::GetLanguageIdentifier(const common::ModelConfig& config) {
+    const std::string key = LanguageIdKey(config);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = language_ids_.find(key);
+    if (it != language_ids_.end()) {
+        return it->second;
+    }
+
+    const SherpaOnnxSpokenLanguageIdentification* slid = ModelFactory::CreateLanguageIdentifier(config);
+    if (!slid) {
+        throw std::runtime_error("Failed to create language identification");
+    }
+    LanguageIdHandle handle(slid, SherpaOnnxDestroySpokenLanguageIdentification);
+    language_ids_[key] = handle;
+    return handle;
+}
+
+inline VadHandle ModelRegistry::AcquireVad(const common::ModelConfig& config) {
+    std::shared_ptr<VadPool> pool;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& slot = vad_pools_[VadKey(config)];
+        if (!slot) {
+            slot = std::make_shared<VadPool>();
+        }
+        pool = slot;
+    }
+
+    SherpaOnnxVoiceActivityDetector* vad = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (!pool->idle.empty()) {
+            vad = pool->idle.back();
+            pool->idle.pop_back();
+        }
+    }
+    if (!vad) {
+        vad = ModelFactory::CreateVoiceActivityDetector(config);
+        if (!vad) {
+            throw std::runtime_error("Failed to create VAD");
+        }
+    }
+
+    return VadHandle(vad, [pool](SherpaOnnxVoiceActivityDetector* released) {
+        SherpaOnnxVoiceActivityDetectorReset(released);
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->idle.push_back(released);
+    });
+}
+
+inline void ModelRegistry::ReleaseUnused() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = recognizers_.begin(); it != recognizers_.end();) {
+        it = it->second.use_count() == 1 ? recognizers_.erase(it) : std::next(it);
+    }
+    for (auto it = online_recognizers_.begin(); it != online_recognizers_.end();) {
+        it = it->second.use_count() == 1 ? online_recognizers_.erase(it) : std::next(it);
+    }
+    for (auto it = language_ids_.begin(); it != language_ids_.end();) {
+        it = it->second.use_count() == 1 ? language_ids_.erase(it) : std::next(it);
+    }
+    for (auto& entry : vad_pools_) {
+        std::vector<SherpaOnnxVoiceActivityDetector*> idle;
+        {
+            std::lock_guard<std::mutex> pool_lock(entry.second->mutex);
+            idle.swap(entry.second->idle);
+        }
+        for (auto* vad : idle) {
+            SherpaOnnxDestroyVoiceActivityDetector(vad);
+        }
+    }
+}
+
+// Defined here rather than in model_factory.h because it needs the registry
+inline std::string ModelFactory::DetectLanguage(const common::ModelConfig& config, const float* samples, int32_t n) {
+    LanguageIdHandle slid = ModelRegistry::Instance().GetLanguageIdentifier(config);
+    return DetectLanguage(slid.get(), samples, n);
+}
+
+} // namespace recognizer
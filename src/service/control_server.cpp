@@ -0,0 +1,294 @@
+#include "service/control_server.h"
+#include "trace/trace.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace service {
+
+namespace {
+
+// How often the server thread checks whether it should stop
+constexpr int kPollTimeoutMs = 100;
+
+// Longest command line accepted; longer input closes the connection
+constexpr size_t kMaxLineLength = 4096;
+
+std::string error_reply(const std::string& message) {
+    std::string reply = "{\"ok\":false,\"error\":";
+    output::AppendJsonString(message, reply);
+    return reply + "}";
+}
+
+bool send_line(int fd, const std::string& line) {
+    const std::string data = line + "\n";
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool parse_index(std::istringstream& args, uint32_t& index) {
+    long long value = -1;
+    if (!(args >> value) || value < 0 || value > static_cast<long long>(UINT32_MAX)) {
+        return false;
+    }
+    index = static_cast<uint32_t>(value);
+    return true;
+}
+
+} // namespace
+
+ControlServer::ControlServer(const std::string& socket_path, audio::IAudioCapture& capture,
+                             std::shared_ptr<output::OutputWriter> output)
+    : socket_path_(socket_path)
+    , capture_(capture)
+    , output_(std::move(output))
+    , listener_(-1)
+    , running_(false) {
+}
+
+ControlServer::~ControlServer() {
+    stop();
+}
+
+void ControlServer::start() {
+    if (running_) {
+        return;
+    }
+
+    sockaddr_un address{};
+    if (socket_path_.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Control socket path is too long: " + socket_path_);
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socket_path_.c_str(), socket_path_.size() + 1);
+
+    listener_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ::unlink(socket_path_.c_str());  // Left behind by an earlier run
+    if (listener_ < 0 || ::bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(listener_, 16) != 0) {
+        const std::string reason = std::strerror(errno);
+        if (listener_ >= 0) {
+            ::close(listener_);
+            listener_ = -1;
+        }
+        throw std::runtime_error("Failed to listen on control socket " + socket_path_ + ": " + reason);
+    }
+
+    running_ = true;
+    thread_ = std::thread(&ControlServer::serve_loop, this);
+}
+
+void ControlServer::stop() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    for (const auto& client : clients_) {
+        ::close(client.first);
+    }
+    clients_.clear();
+    ::close(listener_);
+    listener_ = -1;
+    ::unlink(socket_path_.c_str());
+}
+
+void ControlServer::serve_loop() {
+    std::vector<pollfd> fds;
+    while (running_) {
+        fds.clear();
+        fds.push_back(pollfd{listener_, POLLIN, 0});
+        for (const auto& client : clients_) {
+            fds.push_back(pollfd{client.first, POLLIN, 0});
+        }
+
+        const int ready = ::poll(fds.data(), fds.size(), kPollTimeoutMs);
+        if (ready <= 0) {
+            continue;  // Timeout or EINTR
+        }
+
+        for (size_t i = 1; i < fds.size(); ++i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            auto it = clients_.find(fds[i].fd);
+            if (!serve_client(it->first, it->second)) {
+                clients_.erase(it);
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            accept_clients();
+        }
+    }
+}
+
+void ControlServer::accept_clients() {
+    while (true) {
+        const int client = ::accept4(listener_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            return;  // EAGAIN: nobody waiting
+        }
+        clients_.emplace(client, std::string());
+    }
+}
+
+bool ControlServer::serve_client(int fd, std::string& buffer) {
+    char chunk[1024];
+    const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) {
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+            return true;
+        }
+        ::close(fd);
+        return false;
+    }
+    buffer.append(chunk, static_cast<size_t>(n));
+
+    size_t end;
+    while ((end = buffer.find('\n')) != std::string::npos) {
+        std::string line = buffer.substr(0, end);
+        buffer.erase(0, end + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        std::istringstream args(line);
+        std::string command;
+        args >> command;
+        if (command == "subscribe") {
+            std::string name = "jsonl";
+            args >> name;
+            std::unique_ptr<output::OutputFormat> format;
+            try {
+                format = output::OutputFormat::Create(name);
+            } catch (const std::exception& e) {
+                if (!send_line(fd, error_reply(e.what()))) {
+                    ::close(fd);
+                    return false;
+                }
+                continue;
+            }
+            if (!send_line(fd, "{\"ok\":true}")) {
+                ::close(fd);
+                return false;
+            }
+            // The output writer owns the connection from here on
+            auto destination = output::OutputDestination::FromSocket(fd, format->header());
+            output_->add_subscriber(std::move(format), std::move(destination));
+            return false;
+        }
+
+        if (!send_line(fd, handle_command(line))) {
+            ::close(fd);
+            return false;
+        }
+    }
+
+    if (buffer.size() > kMaxLineLength) {
+        send_line(fd, error_reply("Command line too long"));
+        ::close(fd);
+        return false;
+    }
+    return true;
+}
+
+std::string ControlServer::handle_command(const std::string& line) {
+    std::istringstream args(line);
+    std::string command;
+    args >> command;
+
+    try {
+        if (command == "list") {
+            std::string reply = "{\"ok\":true,\"sources\":[";
+            bool first = true;
+            for (const auto& app : capture_.get_applications()) {
+                reply += first ? "" : ",";
+                reply += "{\"index\":" + std::to_string(app.first) + ",\"name\":";
+                output::AppendJsonString(app.second, reply);
+                reply += "}";
+                first = false;
+            }
+            return reply + "]}";
+        }
+
+        if (command == "start" || command == "stop") {
+            uint32_t index = 0;
+            if (!parse_index(args, index)) {
+                return error_reply("Usage: " + command + " <sink input index>");
+            }
+            if (command == "stop") {
+                capture_.stop_recording_application(index);
+            } else if (!capture_.start_recording_application(index)) {
+                return error_reply("Failed to start recording sink input " + std::to_string(index));
+            }
+            return "{\"ok\":true}";
+        }
+
+        if (command == "status") {
+            const pipeline::PipelineStats stats = capture_.get_pipeline_stats();
+            std::string reply = "{\"ok\":true,\"recording\":[";
+            bool first = true;
+            for (uint32_t index : capture_.recording_applications()) {
+                reply += (first ? "" : ",") + std::to_string(index);
+                first = false;
+            }
+            reply += "],\"samples_processed\":" + std::to_string(stats.vad.processed)
+                   + ",\"samples_dropped\":" + std::to_string(stats.vad.dropped)
+                   + ",\"segments_decoded\":" + std::to_string(stats.decode.processed)
+                   + ",\"results\":" + std::to_string(stats.translate.processed)
+                   + ",\"subscribers\":" + std::to_string(output_->subscribers()) + "}";
+            return reply;
+        }
+
+        if (command == "trace") {
+            std::string action;
+            std::string path;
+            args >> action >> path;
+            if (action == "start") {
+                trace::Start();
+            } else if (action == "stop") {
+                if (path.empty()) {
+                    return error_reply("Usage: trace stop <path>");
+                }
+                trace::Stop();
+                trace::WriteChromeTrace(path);
+            } else if (!action.empty()) {
+                return error_reply("Usage: trace [start|stop <path>]");
+            }
+            const trace::TraceStats stats = trace::Stats();
+            return std::string("{\"ok\":true,\"tracing\":") + (trace::Enabled() ? "true" : "false")
+                 + ",\"events\":" + std::to_string(stats.events)
+                 + ",\"dropped\":" + std::to_string(stats.dropped) + "}";
+        }
+
+        if (command == "help" || command.empty()) {
+            return "{\"ok\":true,\"commands\":[\"list\",\"start <index>\",\"stop <index>\",\"status\","
+                   "\"subscribe [jsonl|text|srt|vtt]\",\"trace [start|stop <path>]\",\"help\"]}";
+        }
+    } catch (const std::exception& e) {
+        return error_reply(e.what());
+    }
+
+    return error_reply("Unknown command: " + command);
+}
+
+} // namespace service
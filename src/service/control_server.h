@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <audio/audio_capture.h>
+#include <output/output_writer.h>
+
+namespace service {
+
+// Local control API of the long-running service mode. Listens on a Unix
+// domain socket and takes one command per line, answering each with one
+// line of JSON ({"ok":true,...} or {"ok":false,"error":"..."}):
+//   list                 Applications that can be recorded
+//   start <index>        Start recording a sink input
+//   stop <index>         Stop recording it; buffered audio is still recognized
+//   status               Recorded sink inputs and pipeline counters
+//   subscribe [format]   Turn this connection into a result stream, in
+//                        jsonl (default), text, srt or vtt
+//   trace [start|stop <path>]
+//                        Start a hot-path trace, or stop it and write it as
+//                        Chrome trace JSON; without arguments, trace status
+//   help
+// Models stay loaded in the capture's pipeline between sessions, so a start
+// only opens a PulseAudio stream. Commands run on the server thread, which
+// is the only caller of the capture while the server runs.
+class ControlServer {
+public:
+    ControlServer(const std::string& socket_path, audio::IAudioCapture& capture,
+                  std::shared_ptr<output::OutputWriter> output);
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // Throws std::runtime_error if the socket cannot be created
+    void start();
+    // Closes every connection except subscribers, which the output writer owns
+    void stop();
+
+    // Runs one command line and returns the JSON answer, without the newline.
+    // Exposed for tests; subscribe is only handled on a connection.
+    std::string handle_command(const std::string& line);
+
+private:
+    void serve_loop();
+    void accept_clients();
+    // Reads what the client sent and answers complete lines; false once the
+    // connection is closed or handed to the output writer
+    bool serve_client(int fd, std::string& buffer);
+
+    std::string socket_path_;
+    audio::IAudioCapture& capture_;
+    std::shared_ptr<output::OutputWriter> output_;
+
+    int listener_;
+    std::map<int, std::string> clients_;  // Unfinished input line per connection
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+} // namespace service
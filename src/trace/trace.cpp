@@ -0,0 +1,269 @@
+#include "trace/trace.h"
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace trace {
+
+namespace detail {
+std::atomic<bool> g_enabled{false};
+} // namespace detail
+
+namespace {
+
+struct Event {
+    const char* name;
+    const char* category;
+    int64_t start_ns;
+    int64_t end_ns;
+    uint64_t id;  // Async events only
+    bool async;
+};
+
+// Written by its owning thread only. count is published with a release
+// store after the event, so readers see complete events up to it.
+struct ThreadBuffer {
+    explicit ThreadBuffer(uint32_t tid) : tid(tid), events(new Event[kEventsPerThread]) {}
+
+    const uint32_t tid;
+    std::unique_ptr<Event[]> events;
+    std::atomic<const char*> name{nullptr};
+    std::atomic<bool> in_use{true};  // Cleared when the owning thread exits
+    std::atomic<uint64_t> epoch{0};  // Trace the events belong to
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+struct Registry {
+    std::mutex mutex;  // Guards buffers, not their contents
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::mutex control_mutex;  // Serializes Start() and exports
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<int64_t> start_ns{0};
+};
+
+// Never destroyed: threads may still record during static destruction
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+struct ThreadState {
+    ThreadBuffer* buffer = nullptr;
+    const char* name = nullptr;
+
+    ~ThreadState() {
+        if (buffer) {
+            buffer->in_use.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadState t_state;
+
+// Takes the buffer of an exited thread whose events belong to an older
+// trace, or allocates one
+ThreadBuffer* acquire_buffer() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    const uint64_t epoch = r.epoch.load(std::memory_order_acquire);
+    ThreadBuffer* buffer = nullptr;
+    for (auto& candidate : r.buffers) {
+        if (!candidate->in_use.load(std::memory_order_acquire)
+            && candidate->epoch.load(std::memory_order_relaxed) != epoch) {
+            buffer = candidate.get();
+            buffer->in_use.store(true, std::memory_order_relaxed);
+            break;
+        }
+    }
+    if (!buffer) {
+        r.buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<uint32_t>(r.buffers.size() + 1)));
+        buffer = r.buffers.back().get();
+    }
+    buffer->name.store(t_state.name, std::memory_order_relaxed);
+    return buffer;
+}
+
+void record(const Event& event) {
+    ThreadBuffer* buffer = t_state.buffer;
+    if (!buffer) {
+        buffer = t_state.buffer = acquire_buffer();
+    }
+
+    // Events of an earlier trace are discarded by their own thread, the only writer
+    const uint64_t epoch = registry().epoch.load(std::memory_order_acquire);
+    if (buffer->epoch.load(std::memory_order_relaxed) != epoch) {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->epoch.store(epoch, std::memory_order_release);
+    }
+
+    const size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= kEventsPerThread) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[index] = event;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+// Names are literals; escape anyway so a stray quote cannot break the file
+void write_string(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text ? text : ""; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\';
+        }
+        out << (static_cast<unsigned char>(*c) < 0x20 ? ' ' : *c);
+    }
+    out << '"';
+}
+
+// Microseconds since the trace started, the unit of the format
+void write_timestamp(std::ostream& out, int64_t ns, int64_t start_ns) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", static_cast<double>(ns - start_ns) / 1000.0);
+    out << buffer;
+}
+
+void write_event_head(std::ostream& out, const Event& event, const char* phase, uint32_t tid) {
+    out << "{\"name\":";
+    write_string(out, event.name);
+    out << ",\"cat\":";
+    write_string(out, event.category);
+    out << ",\"ph\":\"" << phase << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+}
+
+} // namespace
+
+void Start() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.control_mutex);
+    r.start_ns.store(NowNs(), std::memory_order_relaxed);
+    r.epoch.fetch_add(1, std::memory_order_acq_rel);
+    detail::g_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Stop() {
+    detail::g_enabled.store(false, std::memory_order_relaxed);
+}
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SetThreadName(const char* name) {
+    t_state.name = name;
+    if (t_state.buffer) {
+        t_state.buffer->name.store(name, std::memory_order_relaxed);
+    }
+}
+
+void RecordSpan(const char* name, const char* category, int64_t start_ns, int64_t end_ns) {
+    record(Event{name, category, start_ns, end_ns, 0, false});
+}
+
+void RecordAsync(const char* name, const char* category, uint64_t id, int64_t start_ns, int64_t end_ns) {
+    if (Enabled()) {
+        record(Event{name, category, start_ns, end_ns, id, true});
+    }
+}
+
+TraceStats Stats() {
+    Registry& r = registry();
+    TraceStats stats;
+    std::lock_guard<std::mutex> lock(r.mutex);
+    const uint64_t epoch = r.epoch.load(std::memory_order_acquire);
+    for (const auto& buffer : r.buffers) {
+        if (buffer->epoch.load(std::memory_order_acquire) != epoch) {
+            continue;
+        }
+        stats.events += buffer->count.load(std::memory_order_acquire);
+        stats.dropped += buffer->dropped.load(std::memory_order_relaxed);
+        ++stats.threads;
+    }
+    return stats;
+}
+
+void WriteChromeTrace(std::ostream& out) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> control(r.control_mutex);
+    const uint64_t epoch = r.epoch.load(std::memory_order_acquire);
+    const int64_t start_ns = r.start_ns.load(std::memory_order_relaxed);
+
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto& buffer : r.buffers) {
+            buffers.push_back(buffer.get());
+        }
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&out, &first]() {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+    for (ThreadBuffer* buffer : buffers) {
+        if (buffer->epoch.load(std::memory_order_acquire) != epoch) {
+            continue;
+        }
+        const size_t count = buffer->count.load(std::memory_order_acquire);
+        if (count == 0) {
+            continue;
+        }
+
+        const char* name = buffer->name.load(std::memory_order_relaxed);
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+        if (name) {
+            write_string(out, name);
+        } else {
+            out << "\"thread " << buffer->tid << "\"";
+        }
+        out << "}}";
+
+        for (size_t i = 0; i < count; ++i) {
+            const Event& event = buffer->events[i];
+            separator();
+            if (!event.async) {
+                write_event_head(out, event, "X", buffer->tid);
+                write_timestamp(out, event.start_ns, start_ns);
+                out << ",\"dur\":";
+                write_timestamp(out, event.end_ns, event.start_ns);
+                out << "}";
+                continue;
+            }
+            char id[24];
+            std::snprintf(id, sizeof(id), "\"0x%" PRIx64 "\"", event.id);
+            write_event_head(out, event, "b", buffer->tid);
+            write_timestamp(out, event.start_ns, start_ns);
+            out << ",\"id\":" << id << "},\n";
+            write_event_head(out, event, "e", buffer->tid);
+            write_timestamp(out, event.end_ns, start_ns);
+            out << ",\"id\":" << id << "}";
+        }
+    }
+    out << "\n]}\n";
+}
+
+void WriteChromeTrace(const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Failed to open trace file: " + path);
+    }
+    WriteChromeTrace(out);
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Failed to write trace file: " + path);
+    }
+}
+
+} // namespace trace
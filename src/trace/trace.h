@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace trace {
+
+// Timeline tracing of the hot paths (capture callback, VAD, decode,
+// translation requests, output), exported as Chrome trace JSON for
+// chrome://tracing or ui.perfetto.dev.
+//
+// Every thread records into its own fixed-size buffer that only it writes,
+// publishing each event with a release store, so recording takes no lock
+// and the exporter can read while threads keep recording. While tracing is
+// off a span costs one relaxed atomic load. Buffers are allocated the first
+// time a thread records and are reused after the thread exits.
+// Names and categories must be string literals (or otherwise outlive the trace).
+
+// Events one thread can hold per trace; later ones are counted as dropped
+constexpr size_t kEventsPerThread = 1 << 16;
+
+namespace detail {
+extern std::atomic<bool> g_enabled;
+} // namespace detail
+
+inline bool Enabled() {
+    return detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+// Starts a new trace, discarding the events of the last one
+void Start();
+// Stops recording; the events stay until the next Start()
+void Stop();
+
+// steady_clock time in nanoseconds, the time base of all events
+int64_t NowNs();
+
+// Names the calling thread's track in the trace, e.g. "vad"
+void SetThreadName(const char* name);
+
+// Records a span on the calling thread's track
+void RecordSpan(const char* name, const char* category, int64_t start_ns, int64_t end_ns);
+// Records work that starts on one thread and ends on another, e.g. an HTTP
+// request, as an async event on its own track; id tells overlapping ones apart
+void RecordAsync(const char* name, const char* category, uint64_t id, int64_t start_ns, int64_t end_ns);
+
+struct TraceStats {
+    uint64_t events = 0;
+    uint64_t dropped = 0;  // Buffer was full
+    size_t threads = 0;    // Threads that recorded anything
+};
+
+TraceStats Stats();
+
+// Writes the events of the current or last trace. Safe while recording;
+// events recorded meanwhile may or may not be included.
+void WriteChromeTrace(std::ostream& out);
+// Throws std::runtime_error if the file cannot be written
+void WriteChromeTrace(const std::string& path);
+
+// Records the scope as a span while tracing is on
+class Span {
+public:
+    Span(const char* name, const char* category)
+        : name_(name)
+        , category_(category)
+        , start_ns_(Enabled() ? NowNs() : 0) {}
+
+    ~Span() {
+        if (start_ns_ != 0) {
+            RecordSpan(name_, category_, start_ns_, NowNs());
+        }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* name_;
+    const char* category_;
+    const int64_t start_ns_;  // 0 if tracing was off when the scope began
+};
+
+} // namespace trace
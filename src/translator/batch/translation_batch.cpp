@@ -0,0 +1,60 @@
+#include "translator/batch/translation_batch.h"
+
+namespace translator {
+
+namespace {
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+std::string trim(const std::string& text, size_t begin, size_t end) {
+    while (begin < end && is_space(text[begin])) {
+        ++begin;
+    }
+    while (end > begin && is_space(text[end - 1])) {
+        --end;
+    }
+    return text.substr(begin, end - begin);
+}
+
+} // namespace
+
+std::string JoinBatch(const std::vector<std::string>& texts) {
+    std::string joined;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        if (i > 0) {
+            joined += '\n';
+        }
+        std::string line = trim(texts[i], 0, texts[i].size());
+        for (char& c : line) {
+            if (c == '\n' || c == '\r') {
+                c = ' ';
+            }
+        }
+        joined += line;
+    }
+    return joined;
+}
+
+bool SplitBatch(const std::string& translation, size_t count, std::vector<std::string>& parts) {
+    parts.clear();
+    // Ignore line breaks the service added around the whole text
+    const std::string text = trim(translation, 0, translation.size());
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = text.find('\n', begin);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        std::string part = trim(text, begin, end);
+        if (part.empty()) {
+            return false;
+        }
+        parts.push_back(std::move(part));
+        begin = end + 1;
+    }
+    return parts.size() == count;
+}
+
+} // namespace translator
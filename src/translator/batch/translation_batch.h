@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace translator {
+
+// Several short texts sent as one translation request: one text per line,
+// with the translation split back at the line breaks. Translation services
+// keep line breaks, but may still merge or split lines of closely related
+// text; SplitBatch() then fails and the caller translates the texts one by one.
+
+// Line breaks inside a text are replaced by spaces so every text is one line.
+// Texts must not be blank.
+std::string JoinBatch(const std::vector<std::string>& texts);
+
+// Splits a translation of JoinBatch() output into count parts, trimmed.
+// False if the line count does not match or a line came back blank.
+bool SplitBatch(const std::string& translation, size_t count, std::vector<std::string>& parts);
+
+} // namespace translator
@@ -0,0 +1,283 @@
+#include "translator/cache/persistent_translation_store.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace translator {
+
+namespace {
+
+constexpr char kMagic[8] = {'V', 'A', 'T', 'C', 'A', 'C', 'H', 'E'};
+constexpr uint32_t kVersion = 1;
+
+// File header, followed by records from kHeaderSize up to used
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t capacity;
+    uint64_t used;
+};
+
+constexpr size_t kHeaderSize = 64;
+static_assert(sizeof(FileHeader) <= kHeaderSize, "header does not fit");
+
+// Record layout: key size, value size, checksum, key, value, padding to 8 bytes
+struct RecordHeader {
+    uint32_t key_size;
+    uint32_t value_size;
+    uint64_t checksum;
+};
+
+constexpr size_t kRecordAlign = 8;
+
+size_t record_size(size_t key_size, size_t value_size) {
+    const size_t size = sizeof(RecordHeader) + key_size + value_size;
+    return (size + kRecordAlign - 1) / kRecordAlign * kRecordAlign;
+}
+
+uint64_t fnv1a(const char* data, size_t n, uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < n; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t checksum(const char* key, size_t key_size, const char* value, size_t value_size) {
+    // Include the sizes so a record cannot validate with a shifted boundary
+    uint64_t hash = fnv1a(key, key_size);
+    hash = fnv1a(value, value_size, hash ^ (static_cast<uint64_t>(key_size) << 32 | value_size));
+    return hash;
+}
+
+uint64_t key_hash(const std::string& key) {
+    return fnv1a(key.data(), key.size());
+}
+
+// Writes a record at dst, which must have record_size() bytes
+void write_record(char* dst, const char* key, size_t key_size, const char* value, size_t value_size) {
+    RecordHeader header;
+    header.key_size = static_cast<uint32_t>(key_size);
+    header.value_size = static_cast<uint32_t>(value_size);
+    header.checksum = checksum(key, key_size, value, value_size);
+    std::memcpy(dst, &header, sizeof(header));
+    std::memcpy(dst + sizeof(header), key, key_size);
+    std::memcpy(dst + sizeof(header) + key_size, value, value_size);
+    const size_t used = sizeof(header) + key_size + value_size;
+    std::memset(dst + used, 0, record_size(key_size, value_size) - used);
+}
+
+FileHeader* header_of(char* data) {
+    return reinterpret_cast<FileHeader*>(data);
+}
+
+} // namespace
+
+#ifdef _WIN32
+
+PersistentTranslationStore::PersistentTranslationStore(const std::string& path, size_t capacity)
+    : path_(path), capacity_(capacity), fd_(-1), data_(nullptr) {
+    throw std::runtime_error("Persistent translation cache is not supported on this platform");
+}
+
+PersistentTranslationStore::~PersistentTranslationStore() = default;
+void PersistentTranslationStore::open_mapping() {}
+void PersistentTranslationStore::close_mapping() {}
+
+#else
+
+PersistentTranslationStore::PersistentTranslationStore(const std::string& path, size_t capacity)
+    : path_(path)
+    , capacity_(std::max(capacity, kHeaderSize * 2))
+    , fd_(-1)
+    , data_(nullptr) {
+    open_mapping();
+    load_index();
+}
+
+PersistentTranslationStore::~PersistentTranslationStore() {
+    close_mapping();
+}
+
+void PersistentTranslationStore::open_mapping() {
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open translation cache " + path_ + ": " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (::fstat(fd_, &st) != 0 || ::ftruncate(fd_, static_cast<off_t>(capacity_)) != 0) {
+        const std::string error = std::strerror(errno);
+        close_mapping();
+        throw std::runtime_error("Failed to size translation cache " + path_ + ": " + error);
+    }
+
+    void* mapping = ::mmap(nullptr, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        const std::string error = std::strerror(errno);
+        close_mapping();
+        throw std::runtime_error("Failed to map translation cache " + path_ + ": " + error);
+    }
+    data_ = static_cast<char*>(mapping);
+
+    // A new, foreign or resized file starts empty; a smaller capacity would
+    // cut records off, a larger one just leaves room to grow
+    FileHeader* header = header_of(data_);
+    const bool valid = static_cast<size_t>(st.st_size) >= kHeaderSize
+        && std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0
+        && header->version == kVersion
+        && header->used >= kHeaderSize && header->used <= capacity_;
+    if (!valid) {
+        std::memset(data_, 0, kHeaderSize);
+        std::memcpy(header->magic, kMagic, sizeof(kMagic));
+        header->version = kVersion;
+        header->used = kHeaderSize;
+    }
+    header->capacity = capacity_;
+}
+
+void PersistentTranslationStore::close_mapping() {
+    if (data_) {
+        ::munmap(data_, capacity_);
+        data_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+#endif
+
+bool PersistentTranslationStore::read_record(uint64_t offset, uint64_t end, RecordView& record) const {
+    if (offset + sizeof(RecordHeader) > end) {
+        return false;
+    }
+    RecordHeader header;
+    std::memcpy(&header, data_ + offset, sizeof(header));
+    const size_t size = record_size(header.key_size, header.value_size);
+    if (header.key_size == 0 || offset + size > end) {
+        return false;
+    }
+
+    record.key = data_ + offset + sizeof(RecordHeader);
+    record.key_size = header.key_size;
+    record.value = record.key + header.key_size;
+    record.value_size = header.value_size;
+    record.size = size;
+    return header.checksum == checksum(record.key, record.key_size, record.value, record.value_size);
+}
+
+void PersistentTranslationStore::load_index() {
+    index_.clear();
+    FileHeader* header = header_of(data_);
+    uint64_t offset = kHeaderSize;
+    RecordView record;
+    while (read_record(offset, header->used, record)) {
+        // Later records of the same key supersede earlier ones
+        index_[fnv1a(record.key, record.key_size)] = offset;
+        offset += record.size;
+    }
+    // Drop a torn tail so new records are appended after the last valid one
+    header->used = offset;
+}
+
+bool PersistentTranslationStore::get(const std::string& key, std::string& value) const {
+    auto it = index_.find(key_hash(key));
+    if (it == index_.end()) {
+        return false;
+    }
+    RecordView record;
+    if (!read_record(it->second, header_of(data_)->used, record)
+        || record.key_size != key.size() || std::memcmp(record.key, key.data(), key.size()) != 0) {
+        // Hash collision with another key
+        return false;
+    }
+    value.assign(record.value, record.value_size);
+    return true;
+}
+
+void PersistentTranslationStore::put(const std::string& key, const std::string& value) {
+    const size_t size = record_size(key.size(), value.size());
+    if (key.empty() || size > (capacity_ - kHeaderSize) / 2) {
+        return;
+    }
+
+    FileHeader* header = header_of(data_);
+    if (header->used + size > capacity_) {
+        compact();
+        header = header_of(data_);
+    }
+
+    // Write the record before publishing it in the header, so a crash leaves
+    // at worst an unreferenced record behind
+    write_record(data_ + header->used, key.data(), key.size(), value.data(), value.size());
+    index_[key_hash(key)] = header->used;
+    header->used += size;
+}
+
+size_t PersistentTranslationStore::bytes_used() const {
+    return static_cast<size_t>(header_of(data_)->used);
+}
+
+void PersistentTranslationStore::compact() {
+    // Live records, oldest first; keep the newest ones that fit in half the file
+    std::vector<uint64_t> live;
+    live.reserve(index_.size());
+    for (const auto& entry : index_) {
+        live.push_back(entry.second);
+    }
+    std::sort(live.begin(), live.end());
+
+    const uint64_t used = header_of(data_)->used;
+    const size_t budget = (capacity_ - kHeaderSize) / 2;
+    size_t kept_bytes = 0;
+    size_t first_kept = live.size();
+    RecordView record;
+    while (first_kept > 0 && read_record(live[first_kept - 1], used, record)
+           && kept_bytes + record.size <= budget) {
+        kept_bytes += record.size;
+        --first_kept;
+    }
+
+    std::vector<char> records;
+    records.reserve(kept_bytes);
+    for (size_t i = first_kept; i < live.size(); ++i) {
+        read_record(live[i], used, record);
+        records.insert(records.end(), data_ + live[i], data_ + live[i] + record.size);
+    }
+
+#ifndef _WIN32
+    // Build the compacted file next to the old one and swap it in atomically,
+    // so a crash during compaction keeps the old contents
+    const std::string tmp_path = path_ + ".tmp";
+    ::unlink(tmp_path.c_str());
+    const std::string path = path_;
+    close_mapping();
+    path_ = tmp_path;
+    open_mapping();
+    std::memcpy(data_ + kHeaderSize, records.data(), records.size());
+    header_of(data_)->used = kHeaderSize + records.size();
+    ::msync(data_, capacity_, MS_SYNC);
+    const bool renamed = ::rename(tmp_path.c_str(), path.c_str()) == 0;
+    const std::string error = renamed ? std::string() : std::strerror(errno);
+    path_ = path;
+    if (!renamed) {
+        throw std::runtime_error("Failed to replace translation cache " + path + ": " + error);
+    }
+#endif
+    load_index();
+}
+
+} // namespace translator
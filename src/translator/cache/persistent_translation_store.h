@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace translator {
+
+// Append-only translation log in a memory-mapped file of fixed size, so
+// translations survive restarts. Each record is the cache key, the
+// translation and a checksum; an in-memory index maps key hashes to the
+// newest record, and lookups read straight from the mapping. When the file
+// is full it is compacted: superseded records are dropped, then the oldest
+// live ones until at most half the file is used. A torn write at the end
+// (crash mid-append) fails its checksum and is ignored on the next open.
+//
+// Not thread-safe; TranslationCache serializes access.
+class PersistentTranslationStore {
+public:
+    // Opens or creates the file at path with room for capacity bytes.
+    // Throws std::runtime_error if the file cannot be created or mapped.
+    PersistentTranslationStore(const std::string& path, size_t capacity);
+    ~PersistentTranslationStore();
+
+    PersistentTranslationStore(const PersistentTranslationStore&) = delete;
+    PersistentTranslationStore& operator=(const PersistentTranslationStore&) = delete;
+
+    bool get(const std::string& key, std::string& value) const;
+    // Records larger than half the file are not stored
+    void put(const std::string& key, const std::string& value);
+
+    size_t entries() const { return index_.size(); }
+    size_t bytes_used() const;
+
+private:
+    struct RecordView {
+        const char* key;
+        uint32_t key_size;
+        const char* value;
+        uint32_t value_size;
+        size_t size;  // Whole record including header and padding
+    };
+
+    void open_mapping();
+    void close_mapping();
+    // Validates the record at offset; false if it is torn or past the end
+    bool read_record(uint64_t offset, uint64_t end, RecordView& record) const;
+    void load_index();
+    void compact();
+
+    std::string path_;
+    size_t capacity_;
+    int fd_;
+    char* data_;
+    std::unordered_map<uint64_t, uint64_t> index_;  // Key hash -> offset of its newest record
+};
+
+} // namespace translator
@@ -0,0 +1,146 @@
+#include "translator/cache/translation_cache.h"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <stdexcept>
+
+namespace translator {
+
+namespace {
+
+// Separates the key fields; cannot occur in a language code and is stripped from text
+constexpr char kKeySeparator = '\x1f';
+
+bool is_space(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v' || c == kKeySeparator;
+}
+
+// U+3000 IDEOGRAPHIC SPACE, common in CJK recognizer output
+bool is_ideographic_space(const std::string& text, size_t i) {
+    return text.compare(i, 3, "\xe3\x80\x80") == 0;
+}
+
+std::string upper(std::string code) {
+    std::transform(code.begin(), code.end(), code.begin(), ::toupper);
+    return code;
+}
+
+} // namespace
+
+TranslationCache::TranslationCache(const common::TranslationCacheConfig& config)
+    : max_bytes_(static_cast<size_t>(std::max(0, config.max_memory_mb)) << 20)
+    , bytes_(0)
+    , hits_(0)
+    , disk_hits_(0)
+    , misses_(0) {
+    if (!config.disk_path.empty()) {
+        try {
+            disk_ = std::make_unique<PersistentTranslationStore>(
+                config.disk_path, static_cast<size_t>(std::max(1, config.disk_max_mb)) << 20);
+            std::cerr << "Translation cache: " << disk_->entries() << " translations loaded from "
+                      << config.disk_path << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Translation cache kept in memory only: " << e.what() << std::endl;
+        }
+    }
+}
+
+std::string TranslationCache::Normalize(const std::string& text) {
+    std::string normalized;
+    normalized.reserve(text.size());
+    bool pending_space = false;
+    for (size_t i = 0; i < text.size();) {
+        if (is_space(static_cast<unsigned char>(text[i]))) {
+            pending_space = true;
+            ++i;
+        } else if (is_ideographic_space(text, i)) {
+            pending_space = true;
+            i += 3;
+        } else {
+            if (pending_space && !normalized.empty()) {
+                normalized += ' ';
+            }
+            pending_space = false;
+            normalized += text[i++];
+        }
+    }
+    return normalized;
+}
+
+std::string TranslationCache::MakeKey(const std::string& source_lang, const std::string& target_lang,
+                                      const std::string& text) {
+    return upper(source_lang) + kKeySeparator + upper(target_lang) + kKeySeparator + Normalize(text);
+}
+
+bool TranslationCache::lookup(const std::string& key, std::string& translation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        entries_.splice(entries_.begin(), entries_, it->second);
+        translation = it->second->translation;
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    if (disk_ && disk_->get(key, translation)) {
+        insert(key, translation);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        disk_hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void TranslationCache::store(const std::string& key, const std::string& translation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    insert(key, translation);
+    if (disk_) {
+        try {
+            disk_->put(key, translation);
+        } catch (const std::exception& e) {
+            std::cerr << "Translation cache disabled on disk: " << e.what() << std::endl;
+            disk_.reset();
+        }
+    }
+}
+
+void TranslationCache::insert(const std::string& key, const std::string& translation) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        bytes_ -= entry_bytes(*it->second);
+        it->second->translation = translation;
+        bytes_ += entry_bytes(*it->second);
+        entries_.splice(entries_.begin(), entries_, it->second);
+    } else {
+        entries_.push_front(Entry{key, translation});
+        bytes_ += entry_bytes(entries_.front());
+        index_.emplace(entries_.front().key, entries_.begin());
+    }
+
+    while (bytes_ > max_bytes_ && !entries_.empty()) {
+        const Entry& oldest = entries_.back();
+        bytes_ -= entry_bytes(oldest);
+        index_.erase(oldest.key);
+        entries_.pop_back();
+    }
+}
+
+TranslationCacheStats TranslationCache::stats() const {
+    TranslationCacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.disk_hits = disk_hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.entries = entries_.size();
+    stats.bytes = bytes_;
+    if (disk_) {
+        stats.disk_entries = disk_->entries();
+        stats.disk_bytes = disk_->bytes_used();
+    }
+    return stats;
+}
+
+} // namespace translator
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "common/model_config.h"
+#include "translator/cache/persistent_translation_store.h"
+
+namespace translator {
+
+struct TranslationCacheStats {
+    uint64_t hits = 0;       // Served from memory or disk
+    uint64_t disk_hits = 0;  // Of which read from the persistent store
+    uint64_t misses = 0;
+    size_t entries = 0;      // In memory
+    size_t bytes = 0;        // In memory, including per-entry overhead
+    size_t disk_entries = 0;
+    size_t disk_bytes = 0;
+};
+
+// Finished translations keyed by source language, target language and
+// normalized text. Recently used entries are kept in memory up to
+// max_memory_mb; with a disk_path, every stored translation is also appended
+// to a PersistentTranslationStore, which is consulted on memory misses and
+// outlives the process. Thread-safe.
+class TranslationCache {
+public:
+    // Falls back to memory only, with a warning, if the disk store cannot be opened
+    explicit TranslationCache(const common::TranslationCacheConfig& config);
+
+    TranslationCache(const TranslationCache&) = delete;
+    TranslationCache& operator=(const TranslationCache&) = delete;
+
+    // Cache key for a request; language codes are compared case-insensitively
+    static std::string MakeKey(const std::string& source_lang, const std::string& target_lang,
+                               const std::string& text);
+
+    // Trims the text and collapses runs of whitespace, so recognizer output
+    // that differs only in spacing shares one entry
+    static std::string Normalize(const std::string& text);
+
+    bool lookup(const std::string& key, std::string& translation);
+    void store(const std::string& key, const std::string& translation);
+
+    TranslationCacheStats stats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        std::string translation;
+    };
+
+    // Approximate heap cost of one entry beyond its strings: list node, hash node, bucket
+    static constexpr size_t kEntryOverhead = 128;
+
+    static size_t entry_bytes(const Entry& entry) {
+        return entry.key.size() + entry.translation.size() + kEntryOverhead;
+    }
+
+    // Callers hold mutex_
+    void insert(const std::string& key, const std::string& translation);
+
+    const size_t max_bytes_;
+
+    mutable std::mutex mutex_;
+    std::list<Entry> entries_;  // Most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;  // Views into entries_ keys
+    size_t bytes_;
+    std::unique_ptr<PersistentTranslationStore> disk_;
+
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> disk_hits_;
+    std::atomic<uint64_t> misses_;
+};
+
+} // namespace translator
@@ -1,53 +1,90 @@
 #include "translator/deepl/deeplx_translator.h"
-#include <iostream>
 #include <regex>
 #include <sstream>
 #include <stdexcept>
 #include <algorithm>
 #include <nlohmann/json.hpp>
+#include "translator/batch/translation_batch.h"
+#include "trace/trace.h"
 
 using json = nlohmann::json;
 
-namespace {
-
-size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
-    userp->append((char*)contents, size * nmemb);
-    return size * nmemb;
-}
-
-} // namespace
-
 namespace deeplx {
 
-DeepLXTranslator::DeepLXTranslator(const common::ModelConfig& config) {
+DeepLXTranslator::DeepLXTranslator(const common::ModelConfig& config)
+    : active_(0)
+    , stopping_(false)
+    , requests_sent_(0)
+    , batched_requests_(0)
+    , batched_texts_(0)
+    , batch_split_failures_(0)
+    , transport_errors_(metrics::Registry::Instance().counter(
+          "voice_assistant_translation_errors_total", "Failed translation requests by cause",
+          {{"cause", "transport"}}))
+    , status_errors_(metrics::Registry::Instance().counter(
+          "voice_assistant_translation_errors_total", "Failed translation requests by cause",
+          {{"cause", "status"}}))
+    , response_errors_(metrics::Registry::Instance().counter(
+          "voice_assistant_translation_errors_total", "Failed translation requests by cause",
+          {{"cause", "response"}}))
+    , request_seconds_(metrics::Registry::Instance().histogram(
+          "voice_assistant_translation_request_seconds", "DeepLX request time, retries included",
+          {0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10}))
+    , metrics_collector_(0) {
     url_ = config.deeplx.url;
     token_ = config.deeplx.token;
     target_lang_ = config.deeplx.target_lang;
     // target_lang_ 需要输出大写
     std::transform(target_lang_.begin(), target_lang_.end(), target_lang_.begin(), ::toupper);
-    enabled_ = config.deeplx.enabled;
-    // Parse URL to get host, port, and path
-    std::regex url_regex("^(https?://)?([^/:]+)(?::(\\d+))?(/.*)?$");
+    max_concurrent_ = static_cast<size_t>(std::max(1, config.deeplx.max_concurrent_requests));
+    batch_size_ = static_cast<size_t>(std::max(1, config.deeplx.batch_size));
+    batch_delay_ = std::chrono::milliseconds(std::max(0, config.deeplx.batch_delay_ms));
+    batch_max_chars_ = static_cast<size_t>(std::max(1, config.deeplx.batch_max_chars));
+    if (config.translation_cache.enabled) {
+        cache_ = std::make_unique<translator::TranslationCache>(config.translation_cache);
+    }
+    // Validate the URL; the scheme defaults to http, an https URL is kept as is
+    std::regex url_regex("^(https?://)?([^/:]+)(?::(\\d+))?(/.*)?$", std::regex::icase);
     std::smatch matches;
-    std::cout << "URL: " << url_ << std::endl;
-    if (std::regex_match(url_, matches, url_regex)) {
-        host_ = matches[2].str();
-        port_ = matches[3].length() > 0 ? std::stoi(matches[3].str()) : 80;
-        path_ = matches[4].length() > 0 ? matches[4].str() : "/";
-    } else {
+    if (!std::regex_match(url_, matches, url_regex)) {
         throw std::runtime_error("Invalid URL format");
     }
+    request_url_ = (matches[1].length() > 0 ? std::string() : std::string("http://")) + url_;
+    if (matches[4].length() == 0) {
+        request_url_ += "/";
+    }
 
-    curl_ = curl_easy_init();
-    if (!curl_) {
-        throw std::runtime_error("Failed to initialize CURL");
+    translator::HttpClientConfig http_config;
+    http_config.headers.push_back("Content-Type: application/json");
+    if (!token_.empty()) {
+        http_config.headers.push_back("Authorization: Bearer " + token_);
     }
+    http_config.max_connections = config.deeplx.max_concurrent_requests;
+    http_config.connect_timeout_ms = config.deeplx.connect_timeout_ms;
+    http_config.timeout_ms = config.deeplx.timeout_ms;
+    http_config.max_retries = config.deeplx.max_retries;
+    http_config.retry_backoff_ms = config.deeplx.retry_backoff_ms;
+    http_config.dns_cache_seconds = config.deeplx.dns_cache_seconds;
+    http_ = std::make_unique<translator::HttpClient>(http_config);
+
+    worker_ = std::thread(&DeepLXTranslator::worker_loop, this);
+    metrics_collector_ = metrics::Registry::Instance().add_collector(
+        [this](metrics::Exposition& out) { collect_metrics(out); });
 }
 
 DeepLXTranslator::~DeepLXTranslator() {
-    if (curl_) {
-        curl_easy_cleanup(curl_);
+    metrics::Registry::Instance().remove_collector(metrics_collector_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
     }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    // Every request has finished; wait for the HTTP worker to return from
+    // the last callback before the members it touched go away
+    http_.reset();
 }
 
 bool DeepLXTranslator::needs_translation(const std::string& source_lang) const {
@@ -63,77 +100,312 @@ std::string DeepLXTranslator::get_target_language() const {
     return target_lang_;
 }
 
+std::string DeepLXTranslator::stats_summary() const {
+    std::ostringstream summary;
+    if (cache_) {
+        const translator::TranslationCacheStats stats = cache_->stats();
+        const uint64_t lookups = stats.hits + stats.misses;
+        summary << "Translation cache: " << stats.hits << " hits (" << stats.disk_hits << " from disk), "
+                << stats.misses << " misses";
+        if (lookups > 0) {
+            summary << ", hit rate " << (100 * stats.hits / lookups) << "%";
+        }
+        summary << "; " << stats.entries << " entries, " << (stats.bytes >> 10) << " KiB in memory";
+        if (stats.disk_bytes > 0) {
+            summary << ", " << stats.disk_entries << " entries, " << (stats.disk_bytes >> 10) << " KiB on disk";
+        }
+    }
+    if (cache_) {
+        summary << "\n";
+    }
+    summary << "Translation requests: " << requests_sent_.load() << " sent";
+    if (batch_size_ > 1) {
+        summary << ", " << batched_requests_.load() << " batches carrying " << batched_texts_.load() << " texts, "
+                << batch_split_failures_.load() << " batches resent one by one";
+    }
+    const translator::HttpClientStats http = http_->stats();
+    summary << "\nTranslation HTTP: " << http.retries << " retries, " << http.failures << " failed; "
+            << http.connections_opened << " connections opened, " << http.connections_reused
+            << " answers on a reused connection, " << http.http2_responses << " over HTTP/2";
+    return summary.str();
+}
 
-std::string DeepLXTranslator::make_http_request(const std::string& host, int port,
-                                              const std::string& path, const std::string& data) const {
-    std::string response;
-    std::string url = "http://" + host + ":" + std::to_string(port) + path;
+void DeepLXTranslator::collect_metrics(metrics::Exposition& out) const {
+    size_t queued = 0;
+    size_t active = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued = pending_.size();
+        active = active_;
+    }
+    out.gauge("voice_assistant_translation_queue_depth", "Texts waiting for a translation request", {},
+              static_cast<double>(queued));
+    out.gauge("voice_assistant_translation_requests_active", "Translation requests awaiting an answer", {},
+              static_cast<double>(active));
+    out.counter("voice_assistant_translation_requests_total", "Translation requests sent", {},
+                static_cast<double>(requests_sent_.load(std::memory_order_relaxed)));
+    out.counter("voice_assistant_translation_batched_texts_total", "Texts sent in requests carrying several", {},
+                static_cast<double>(batched_texts_.load(std::memory_order_relaxed)));
+    out.counter("voice_assistant_translation_batch_split_failures_total",
+                "Batches whose answer could not be split, resent one text at a time", {},
+                static_cast<double>(batch_split_failures_.load(std::memory_order_relaxed)));
 
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, data.c_str());
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response);
+    const translator::HttpClientStats http = http_->stats();
+    out.counter("voice_assistant_translation_http_retries_total", "Translation HTTP attempts retried", {},
+                static_cast<double>(http.retries));
+    out.counter("voice_assistant_translation_http_connections_opened_total", "Translation HTTP connections opened",
+                {}, static_cast<double>(http.connections_opened));
 
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    if (!token_.empty()) {
-        std::string auth_header = "Authorization: Bearer " + token_;
-        headers = curl_slist_append(headers, auth_header.c_str());
+    if (cache_) {
+        const translator::TranslationCacheStats cache = cache_->stats();
+        out.counter("voice_assistant_translation_cache_hits_total", "Translations served from the cache", {},
+                    static_cast<double>(cache.hits));
+        out.counter("voice_assistant_translation_cache_misses_total", "Translation cache lookups that missed", {},
+                    static_cast<double>(cache.misses));
+        out.gauge("voice_assistant_translation_cache_bytes", "Translation cache size in memory", {},
+                  static_cast<double>(cache.bytes));
     }
-    curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
+}
 
-    CURLcode res = curl_easy_perform(curl_);
-    curl_slist_free_all(headers);
+// Takes the oldest queued item and, unless it must go alone, the items queued
+// right behind it in the same source language, up to batch_size_ texts and
+// batch_max_chars_. Keeping to consecutive items keeps requests in queue order.
+std::unique_ptr<DeepLXTranslator::Request> DeepLXTranslator::take_batch() {
+    auto request = std::make_unique<Request>();
+    size_t chars = pending_.front()->text.size();
+    request->items.push_back(std::move(pending_.front()));
+    pending_.pop_front();
 
-    if (res != CURLE_OK) {
-        throw std::runtime_error(std::string("CURL request failed: ") + curl_easy_strerror(res));
+    const Item& first = *request->items.front();
+    if (!first.batchable) {
+        return request;
+    }
+    while (!pending_.empty() && request->items.size() < batch_size_) {
+        const Item& next = *pending_.front();
+        if (!next.batchable || next.source_lang != first.source_lang
+            || chars + next.text.size() > batch_max_chars_) {
+            break;
+        }
+        chars += next.text.size();
+        request->items.push_back(std::move(pending_.front()));
+        pending_.pop_front();
     }
+    return request;
+}
+
+// Hands the request to the HTTP client. Worker thread only.
+void DeepLXTranslator::send_request(std::shared_ptr<Request> request) {
+    trace::Span span("deeplx_send", "translate");
+    const Item& first = *request->items.front();
+    std::string text;
+    if (request->items.size() == 1) {
+        text = first.text;
+    } else {
+        std::vector<std::string> texts;
+        texts.reserve(request->items.size());
+        for (const auto& item : request->items) {
+            texts.push_back(item->text);
+        }
+        text = translator::JoinBatch(texts);
+    }
+    json requestJson = {
+        {"text", text},
+        {"source_lang", first.source_lang},
+        {"target_lang", target_lang_}
+    };
 
-    return response;
+    const uint64_t sequence = requests_sent_.fetch_add(1, std::memory_order_relaxed);
+    request->sent = std::chrono::steady_clock::now();
+    if (trace::Enabled()) {
+        request->sent_ns = trace::NowNs();
+        request->trace_id = sequence + 1;
+    }
+    if (request->items.size() > 1) {
+        batched_requests_.fetch_add(1, std::memory_order_relaxed);
+        batched_texts_.fetch_add(request->items.size(), std::memory_order_relaxed);
+    }
+    http_->post(request_url_, requestJson.dump(), [this, request](translator::HttpResponse&& response) {
+        finish_request(*request, std::move(response));
+    });
 }
 
-DeepLXTranslator::HttpResponse DeepLXTranslator::send_post_request(const std::string& json_data) const {
-    std::string response_str = make_http_request(host_, port_, path_, json_data);
-    
-    HttpResponse response;
+std::string DeepLXTranslator::parse_response(const std::string& response) {
+    json responseJson;
     try {
-        json responseJson = json::parse(response_str);
-        response.status_code = responseJson["code"].get<int>();
-        response.body = response_str;
+        responseJson = json::parse(response);
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("Failed to parse response: ") + e.what());
     }
-    
-    return response;
+
+    if (responseJson["code"].get<int>() != 200) {
+        throw std::runtime_error("Translation API returned error code: " +
+                               std::to_string(responseJson["code"].get<int>()));
+    }
+
+    return responseJson["data"].get<std::string>();
 }
 
-std::string DeepLXTranslator::translate(const std::string& text, const std::string& source_lang) const {
-    if (!needs_translation(source_lang)) {
-        return text;
+void DeepLXTranslator::finish_request(Request& request, translator::HttpResponse&& response) {
+    trace::Span span("deeplx_response", "translate");
+    if (request.sent_ns != 0) {
+        // The whole round trip, retries included, on the request's own track
+        trace::RecordAsync("deeplx_request", "translate", request.trace_id, request.sent_ns, trace::NowNs());
+    }
+    request_seconds_.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - request.sent).count());
+    std::vector<std::string> translations;
+    std::exception_ptr error;
+    bool resend = false;
+    try {
+        if (!response.error.empty()) {
+            throw std::runtime_error("CURL request failed: " + response.error);
+        }
+        if (response.status != 200) {
+            throw std::runtime_error("Translation API returned HTTP status " + std::to_string(response.status));
+        }
+        std::string translation = parse_response(response.body);
+        if (request.items.size() == 1) {
+            translations.push_back(std::move(translation));
+        } else if (!translator::SplitBatch(translation, request.items.size(), translations)) {
+            resend = true;
+        }
+    } catch (const std::exception& e) {
+        (!response.error.empty() ? transport_errors_ : response.status != 200 ? status_errors_ : response_errors_).inc();
+        error = std::make_exception_ptr(std::runtime_error(std::string("Translation failed: ") + e.what()));
     }
 
-    json requestJson = {
-        {"text", text},
-        {"source_lang", source_lang},
-        {"target_lang", target_lang_}
-    };
+    if (!resend) {
+        for (size_t i = 0; i < request.items.size(); ++i) {
+            complete_item(*request.items[i], error ? std::string() : translations[i], error);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (resend) {
+            // The lines did not survive translation; resend the texts one by
+            // one, ahead of anything queued since
+            batch_split_failures_.fetch_add(1, std::memory_order_relaxed);
+            for (auto item = request.items.rbegin(); item != request.items.rend(); ++item) {
+                (*item)->batchable = false;
+                pending_.push_front(std::move(*item));
+            }
+        }
+        --active_;
+        cv_.notify_one();
+    }
+}
 
-    std::string jsonStr = requestJson.dump();
+void DeepLXTranslator::complete_item(Item& item, const std::string& translation, std::exception_ptr error) {
+    // Only successful translations are cached, so errors are retried.
+    // Stored before the item leaves in_flight_, so no identical text slips through in between.
+    if (!error && cache_) {
+        cache_->store(item.cache_key, translation);
+    }
 
-    try {
-        auto response = send_post_request(jsonStr);
-        json responseJson = json::parse(response.body);
+    std::vector<std::promise<std::string>> followers;
+    if (!item.cache_key.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_.erase(item.cache_key);
+        followers.swap(item.followers);
+    }
+    followers.push_back(std::move(item.promise));
+    for (auto& promise : followers) {
+        if (error) {
+            promise.set_exception(error);
+        } else {
+            promise.set_value(translation);
+        }
+    }
+}
 
-        if (responseJson["code"].get<int>() != 200) {
-            throw std::runtime_error("Translation API returned error code: " +
-                                   std::to_string(responseJson["code"].get<int>()));
+void DeepLXTranslator::worker_loop() {
+    trace::SetThreadName("deeplx");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (stopping_ && pending_.empty() && active_ == 0) {
+            break;
         }
 
-        return responseJson["data"].get<std::string>();
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Translation failed: ") + e.what());
+        // Admit queued texts up to the concurrency limit, oldest first. With a
+        // batch delay, a short queue is held until its oldest text has waited
+        // that long, so texts arriving meanwhile share its request.
+        std::vector<std::shared_ptr<Request>> admitted;
+        auto wake_at = std::chrono::steady_clock::time_point::max();
+        const auto now = std::chrono::steady_clock::now();
+        while (!pending_.empty() && active_ < max_concurrent_) {
+            const Item& oldest = *pending_.front();
+            if (batch_delay_.count() > 0 && !stopping_ && oldest.batchable && pending_.size() < batch_size_) {
+                const auto ready = oldest.queued + batch_delay_;
+                if (now < ready) {
+                    wake_at = ready;
+                    break;
+                }
+            }
+            admitted.push_back(take_batch());
+            ++active_;
+        }
+
+        if (admitted.empty()) {
+            // Woken by translate_async(), a finished request or shutdown
+            if (wake_at == std::chrono::steady_clock::time_point::max()) {
+                cv_.wait(lock);
+            } else {
+                cv_.wait_until(lock, wake_at);
+            }
+            continue;
+        }
+
+        lock.unlock();
+        for (auto& request : admitted) {
+            send_request(std::move(request));
+        }
+        lock.lock();
+    }
+}
+
+std::future<std::string> DeepLXTranslator::translate_async(const std::string& text, const std::string& source_lang) const {
+    auto item = std::make_unique<Item>();
+    std::future<std::string> future = item->promise.get_future();
+
+    if (!needs_translation(source_lang)) {
+        item->promise.set_value(text);
+        return future;
+    }
+
+    if (cache_) {
+        item->cache_key = translator::TranslationCache::MakeKey(source_lang, target_lang_, text);
+        std::string cached;
+        if (cache_->lookup(item->cache_key, cached)) {
+            item->promise.set_value(cached);
+            return future;
+        }
+    }
+
+    item->text = text;
+    item->source_lang = source_lang;
+    item->queued = std::chrono::steady_clock::now();
+    // A blank line would not survive the round trip through a batch
+    item->batchable = text.find_first_not_of(" \t\r\n") != std::string::npos;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!item->cache_key.empty()) {
+            auto it = in_flight_.find(item->cache_key);
+            if (it != in_flight_.end()) {
+                it->second->followers.push_back(std::move(item->promise));
+                return future;
+            }
+            in_flight_[item->cache_key] = item.get();
+        }
+        pending_.push_back(std::move(item));
     }
+    cv_.notify_one();
+
+    return future;
+}
+
+std::string DeepLXTranslator::translate(const std::string& text, const std::string& source_lang) const {
+    return translate_async(text, source_lang).get();
 }
 
-} // namespace deeplx 
\ No newline at end of file
+} // namespace deeplx
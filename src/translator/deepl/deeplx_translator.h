@@ -2,42 +2,110 @@
 
 #include <string>
 #include <memory>
-#include <curl/curl.h>
+#include <map>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <future>
+#include <condition_variable>
 #include "common/model_config.h"
 #include "translator/translator.h"
+#include "translator/cache/translation_cache.h"
+#include "translator/http/http_client.h"
+#include "metrics/metrics.h"
 
 namespace deeplx {
 
+// DeepLX client on top of the shared HttpClient. Texts are queued by
+// translate_async() and admitted by one worker thread, with at most
+// max_concurrent_requests requests in flight.
+// Finished translations are cached (see TranslationCache); a cached text is
+// answered without a request, and identical texts already in flight share
+// one request. Texts queued while every request is busy (or within
+// batch_delay_ms) are sent together in one request, see translation_batch.h.
 class DeepLXTranslator : public translator::ITranslator {
 public:
     explicit DeepLXTranslator(const common::ModelConfig& config);
     ~DeepLXTranslator() override;
 
     std::string translate(const std::string& text, const std::string& source_lang) const override;
+    std::future<std::string> translate_async(const std::string& text, const std::string& source_lang) const override;
 
     // get target language
     std::string get_target_language() const override;
+    std::string stats_summary() const override;
 
 private:
-    struct HttpResponse {
-        int status_code;
-        std::string body;
+    // One text submitted through translate_async()
+    struct Item {
+        std::string text;
+        std::string source_lang;
+        std::promise<std::string> promise;
+        std::string cache_key;  // Empty when the cache is disabled
+        std::vector<std::promise<std::string>> followers;  // Identical texts waiting on this one; guarded by mutex_
+        std::chrono::steady_clock::time_point queued;
+        bool batchable = true;  // Cleared after its batch could not be split back
     };
 
-    bool enabled_;
+    // One HTTP request carrying one or more items
+    struct Request {
+        std::vector<std::unique_ptr<Item>> items;
+        std::chrono::steady_clock::time_point sent;
+        // When it was sent and its async track in the trace, if tracing was on
+        int64_t sent_ns = 0;
+        uint64_t trace_id = 0;
+    };
 
     bool needs_translation(const std::string& source_lang) const;
-    HttpResponse send_post_request(const std::string& json_data) const;
-    std::string make_http_request(const std::string& host, int port, 
-                                const std::string& path, const std::string& data) const;
+    // Moves the next batch off pending_; callers hold mutex_
+    std::unique_ptr<Request> take_batch();
+    void send_request(std::shared_ptr<Request> request);
+    // Runs on the HttpClient worker thread
+    void finish_request(Request& request, translator::HttpResponse&& response);
+    // Caches the translation and fulfils the item and its followers
+    void complete_item(Item& item, const std::string& translation, std::exception_ptr error);
+    void worker_loop();
+    static std::string parse_response(const std::string& response);
+    // Request, cache, HTTP and queue figures, at scrape time
+    void collect_metrics(metrics::Exposition& out) const;
 
     std::string url_;
     std::string token_;
     std::string target_lang_;
-    std::string host_;
-    std::string path_;
-    int port_;
-    mutable CURL* curl_;
+    std::string request_url_;
+    size_t max_concurrent_;
+    size_t batch_size_;
+    std::chrono::milliseconds batch_delay_;
+    size_t batch_max_chars_;
+
+    std::unique_ptr<translator::TranslationCache> cache_;
+    std::unique_ptr<translator::HttpClient> http_;
+
+    // Shared with callers of translate_async() and HttpClient callbacks
+    mutable std::mutex mutex_;
+    mutable std::condition_variable cv_;
+    mutable std::deque<std::unique_ptr<Item>> pending_;
+    mutable std::map<std::string, Item*> in_flight_;  // Cache key -> queued or active item
+    size_t active_;  // Requests handed to http_ and not finished yet
+    bool stopping_;
+
+    std::atomic<uint64_t> requests_sent_;
+    std::atomic<uint64_t> batched_requests_;  // Requests carrying more than one text
+    std::atomic<uint64_t> batched_texts_;
+    std::atomic<uint64_t> batch_split_failures_;
+
+    // Failed requests by cause, and how long requests take
+    metrics::Counter& transport_errors_;
+    metrics::Counter& status_errors_;
+    metrics::Counter& response_errors_;
+    metrics::Histogram& request_seconds_;
+    uint64_t metrics_collector_;
+
+    std::thread worker_;
 };
 
-} // namespace deeplx 
\ No newline at end of file
+} // namespace deeplx
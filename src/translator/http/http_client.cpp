@@ -0,0 +1,244 @@
+#include "translator/http/http_client.h"
+#include "trace/trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace translator {
+
+namespace {
+
+size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
+    userp->append(static_cast<char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+// Upper bound on how long the worker sleeps in curl_multi_poll without being woken
+constexpr int kPollTimeoutMs = 100;
+
+// Longest wait between two attempts, however many retries came before
+constexpr int kMaxBackoffMs = 5000;
+
+} // namespace
+
+HttpClient::HttpClient(const HttpClientConfig& config)
+    : config_(config)
+    , multi_(nullptr)
+    , headers_(nullptr)
+    , stopping_(false)
+    , requests_(0)
+    , retries_(0)
+    , failures_(0)
+    , connections_opened_(0)
+    , connections_reused_(0)
+    , http2_responses_(0) {
+    for (const std::string& header : config_.headers) {
+        headers_ = curl_slist_append(headers_, header.c_str());
+    }
+
+    multi_ = curl_multi_init();
+    if (!multi_) {
+        curl_slist_free_all(headers_);
+        throw std::runtime_error("Failed to initialize CURL");
+    }
+    const long max_connections = std::max(1, config_.max_connections);
+    curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, max_connections);
+    curl_multi_setopt(multi_, CURLMOPT_MAX_TOTAL_CONNECTIONS, max_connections);
+    // Keep idle connections around for the next burst of requests
+    curl_multi_setopt(multi_, CURLMOPT_MAXCONNECTS, max_connections);
+    curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+    worker_ = std::thread(&HttpClient::worker_loop, this);
+}
+
+HttpClient::~HttpClient() {
+    stopping_ = true;
+    curl_multi_wakeup(multi_);
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+
+    for (CURL* easy : idle_handles_) {
+        curl_easy_cleanup(easy);
+    }
+    curl_multi_cleanup(multi_);
+    curl_slist_free_all(headers_);
+}
+
+void HttpClient::post(const std::string& url, std::string body, Callback done) {
+    auto transfer = std::make_unique<Transfer>();
+    transfer->url = url;
+    transfer->body = std::move(body);
+    transfer->done = std::move(done);
+    transfer->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.timeout_ms);
+    requests_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        submitted_.push_back(std::move(transfer));
+    }
+    curl_multi_wakeup(multi_);
+}
+
+HttpClientStats HttpClient::stats() const {
+    HttpClientStats stats;
+    stats.requests = requests_.load(std::memory_order_relaxed);
+    stats.retries = retries_.load(std::memory_order_relaxed);
+    stats.failures = failures_.load(std::memory_order_relaxed);
+    stats.connections_opened = connections_opened_.load(std::memory_order_relaxed);
+    stats.connections_reused = connections_reused_.load(std::memory_order_relaxed);
+    stats.http2_responses = http2_responses_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// Prepares a (possibly reused) easy handle for the next attempt. Worker thread only.
+void HttpClient::start_attempt(std::unique_ptr<Transfer> transfer) {
+    CURL* easy = nullptr;
+    if (!idle_handles_.empty()) {
+        easy = idle_handles_.back();
+        idle_handles_.pop_back();
+    } else {
+        easy = curl_easy_init();
+    }
+    if (!easy) {
+        failures_.fetch_add(1, std::memory_order_relaxed);
+        transfer->response.error = "Failed to initialize CURL";
+        transfer->done(std::move(transfer->response));
+        return;
+    }
+
+    // Each attempt gets what is left of the request's timeout
+    const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        transfer->deadline - std::chrono::steady_clock::now());
+    ++transfer->attempt;
+    transfer->response = HttpResponse();
+
+    curl_easy_setopt(easy, CURLOPT_URL, transfer->url.c_str());
+    curl_easy_setopt(easy, CURLOPT_POST, 1L);
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDS, transfer->body.c_str());
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE, static_cast<long>(transfer->body.size()));
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer->response.body);
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers_);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, std::max<long>(1, static_cast<long>(remaining.count())));
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(config_.connect_timeout_ms));
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    // HTTP/2 over TLS when the server negotiates it; plain http stays on HTTP/1.1
+    curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+    // Wait for a connection that can multiplex rather than opening another one
+    curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_DNS_CACHE_TIMEOUT, static_cast<long>(config_.dns_cache_seconds));
+
+    curl_multi_add_handle(multi_, easy);
+    active_[easy] = std::move(transfer);
+}
+
+bool HttpClient::should_retry(CURLcode result, long status) {
+    switch (result) {
+        case CURLE_OK:
+            return status == 429 || status == 502 || status == 503 || status == 504;
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_PARTIAL_FILE:
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_HTTP2:
+        case CURLE_HTTP2_STREAM:
+            return true;
+        default:
+            // Includes CURLE_OPERATION_TIMEDOUT: the whole timeout is spent
+            return false;
+    }
+}
+
+void HttpClient::finish_attempt(CURL* easy, CURLcode result) {
+    auto it = active_.find(easy);
+    if (it == active_.end()) {
+        return;
+    }
+    std::unique_ptr<Transfer> transfer = std::move(it->second);
+    active_.erase(it);
+    curl_multi_remove_handle(multi_, easy);
+
+    long new_connections = 0;
+    curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &new_connections);
+    connections_opened_.fetch_add(static_cast<uint64_t>(new_connections), std::memory_order_relaxed);
+    if (result == CURLE_OK) {
+        if (new_connections == 0) {
+            connections_reused_.fetch_add(1, std::memory_order_relaxed);
+        }
+        long version = 0;
+        curl_easy_getinfo(easy, CURLINFO_HTTP_VERSION, &version);
+        if (version == CURL_HTTP_VERSION_2_0) {
+            http2_responses_.fetch_add(1, std::memory_order_relaxed);
+        }
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &transfer->response.status);
+    } else {
+        transfer->response.error = curl_easy_strerror(result);
+    }
+    idle_handles_.push_back(easy);
+
+    if (transfer->attempt <= config_.max_retries && should_retry(result, transfer->response.status)) {
+        // Shift in 64 bits: a large configured backoff must not overflow before the clamp
+        const int64_t base_ms = std::max(0, config_.retry_backoff_ms);
+        const int64_t backoff_ms = std::min<int64_t>(kMaxBackoffMs, base_ms << std::min(transfer->attempt - 1, 16));
+        const auto retry_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(backoff_ms);
+        if (retry_at < transfer->deadline) {
+            retries_.fetch_add(1, std::memory_order_relaxed);
+            retrying_.emplace(retry_at, std::move(transfer));
+            return;
+        }
+    }
+
+    if (result != CURLE_OK) {
+        failures_.fetch_add(1, std::memory_order_relaxed);
+    }
+    transfer->done(std::move(transfer->response));
+}
+
+void HttpClient::worker_loop() {
+    trace::SetThreadName("http");
+    while (true) {
+        std::deque<std::unique_ptr<Transfer>> submitted;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_ && submitted_.empty() && active_.empty() && retrying_.empty()) {
+                break;
+            }
+            submitted.swap(submitted_);
+        }
+        for (auto& transfer : submitted) {
+            start_attempt(std::move(transfer));
+        }
+
+        // Retries whose backoff has passed
+        int poll_timeout_ms = kPollTimeoutMs;
+        const auto now = std::chrono::steady_clock::now();
+        while (!retrying_.empty() && retrying_.begin()->first <= now) {
+            std::unique_ptr<Transfer> transfer = std::move(retrying_.begin()->second);
+            retrying_.erase(retrying_.begin());
+            start_attempt(std::move(transfer));
+        }
+        if (!retrying_.empty()) {
+            const auto wait = std::chrono::ceil<std::chrono::milliseconds>(retrying_.begin()->first - now);
+            poll_timeout_ms = std::min(poll_timeout_ms, static_cast<int>(wait.count()));
+        }
+
+        int running = 0;
+        curl_multi_perform(multi_, &running);
+
+        CURLMsg* msg = nullptr;
+        int msgs_left = 0;
+        while ((msg = curl_multi_info_read(multi_, &msgs_left))) {
+            if (msg->msg == CURLMSG_DONE) {
+                finish_attempt(msg->easy_handle, msg->data.result);
+            }
+        }
+
+        curl_multi_poll(multi_, nullptr, 0, poll_timeout_ms, nullptr);
+    }
+}
+
+} // namespace translator
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <curl/curl.h>
+
+namespace translator {
+
+struct HttpClientConfig {
+    std::vector<std::string> headers;  // Sent with every request, e.g. "Content-Type: application/json"
+    int max_connections = 4;           // Per host; further requests wait or share an HTTP/2 connection
+    int connect_timeout_ms = 1000;     // Per attempt
+    int timeout_ms = 3000;             // Per request, including retries
+    int max_retries = 2;               // Further attempts after a connection error or a 429/5xx answer
+    int retry_backoff_ms = 200;        // Before the first retry, doubling with each further one
+    int dns_cache_seconds = 300;
+};
+
+struct HttpResponse {
+    long status = 0;    // HTTP status of the last attempt; 0 if none got an answer
+    std::string body;
+    std::string error;  // Transfer error of the last attempt; empty if it got an answer
+};
+
+struct HttpClientStats {
+    uint64_t requests = 0;
+    uint64_t retries = 0;
+    uint64_t failures = 0;            // Requests that ended without an answer
+    uint64_t connections_opened = 0;
+    uint64_t connections_reused = 0;  // Attempts answered over an existing connection
+    uint64_t http2_responses = 0;
+};
+
+// Asynchronous HTTP client shared by the translators: one curl multi handle
+// driven by a worker thread. Connections are kept alive and reused across
+// requests, multiplexed over HTTP/2 where the server offers it over TLS, and
+// resolved host names are cached. Failed attempts are retried with
+// exponential backoff as long as the request's total timeout allows.
+class HttpClient {
+public:
+    using Callback = std::function<void(HttpResponse&&)>;
+
+    explicit HttpClient(const HttpClientConfig& config);
+    // Waits for requests in flight, including their retries
+    ~HttpClient();
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    // Sends body to url. done runs on the worker thread, exactly once, and
+    // should return quickly.
+    void post(const std::string& url, std::string body, Callback done);
+
+    HttpClientStats stats() const;
+
+private:
+    struct Transfer {
+        std::string url;
+        std::string body;
+        Callback done;
+        HttpResponse response;
+        int attempt = 0;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    void start_attempt(std::unique_ptr<Transfer> transfer);
+    void finish_attempt(CURL* easy, CURLcode result);
+    // Whether a failed attempt is worth repeating
+    static bool should_retry(CURLcode result, long status);
+    void worker_loop();
+
+    const HttpClientConfig config_;
+    CURLM* multi_;
+    struct curl_slist* headers_;
+
+    // Shared with callers of post()
+    std::mutex mutex_;
+    std::deque<std::unique_ptr<Transfer>> submitted_;
+    std::atomic<bool> stopping_;
+
+    // Owned by the worker thread
+    std::map<CURL*, std::unique_ptr<Transfer>> active_;
+    std::multimap<std::chrono::steady_clock::time_point, std::unique_ptr<Transfer>> retrying_;
+    std::vector<CURL*> idle_handles_;
+    std::thread worker_;
+
+    std::atomic<uint64_t> requests_;
+    std::atomic<uint64_t> retries_;
+    std::atomic<uint64_t> failures_;
+    std::atomic<uint64_t> connections_opened_;
+    std::atomic<uint64_t> connections_reused_;
+    std::atomic<uint64_t> http2_responses_;
+};
+
+} // namespace translator
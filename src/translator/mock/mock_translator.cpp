@@ -0,0 +1,117 @@
+#include "translator/mock/mock_translator.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace translator {
+
+MockTranslator::MockTranslator(const common::MockTranslatorConfig& config)
+    : target_lang_(config.target_lang)
+    , latency_(std::max(0, config.latency_ms))
+    , latency_jitter_ms_(std::max(0, config.latency_jitter_ms))
+    , error_rate_(std::min(1.0, std::max(0.0, static_cast<double>(config.error_rate))))
+    , random_(std::random_device{}())
+    , stopping_(false)
+    , translations_(0)
+    , failures_(0) {
+    std::transform(target_lang_.begin(), target_lang_.end(), target_lang_.begin(), ::toupper);
+    worker_ = std::thread(&MockTranslator::worker_loop, this);
+}
+
+MockTranslator::~MockTranslator() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+std::string MockTranslator::FakeTranslation(const std::string& text, const std::string& target_lang) {
+    const std::string prefix = "[" + target_lang + "] ";
+    std::string translation = prefix;
+    for (char c : text) {
+        translation += c;
+        if (c == '\n') {
+            translation += prefix;
+        }
+    }
+    return translation;
+}
+
+std::string MockTranslator::get_target_language() const {
+    return target_lang_;
+}
+
+std::string MockTranslator::stats_summary() const {
+    std::ostringstream summary;
+    summary << "Mock translator: " << translations_.load() << " translations, " << failures_.load() << " failed";
+    return summary.str();
+}
+
+std::future<std::string> MockTranslator::translate_async(const std::string& text, const std::string& source_lang) const {
+    std::string source_upper = source_lang;
+    std::transform(source_upper.begin(), source_upper.end(), source_upper.begin(), ::toupper);
+
+    Pending pending;
+    std::future<std::string> future = pending.promise.get_future();
+    if (source_upper == target_lang_) {
+        pending.promise.set_value(text);
+        return future;
+    }
+    pending.translation = FakeTranslation(text, target_lang_);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto due = std::chrono::steady_clock::now() + latency_;
+        if (latency_jitter_ms_ > 0) {
+            due += std::chrono::milliseconds(std::uniform_int_distribution<int>(0, latency_jitter_ms_)(random_));
+        }
+        pending.fail = std::bernoulli_distribution(error_rate_)(random_);
+        pending_.emplace(due, std::move(pending));
+    }
+    cv_.notify_one();
+    return future;
+}
+
+std::string MockTranslator::translate(const std::string& text, const std::string& source_lang) const {
+    return translate_async(text, source_lang).get();
+}
+
+void MockTranslator::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (pending_.empty()) {
+            if (stopping_) {
+                break;
+            }
+            cv_.wait(lock);
+            continue;
+        }
+
+        // Complete everything that is due; translations still waiting at
+        // shutdown complete on time as well
+        const auto due = pending_.begin()->first;
+        if (std::chrono::steady_clock::now() < due) {
+            cv_.wait_until(lock, due);
+            continue;
+        }
+        Pending pending = std::move(pending_.begin()->second);
+        pending_.erase(pending_.begin());
+        lock.unlock();
+
+        translations_.fetch_add(1, std::memory_order_relaxed);
+        if (pending.fail) {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            pending.promise.set_exception(
+                std::make_exception_ptr(std::runtime_error("Translation failed: mock translator error")));
+        } else {
+            pending.promise.set_value(std::move(pending.translation));
+        }
+        lock.lock();
+    }
+}
+
+} // namespace translator
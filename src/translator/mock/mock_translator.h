@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include "common/model_config.h"
+#include "translator/translator.h"
+
+namespace translator {
+
+// In-process stand-in for a translation service, for load tests without a
+// network. Every translation completes after latency_ms plus up to
+// latency_jitter_ms, or fails with probability error_rate. Waiting
+// translations are timed by one worker thread, so any number can be in
+// flight at once.
+class MockTranslator : public ITranslator {
+public:
+    explicit MockTranslator(const common::MockTranslatorConfig& config);
+    ~MockTranslator() override;
+
+    std::string translate(const std::string& text, const std::string& source_lang) const override;
+    std::future<std::string> translate_async(const std::string& text, const std::string& source_lang) const override;
+
+    std::string get_target_language() const override;
+    std::string stats_summary() const override;
+
+    // The text with "[TARGET] " in front of every line, so batched texts
+    // keep their lines; shared with the mock DeepLX server
+    static std::string FakeTranslation(const std::string& text, const std::string& target_lang);
+
+private:
+    struct Pending {
+        std::promise<std::string> promise;
+        std::string translation;
+        bool fail;
+    };
+
+    void worker_loop();
+
+    std::string target_lang_;
+    std::chrono::milliseconds latency_;
+    int latency_jitter_ms_;
+    double error_rate_;
+
+    mutable std::mutex mutex_;
+    mutable std::condition_variable cv_;
+    mutable std::multimap<std::chrono::steady_clock::time_point, Pending> pending_;  // By completion time
+    mutable std::mt19937 random_;
+    bool stopping_;
+    std::thread worker_;
+
+    mutable std::atomic<uint64_t> translations_;
+    mutable std::atomic<uint64_t> failures_;
+};
+
+} // namespace translator
@@ -1,16 +1,32 @@
 #include "translator/translator.h"
 #include "translator/deepl/deeplx_translator.h"
+#include "translator/mock/mock_translator.h"
 
 namespace translator {
 
+std::future<std::string> ITranslator::translate_async(const std::string& text, const std::string& source_lang) const {
+    return std::async(std::launch::async, [this, text, source_lang]() {
+        return translate(text, source_lang);
+    });
+}
+
 std::unique_ptr<ITranslator> CreateTranslator(TranslatorType type, const common::ModelConfig& config) {
     switch (type) {
         case TranslatorType::DeepLX:
             return std::make_unique<deeplx::DeepLXTranslator>(config);
+        case TranslatorType::Mock:
+            return std::make_unique<MockTranslator>(config.mock_translator);
         case TranslatorType::None:
         default:
             return nullptr;
     }
 }
 
+TranslatorType ConfiguredTranslatorType(const common::ModelConfig& config) {
+    if (config.mock_translator.enabled) {
+        return TranslatorType::Mock;
+    }
+    return config.deeplx.enabled ? TranslatorType::DeepLX : TranslatorType::None;
+}
+
 } // namespace translator 
\ No newline at end of file
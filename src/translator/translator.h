@@ -1,5 +1,6 @@
 #pragma once
 
+#include <future>
 #include <memory>
 #include <string>
 #include "common/model_config.h"
@@ -14,6 +15,7 @@ enum class TranslatorType {
     DeepLX,
     Google,
     Microsoft,
+    Mock,  // In-process stand-in, see MockTranslator
     None
 };
 
@@ -21,13 +23,23 @@ class ITranslator {
 public:
     virtual ~ITranslator() = default;
     virtual std::string translate(const std::string& text, const std::string& source_lang) const = 0;
+    // Starts a translation without blocking the caller. Futures complete in any
+    // order; callers that need ordered output keep them in submission order.
+    // The default implementation runs translate() on a separate thread.
+    virtual std::future<std::string> translate_async(const std::string& text, const std::string& source_lang) const;
     // get target language
     virtual std::string get_target_language() const = 0;
+    // Counters for --debug output, e.g. cache hits; empty if the translator keeps none
+    virtual std::string stats_summary() const { return std::string(); }
 };
 
-// Factory function to create translator
+// Factory function to create translator; returns nullptr for TranslatorType::None
 std::unique_ptr<ITranslator> CreateTranslator(TranslatorType type, const common::ModelConfig& config);
 
+// The translator the configuration asks for: the mock translator when it is
+// enabled, else DeepLX when deeplx.enabled is set, else None (no translation)
+TranslatorType ConfiguredTranslatorType(const common::ModelConfig& config);
+
 } // namespace translator
 
 
@@ -0,0 +1,364 @@
+// Benchmark of the recognition pipeline over test/test_data/*.wav.
+// Feeds every file as its own source through the same VAD -> batched ASR
+// path the live capture uses, without an audio server, and prints the
+// results as JSON. With a baseline file, exits non-zero on regressions.
+//
+// The capture stage needs no models: the files, played as
+// 48 kHz stereo float like a typical sink, go through the capture converter
+// into the per-source rings, which are drained in place of the VAD. With
+// --capture-only the model stage is skipped, so the capture metrics can be
+// checked on hosts without the models.
+//
+// Usage (from the repository root):
+//   bench_pipeline [-m config/config.yaml] [-d test/test_data]
+//                  [-b test/bench_baseline.json] [-t 0.2] [--capture-only]
+//                  [--update-baseline]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <nlohmann/json.hpp>
+#include <common/allocation_counter.h>
+#include <common/model_config.h>
+#include <audio/dsp/capture_converter.h>
+#include <audio/dsp/sample_kernels.h>
+#include <pipeline/batch_transcriber.h>
+#include <pipeline/recognition_pipeline.h>
+#include <recognizer/model_registry.h>
+
+using json = nlohmann::json;
+
+// Counts every heap allocation in the process, including those made inside
+// the pipeline and the models
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    ++common::thread_allocation_count();  // Feeds PipelineStats::capture_allocations
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+// Lower is better for every compared metric. A baseline may give a metric
+// its own tolerance under "tolerance"; the others use -t.
+const char* const kComparedMetrics[] = {
+    "capture.allocations",  // Baseline 0: any allocation in the capture front end fails
+    "capture.samples_dropped",
+    "capture.rtf",
+    "rtf",
+    "allocations_per_second",
+    "capture_allocations",  // Baseline 0: any allocation on the capture path fails
+    "peak_rss_kb",
+    "latency_ms.decode.p95",
+    "latency_ms.end_to_end.p95",
+};
+
+struct WaveData {
+    std::string path;
+    std::vector<int16_t> pcm;
+};
+
+long peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;  // Kilobytes on Linux
+}
+
+json latency_json(const common::LatencySummary& s) {
+    return {{"count", s.count}, {"mean", s.mean_ms}, {"p50", s.p50_ms},
+            {"p95", s.p95_ms}, {"p99", s.p99_ms}, {"max", s.max_ms}};
+}
+
+const json* find_metric(const json& root, const std::string& dotted) {
+    const json* node = &root;
+    std::stringstream ss(dotted);
+    std::string key;
+    while (std::getline(ss, key, '.')) {
+        if (!node->is_object() || !node->contains(key)) {
+            return nullptr;
+        }
+        node = &(*node)[key];
+    }
+    return node->is_number() ? node : nullptr;
+}
+
+std::vector<WaveData> load_waves(const std::string& dir) {
+    std::vector<WaveData> waves;
+    for (const auto& path : pipeline::BatchTranscriber::CollectInputs({dir})) {
+        const SherpaOnnxWave* wave = SherpaOnnxReadWave(path.c_str());
+        if (!wave) {
+            throw std::runtime_error("Failed to read " + path);
+        }
+        if (wave->sample_rate != pipeline::RecognitionPipeline::SAMPLE_RATE) {
+            SherpaOnnxFreeWave(wave);
+            throw std::runtime_error(path + " is not 16 kHz");
+        }
+        WaveData data;
+        data.path = path;
+        data.pcm.resize(wave->num_samples);
+        for (int32_t i = 0; i < wave->num_samples; ++i) {
+            float v = std::max(-1.0f, std::min(1.0f, wave->samples[i]));
+            data.pcm[i] = static_cast<int16_t>(v * 32767.0f);
+        }
+        SherpaOnnxFreeWave(wave);
+        waves.push_back(std::move(data));
+    }
+    return waves;
+}
+
+// Capture front end without models: convert 25 ms sink fragments and push
+// them like the PulseAudio callback, draining the rings on the same thread
+json run_capture_benchmark(const common::ModelConfig& config, const std::vector<WaveData>& waves) {
+    constexpr int kSinkRate = 48000;
+    constexpr int kSinkChannels = 2;
+    constexpr int kUpsample = kSinkRate / pipeline::RecognitionPipeline::SAMPLE_RATE;
+    constexpr int kRuns = 10;  // Best of, each pass is only milliseconds
+
+    std::vector<std::vector<float>> sink(waves.size());
+    double audio_seconds = 0.0;
+    for (size_t i = 0; i < waves.size(); ++i) {
+        sink[i].reserve(waves[i].pcm.size() * kUpsample * kSinkChannels);
+        for (int16_t s : waves[i].pcm) {
+            sink[i].insert(sink[i].end(), kUpsample * kSinkChannels, s * dsp::kS16ToFloat);
+        }
+        audio_seconds += waves[i].pcm.size() / static_cast<double>(pipeline::RecognitionPipeline::SAMPLE_RATE);
+    }
+
+    // Not started: the rings are drained here instead of by the VAD workers
+    pipeline::RecognitionPipeline pipeline(config.pipeline);
+    std::vector<std::shared_ptr<pipeline::StreamContext>> streams;
+    std::vector<std::unique_ptr<dsp::CaptureConverter>> converters;
+    for (size_t i = 0; i < waves.size(); ++i) {
+        streams.push_back(pipeline.add_stream(static_cast<uint32_t>(i), nullptr));
+        converters.push_back(std::make_unique<dsp::CaptureConverter>(
+            dsp::CaptureConverter::Format::Float32, kSinkRate, kSinkChannels));
+    }
+    std::vector<int16_t> drained(pipeline::RecognitionPipeline::SAMPLE_RATE);
+
+    const size_t fragment = kSinkRate / 40;
+    uint64_t output_samples = 0;
+    double best_seconds = 0.0;
+    for (int run = 0; run < kRuns; ++run) {
+        output_samples = 0;
+        const auto started = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < waves.size(); ++i) {
+            dsp::CaptureConverter& converter = *converters[i];
+            pipeline::StreamContext& stream = *streams[i];
+            const size_t frames = sink[i].size() / kSinkChannels;
+            for (size_t frame = 0; frame < frames; frame += fragment) {
+                common::AllocationScope allocations(pipeline.capture_allocations());
+                converter.convert(sink[i].data() + frame * kSinkChannels, std::min(fragment, frames - frame),
+                                  [&](const int16_t* pcm, size_t n) {
+                                      pipeline.push_audio(stream, pcm, n);
+                                      output_samples += n;
+                                  });
+                while (stream.ring.read(drained.data(), drained.size()) > 0) {
+                }
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        if (run == 0 || seconds < best_seconds) {
+            best_seconds = seconds;
+        }
+    }
+
+    pipeline::PipelineStats stats = pipeline.stats();
+    json report;
+    report["audio_seconds"] = audio_seconds;
+    report["output_samples"] = output_samples;
+    report["samples_dropped"] = stats.vad.dropped;
+    report["allocations"] = stats.capture_allocations;
+    report["rtf"] = audio_seconds > 0.0 ? best_seconds / audio_seconds : 0.0;
+    return report;
+}
+
+json run_benchmark(const common::ModelConfig& config, const std::vector<WaveData>& waves) {
+    auto& registry = recognizer::ModelRegistry::Instance();
+    recognizer::RecognizerHandle recognizer = registry.GetRecognizer(config);
+
+    pipeline::RecognitionPipeline pipeline(config.pipeline);
+    pipeline.set_window_size(config.vad.window_size);
+    pipeline.set_recognizer(recognizer.get());
+
+    std::vector<std::shared_ptr<pipeline::StreamContext>> streams;
+    double audio_seconds = 0.0;
+    for (size_t i = 0; i < waves.size(); ++i) {
+        streams.push_back(pipeline.add_stream(static_cast<uint32_t>(i), registry.AcquireVad(config)));
+        audio_seconds += waves[i].pcm.size() / static_cast<double>(pipeline::RecognitionPipeline::SAMPLE_RATE);
+    }
+
+    // Results go to stdout; keep it for the JSON report
+    std::ostringstream discarded;
+    std::streambuf* stdout_buf = std::cout.rdbuf(discarded.rdbuf());
+
+    const uint64_t allocations_before = g_allocations.load();
+    const auto started = std::chrono::steady_clock::now();
+    pipeline.start();
+
+    // Push 25 ms chunks round-robin, like PulseAudio fragments, as fast as the
+    // pipeline accepts them. A full ring buffer is retried rather than dropped.
+    const size_t chunk = pipeline::RecognitionPipeline::SAMPLE_RATE / 40;
+    std::vector<size_t> offsets(waves.size(), 0);
+    bool remaining = true;
+    while (remaining) {
+        remaining = false;
+        for (size_t i = 0; i < waves.size(); ++i) {
+            const std::vector<int16_t>& pcm = waves[i].pcm;
+            if (offsets[i] >= pcm.size()) {
+                continue;
+            }
+            const size_t n = std::min(chunk, pcm.size() - offsets[i]);
+            if (streams[i]->ring.capacity() - streams[i]->ring.size() >= n) {
+                pipeline.push_audio(*streams[i], pcm.data() + offsets[i], n);
+                offsets[i] += n;
+            }
+            remaining = true;
+        }
+        std::this_thread::yield();
+    }
+    for (auto& stream : streams) {
+        pipeline.remove_stream(stream);
+    }
+    pipeline.stop();
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    const uint64_t allocations = g_allocations.load() - allocations_before;
+    std::cout.rdbuf(stdout_buf);
+
+    pipeline::PipelineStats stats = pipeline.stats();
+    json report;
+    report["files"] = waves.size();
+    report["audio_seconds"] = audio_seconds;
+    report["elapsed_seconds"] = elapsed;
+    report["rtf"] = audio_seconds > 0.0 ? elapsed / audio_seconds : 0.0;
+    report["segments"] = stats.decode.processed;
+    report["decode_batches"] = stats.decode_batches;
+    report["samples_dropped"] = stats.vad.dropped;
+    report["allocations"] = allocations;
+    report["allocations_per_second"] = elapsed > 0.0 ? allocations / elapsed : 0.0;
+    report["capture_allocations"] = stats.capture_allocations;
+    report["segment_buffer_allocations"] = stats.segment_buffer_allocations;
+    report["peak_rss_kb"] = peak_rss_kb();
+    report["latency_ms"] = {
+        {"vad", latency_json(stats.latency.vad)},
+        {"decode_wait", latency_json(stats.latency.decode_wait)},
+        {"decode", latency_json(stats.latency.decode)},
+        {"translate_wait", latency_json(stats.latency.translate_wait)},
+        {"end_to_end", latency_json(stats.latency.end_to_end)},
+    };
+    return report;
+}
+
+// Returns the number of metrics that regressed by more than the tolerance
+int compare_with_baseline(const json& report, const json& baseline, double tolerance) {
+    int regressions = 0;
+    const json tolerances = baseline.value("tolerance", json::object());
+    for (const char* metric : kComparedMetrics) {
+        const json* current = find_metric(report, metric);
+        const json* expected = find_metric(baseline, metric);
+        if (!current || !expected) {
+            std::cerr << "[bench] " << metric << ": no baseline, skipped" << std::endl;
+            continue;
+        }
+        const double value = current->get<double>();
+        const double limit = expected->get<double>() * (1.0 + tolerances.value(metric, tolerance));
+        const bool regressed = value > limit;
+        std::cerr << "[bench] " << metric << ": " << value << " (baseline " << expected->get<double>()
+                  << ")" << (regressed ? " REGRESSION" : "") << std::endl;
+        regressions += regressed ? 1 : 0;
+    }
+    return regressions;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string config_path = "config/config.yaml";
+    std::string data_dir = "test/test_data";
+    std::string baseline_path = "test/bench_baseline.json";
+    double tolerance = 0.2;
+    bool update_baseline = false;
+    bool capture_only = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-m" || arg == "--model") && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if ((arg == "-d" || arg == "--data") && i + 1 < argc) {
+            data_dir = argv[++i];
+        } else if ((arg == "-b" || arg == "--baseline") && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if ((arg == "-t" || arg == "--tolerance") && i + 1 < argc) {
+            tolerance = std::stod(argv[++i]);
+        } else if (arg == "--capture-only") {
+            capture_only = true;
+        } else if (arg == "--update-baseline") {
+            update_baseline = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    try {
+        common::ModelConfig config = common::ModelConfig::LoadFromFile(config_path);
+        std::vector<WaveData> waves = load_waves(data_dir);
+        if (waves.empty()) {
+            std::cerr << "No WAV files in " << data_dir << std::endl;
+            return 2;
+        }
+
+        json report = capture_only ? json::object() : run_benchmark(config, waves);
+        report["capture"] = run_capture_benchmark(config, waves);
+        std::cout << report.dump(2) << std::endl;
+
+        std::ifstream in(baseline_path);
+        const bool have_baseline = static_cast<bool>(in);
+        json baseline = have_baseline ? json::parse(in) : json::object();
+
+        if (update_baseline) {
+            // Keep the notes and tolerances, and the model metrics when only the capture ran
+            json updated = capture_only ? baseline : report;
+            updated["capture"] = report["capture"];
+            for (const char* kept : {"_comment", "tolerance"}) {
+                if (baseline.contains(kept)) {
+                    updated[kept] = baseline[kept];
+                }
+            }
+            std::ofstream out(baseline_path);
+            out << updated.dump(2) << std::endl;
+            std::cerr << "[bench] Baseline written to " << baseline_path << std::endl;
+            return 0;
+        }
+
+        if (!have_baseline) {
+            std::cerr << "[bench] No baseline at " << baseline_path << ", comparison skipped" << std::endl;
+            return 0;
+        }
+        return compare_with_baseline(report, baseline, tolerance) == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+}
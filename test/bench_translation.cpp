@@ -0,0 +1,164 @@
+// Load test of the configured translator. Submits texts at a fixed rate,
+// waits for them in submission order as the recognition pipeline does, and
+// prints throughput, in-order latency percentiles and the translator's own
+// statistics. A share of the texts repeats earlier ones, to exercise the
+// translation cache.
+//
+// Offline, either enable mock_translator in the configuration, or start
+// mock_deeplx_server and point deeplx.url at it.
+//
+// Usage (from the repository root):
+//   bench_translation [-m config/config.yaml] [-n 1000] [-r 50] [-u 0.7] [-s EN]
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <common/model_config.h>
+#include <translator/translator.h>
+
+namespace {
+
+struct Options {
+    std::string config_path = "config/config.yaml";
+    int count = 1000;            // Texts to translate
+    double rate = 50.0;          // Texts submitted per second
+    double unique_share = 0.7;   // Share of texts not seen before
+    std::string source_lang = "EN";
+};
+
+void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " [-m config] [-n count] [-r rate] [-u unique_share] [-s source_lang]\n"
+              << "  -m  Configuration file (default config/config.yaml)\n"
+              << "  -n  Texts to translate (default 1000)\n"
+              << "  -r  Texts submitted per second (default 50)\n"
+              << "  -u  Share of texts not seen before, the rest repeat earlier ones (default 0.7)\n"
+              << "  -s  Source language (default EN)\n";
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const size_t index = std::min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5));
+    return values[index];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        const std::string value = argv[++i];
+        if (arg == "-m") {
+            options.config_path = value;
+        } else if (arg == "-n") {
+            options.count = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "-r") {
+            options.rate = std::max(0.1, std::atof(value.c_str()));
+        } else if (arg == "-u") {
+            options.unique_share = std::min(1.0, std::max(0.0, std::atof(value.c_str())));
+        } else if (arg == "-s") {
+            options.source_lang = value;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        const common::ModelConfig config = common::ModelConfig::LoadFromFile(options.config_path);
+        auto translator = translator::CreateTranslator(translator::ConfiguredTranslatorType(config), config);
+        if (!translator) {
+            std::cerr << "No translator configured; enable deeplx or mock_translator." << std::endl;
+            return 1;
+        }
+
+        struct Submitted {
+            std::chrono::steady_clock::time_point at;
+            std::future<std::string> future;
+        };
+        std::vector<Submitted> submitted;
+        submitted.reserve(options.count);
+
+        // Collect in submission order while texts are still being submitted
+        std::vector<double> latencies_ms;
+        int failures = 0;
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t ready = 0;
+        std::thread collector([&] {
+            for (int i = 0; i < options.count; ++i) {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return ready > static_cast<size_t>(i); });
+                Submitted& item = submitted[i];
+                lock.unlock();
+                try {
+                    item.future.get();
+                } catch (const std::exception&) {
+                    ++failures;
+                }
+                const std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - item.at;
+                latencies_ms.push_back(latency.count());
+            }
+        });
+
+        std::mt19937 random(42);
+        std::bernoulli_distribution is_unique(options.unique_share);
+        int unique_texts = 0;
+        const auto interval = std::chrono::duration<double>(1.0 / options.rate);
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < options.count; ++i) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval * i));
+            int id = unique_texts;
+            if (unique_texts == 0 || is_unique(random)) {
+                ++unique_texts;
+            } else {
+                id = std::uniform_int_distribution<int>(0, unique_texts - 1)(random);
+            }
+            const std::string text = "This is test sentence number " + std::to_string(id) + " of the benchmark.";
+            Submitted item{std::chrono::steady_clock::now(), translator->translate_async(text, options.source_lang)};
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                submitted.push_back(std::move(item));
+                ready = submitted.size();
+            }
+            cv.notify_one();
+        }
+        collector.join();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "Translated " << options.count << " texts (" << unique_texts << " distinct) in "
+                  << elapsed.count() << " s: " << (options.count / elapsed.count()) << " texts/s, "
+                  << failures << " failed\n"
+                  << "In-order latency ms: p50 " << percentile(latencies_ms, 0.50)
+                  << ", p95 " << percentile(latencies_ms, 0.95)
+                  << ", p99 " << percentile(latencies_ms, 0.99)
+                  << ", max " << percentile(latencies_ms, 1.0) << std::endl;
+        const std::string translator_stats = translator->stats_summary();
+        if (!translator_stats.empty()) {
+            std::cout << translator_stats << std::endl;
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
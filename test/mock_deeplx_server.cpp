@@ -0,0 +1,228 @@
+// Local stand-in for a DeepLX server, for load tests without a network.
+// Answers POST {"text", "source_lang", "target_lang"} with
+// {"code": 200, "data": "[TARGET] text"} after a configurable latency, and
+// fails a configurable share of requests with HTTP 503 (which the HTTP
+// client retries). Connections are kept alive; one thread per connection.
+//
+// Usage:
+//   mock_deeplx_server [-p 1188] [-l latency_ms] [-j jitter_ms] [-e error_rate]
+// then point deeplx.url at http://127.0.0.1:<port>/translate.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include <translator/mock/mock_translator.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct Options {
+    int port = 1188;
+    int latency_ms = 100;
+    int jitter_ms = 0;
+    double error_rate = 0.0;
+};
+
+std::atomic<uint64_t> g_requests{0};
+std::atomic<uint64_t> g_errors{0};
+std::atomic<uint64_t> g_connections{0};
+
+bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+std::string lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+
+// Value of a header in a lowercased header block, or empty
+std::string header_value(const std::string& headers, const std::string& name) {
+    const size_t pos = headers.find("\r\n" + name + ":");
+    if (pos == std::string::npos) {
+        return std::string();
+    }
+    const size_t begin = headers.find_first_not_of(' ', pos + name.size() + 3);
+    const size_t end = headers.find("\r\n", begin);
+    return headers.substr(begin, end - begin);
+}
+
+std::string response(int status, const char* reason, const std::string& body, bool keep_alive) {
+    return "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\n"
+           "Content-Type: application/json\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+           "Connection: " + (keep_alive ? "keep-alive" : "close") + "\r\n\r\n" + body;
+}
+
+void serve_connection(int fd, const Options& options, unsigned seed) {
+    std::mt19937 random(seed);
+    std::string buffer;
+    char chunk[16384];
+    while (true) {
+        // Read the request head, then the body
+        size_t head_end;
+        while ((head_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                ::close(fd);
+                return;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        const std::string headers = lower(buffer.substr(0, head_end + 2));
+        const size_t body_size = std::strtoul(header_value(headers, "content-length").c_str(), nullptr, 10);
+        const bool keep_alive = header_value(headers, "connection") != "close";
+        while (buffer.size() < head_end + 4 + body_size) {
+            const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                ::close(fd);
+                return;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        const std::string body = buffer.substr(head_end + 4, body_size);
+        buffer.erase(0, head_end + 4 + body_size);
+
+        g_requests.fetch_add(1, std::memory_order_relaxed);
+        int latency_ms = options.latency_ms;
+        if (options.jitter_ms > 0) {
+            latency_ms += std::uniform_int_distribution<int>(0, options.jitter_ms)(random);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(latency_ms));
+
+        std::string reply;
+        if (headers.compare(0, 5, "post ") != 0) {
+            reply = response(405, "Method Not Allowed", R"({"code":405,"message":"POST only"})", keep_alive);
+        } else if (std::bernoulli_distribution(options.error_rate)(random)) {
+            g_errors.fetch_add(1, std::memory_order_relaxed);
+            reply = response(503, "Service Unavailable", R"({"code":503,"message":"mock error"})", keep_alive);
+        } else {
+            try {
+                const json request = json::parse(body);
+                std::string target_lang = request.value("target_lang", std::string("ZH"));
+                std::transform(target_lang.begin(), target_lang.end(), target_lang.begin(), ::toupper);
+                const json answer = {
+                    {"code", 200},
+                    {"data", translator::MockTranslator::FakeTranslation(request.at("text").get<std::string>(),
+                                                                         target_lang)}
+                };
+                reply = response(200, "OK", answer.dump(), keep_alive);
+            } catch (const std::exception& e) {
+                reply = response(400, "Bad Request", json{{"code", 400}, {"message", e.what()}}.dump(), keep_alive);
+            }
+        }
+
+        if (!send_all(fd, reply) || !keep_alive) {
+            ::close(fd);
+            return;
+        }
+    }
+}
+
+void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " [-p port] [-l latency_ms] [-j jitter_ms] [-e error_rate]\n"
+              << "  -p  Port to listen on, on 127.0.0.1 (default 1188)\n"
+              << "  -l  Time every request takes (default 100 ms)\n"
+              << "  -j  Random extra time per request, up to this much (default 0 ms)\n"
+              << "  -e  Share of requests answered with HTTP 503 (default 0)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (arg == "-p") {
+            options.port = std::atoi(value);
+        } else if (arg == "-l") {
+            options.latency_ms = std::max(0, std::atoi(value));
+        } else if (arg == "-j") {
+            options.jitter_ms = std::max(0, std::atoi(value));
+        } else if (arg == "-e") {
+            options.error_rate = std::min(1.0, std::max(0.0, std::atof(value)));
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    const int yes = 1;
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(options.port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(listener, 128) != 0) {
+        std::cerr << "Failed to listen on port " << options.port << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    std::cout << "Mock DeepLX listening on http://127.0.0.1:" << options.port << "/translate"
+              << " (latency " << options.latency_ms << "+" << options.jitter_ms << " ms, error rate "
+              << options.error_rate << ")" << std::endl;
+
+    // Report the load every few seconds while there is any
+    std::thread([] {
+        uint64_t reported = 0;
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::seconds(5));
+            const uint64_t requests = g_requests.load();
+            if (requests != reported) {
+                std::cout << "requests " << requests << ", errors " << g_errors.load()
+                          << ", connections " << g_connections.load() << std::endl;
+                reported = requests;
+            }
+        }
+    }).detach();
+
+    std::random_device seeds;
+    while (true) {
+        const int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            std::cerr << "accept failed: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        g_connections.fetch_add(1, std::memory_order_relaxed);
+        std::thread(serve_connection, fd, std::cref(options), seeds()).detach();
+    }
+}
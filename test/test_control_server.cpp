@@ -0,0 +1,146 @@
+// Checks the service mode control API against a fake capture: commands over
+// the Unix socket start and stop sources and report them, bad input gets an
+// error reply, and a subscribed connection receives results.
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <service/control_server.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+class FakeCapture : public audio::IAudioCapture {
+public:
+    bool initialize() override { return true; }
+    bool start_recording_application(unsigned int pid) override {
+        if (pid == 99) {
+            throw std::runtime_error("Sink input 99 not found");
+        }
+        return recording_.insert(pid).second;
+    }
+    void stop_recording_application(unsigned int pid) override { recording_.erase(pid); }
+    void stop_recording() override { recording_.clear(); }
+    void list_applications() override {}
+    std::map<uint32_t, std::string> get_applications() override {
+        return {{12, "Player - \"Song\""}, {13, "Browser"}};
+    }
+    std::vector<uint32_t> recording_applications() const override {
+        return std::vector<uint32_t>(recording_.begin(), recording_.end());
+    }
+    void set_model_recognizer(const SherpaOnnxOfflineRecognizer*) override {}
+    void set_model_vad(SherpaOnnxVoiceActivityDetector*, const int) override {}
+    void set_translate(const translator::ITranslator*) override {}
+
+private:
+    std::set<uint32_t> recording_;
+};
+
+int connect_to(const std::string& path) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    timeval timeout{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+// Reads up to and including the next newline
+std::string read_line(int fd) {
+    std::string line;
+    char c;
+    while (::recv(fd, &c, 1, 0) == 1 && c != '\n') {
+        line += c;
+    }
+    return line;
+}
+
+std::string request(int fd, const std::string& command) {
+    const std::string line = command + "\n";
+    ::send(fd, line.data(), line.size(), MSG_NOSIGNAL);
+    return read_line(fd);
+}
+
+void test_commands(service::ControlServer& server) {
+    check(server.handle_command("list")
+              == "{\"ok\":true,\"sources\":[{\"index\":12,\"name\":\"Player - \\\"Song\\\"\"},"
+                 "{\"index\":13,\"name\":\"Browser\"}]}",
+          "list names escaped");
+    check(server.handle_command("start 12") == "{\"ok\":true}", "start");
+    check(server.handle_command("start 12").find("\"ok\":false") != std::string::npos, "start twice fails");
+    check(server.handle_command("start 99") == "{\"ok\":false,\"error\":\"Sink input 99 not found\"}",
+          "capture exception reported");
+    check(server.handle_command("start x").find("Usage: start") != std::string::npos, "bad index");
+    check(server.handle_command("status").find("\"recording\":[12]") != std::string::npos, "status lists source");
+    check(server.handle_command("stop 12") == "{\"ok\":true}", "stop");
+    check(server.handle_command("status").find("\"recording\":[]") != std::string::npos, "status after stop");
+    check(server.handle_command("trace start").find("\"tracing\":true") != std::string::npos, "trace start");
+    check(server.handle_command("trace stop").find("Usage: trace stop") != std::string::npos, "trace stop needs path");
+    check(server.handle_command("trace stop /nonexistent/dir/trace.json").find("Failed to open trace file")
+              != std::string::npos,
+          "trace write error reported");
+    check(server.handle_command("trace").find("\"tracing\":false") != std::string::npos, "trace status");
+    check(server.handle_command("frobnicate") == "{\"ok\":false,\"error\":\"Unknown command: frobnicate\"}",
+          "unknown command");
+}
+
+void test_socket(const std::string& path, output::OutputWriter& writer) {
+    const int control = connect_to(path);
+    check(control >= 0, "connect");
+    if (control < 0) {
+        return;
+    }
+    check(request(control, "start 13\r") == "{\"ok\":true}", "start over socket, CRLF accepted");
+    check(request(control, "status").find("\"recording\":[13]") != std::string::npos, "status over socket");
+
+    const int results = connect_to(path);
+    check(request(results, "subscribe nonsense").find("Unknown output format") != std::string::npos,
+          "unknown subscribe format");
+    check(request(results, "subscribe") == "{\"ok\":true}", "subscribe");
+    while (writer.subscribers() == 0) {
+        usleep(1000);
+    }
+
+    output::OutputRecord record;
+    record.source_id = 13;
+    record.text = "hello";
+    writer.submit(record);
+    check(read_line(results).find("\"source\":13,\"sequence\":0,\"start\":0.000,\"end\":0.000,\"text\":\"hello\"")
+              != std::string::npos,
+          "subscriber receives results as JSONL");
+
+    ::close(results);
+    ::close(control);
+}
+
+} // namespace
+
+int main() {
+    const std::string path = "/tmp/test_control_server_" + std::to_string(::getpid()) + ".sock";
+    common::OutputConfig config;
+    config.destination = "/dev/null";
+    auto writer = std::make_shared<output::OutputWriter>(config);
+    writer->start();
+
+    FakeCapture capture;
+    service::ControlServer server(path, capture, writer);
+    server.start();
+    test_commands(server);
+    test_socket(path, *writer);
+    server.stop();
+    writer->stop();
+    check(::access(path.c_str(), F_OK) != 0, "socket removed on stop");
+
+    return test_util::report("Control server");
+}
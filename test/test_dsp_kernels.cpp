@@ -0,0 +1,146 @@
+// Checks that every sample kernel implementation the CPU supports produces
+// output bit-identical to the scalar reference, including tails shorter than
+// a vector and the extreme S16 values.
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <audio/dsp/sample_kernels.h>
+#include "test_util.h"
+
+namespace {
+
+void check(bool ok, const char* kernel, dsp::Isa isa, size_t n) {
+    test_util::check(ok, std::string(kernel) + " [" + dsp::isa_name(isa) + "] n=" + std::to_string(n));
+}
+
+std::vector<int16_t> make_samples(size_t n, std::mt19937& rng) {
+    std::uniform_int_distribution<int> dist(-32768, 32767);
+    std::vector<int16_t> samples(n);
+    for (size_t i = 0; i < n; ++i) {
+        samples[i] = static_cast<int16_t>(dist(rng));
+    }
+    // Extremes and odd sums, which exercise truncation toward zero
+    const int16_t edges[] = {-32768, -32768, 32767, 32767, -32768, 32767, -1, 0, -3, 0, 1, -2};
+    for (size_t i = 0; i < n && i < sizeof(edges) / sizeof(edges[0]); ++i) {
+        samples[i] = edges[i];
+    }
+    return samples;
+}
+
+template <typename T>
+bool same_bits(const std::vector<T>& a, const std::vector<T>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+void test_implementation(const dsp::SampleKernels& k, const dsp::SampleKernels& ref, std::mt19937& rng) {
+    const float scales[] = {dsp::kS16ToFloat, 1.0f, 0.3f};
+
+    for (size_t frames = 0; frames < 130; ++frames) {
+        const auto stereo = make_samples(2 * frames + 1, rng);  // Odd size: input need not end on a vector
+
+        std::vector<int16_t> mono(frames), mono_ref(frames);
+        k.downmix_s16(stereo.data(), mono.data(), frames);
+        ref.downmix_s16(stereo.data(), mono_ref.data(), frames);
+        check(same_bits(mono, mono_ref), "downmix_s16", k.isa, frames);
+
+        for (float scale : scales) {
+            std::vector<float> f(frames), f_ref(frames);
+            k.downmix_s16_to_float(stereo.data(), f.data(), frames, scale);
+            ref.downmix_s16_to_float(stereo.data(), f_ref.data(), frames, scale);
+            check(same_bits(f, f_ref), "downmix_s16_to_float", k.isa, frames);
+
+            std::vector<float> g(2 * frames), g_ref(2 * frames);
+            k.s16_to_float(stereo.data(), g.data(), 2 * frames, scale);
+            ref.s16_to_float(stereo.data(), g_ref.data(), 2 * frames, scale);
+            check(same_bits(g, g_ref), "s16_to_float", k.isa, 2 * frames);
+
+            k.scale(g.data(), g.size(), 1.7f);
+            ref.scale(g_ref.data(), g_ref.size(), 1.7f);
+            check(same_bits(g, g_ref), "scale", k.isa, g.size());
+
+            // Gain 1.7 pushes some samples past full scale, so clamping is covered
+            std::vector<int16_t> s(g.size()), s_ref(g.size());
+            k.float_to_s16(g.data(), s.data(), g.size(), dsp::kFloatToS16 * scale);
+            ref.float_to_s16(g_ref.data(), s_ref.data(), g.size(), dsp::kFloatToS16 * scale);
+            check(same_bits(s, s_ref), "float_to_s16", k.isa, g.size());
+        }
+
+        // Stereo (vectorized), mono and 6-channel layouts, mixing all or picking one
+        std::vector<float> interleaved(6 * frames + 1);
+        ref.s16_to_float(make_samples(interleaved.size(), rng).data(), interleaved.data(), interleaved.size(),
+                         dsp::kS16ToFloat);
+        for (size_t channels : {size_t(1), size_t(2), size_t(6)}) {
+            std::vector<float> m(frames), m_ref(frames);
+            k.mix_to_mono_f32(interleaved.data(), channels, channels, m.data(), frames, 1.0f / channels);
+            ref.mix_to_mono_f32(interleaved.data(), channels, channels, m_ref.data(), frames, 1.0f / channels);
+            check(same_bits(m, m_ref), "mix_to_mono_f32", k.isa, frames * channels);
+
+            k.mix_to_mono_f32(interleaved.data() + channels - 1, channels, 1, m.data(), frames, 1.0f);
+            ref.mix_to_mono_f32(interleaved.data() + channels - 1, channels, 1, m_ref.data(), frames, 1.0f);
+            check(same_bits(m, m_ref), "mix_to_mono_f32 pick", k.isa, frames * channels);
+        }
+
+        const size_t dot_n = frames / dsp::kDotBlock * dsp::kDotBlock;
+        std::vector<float> a(dot_n), b(dot_n);
+        k.s16_to_float(stereo.data(), a.data(), dot_n, dsp::kS16ToFloat);
+        ref.s16_to_float(stereo.data() + 1, b.data(), dot_n, dsp::kS16ToFloat);
+        const float d = k.dot(a.data(), b.data(), dot_n);
+        const float d_ref = ref.dot(a.data(), b.data(), dot_n);
+        check(std::memcmp(&d, &d_ref, sizeof(float)) == 0, "dot", k.isa, dot_n);
+    }
+}
+
+// The scalar kernels must match the conversions they replaced in the capture path
+void test_scalar_reference(std::mt19937& rng) {
+    const dsp::SampleKernels& k = *dsp::kernels_for(dsp::Isa::Scalar);
+    const size_t frames = 4096;
+    const auto stereo = make_samples(2 * frames, rng);
+
+    std::vector<int16_t> mono(frames);
+    std::vector<float> f(frames), g(frames);
+    k.downmix_s16(stereo.data(), mono.data(), frames);
+    k.downmix_s16_to_float(stereo.data(), f.data(), frames, dsp::kS16ToFloat);
+    k.s16_to_float(mono.data(), g.data(), frames, dsp::kS16ToFloat);
+
+    bool ok = true;
+    for (size_t i = 0; i < frames; ++i) {
+        const int32_t expected = (static_cast<int32_t>(stereo[2 * i]) + static_cast<int32_t>(stereo[2 * i + 1])) / 2;
+        const float expected_f = static_cast<int16_t>(expected) / 32768.0f;
+        ok &= mono[i] == expected;
+        ok &= std::memcmp(&f[i], &expected_f, sizeof(float)) == 0;
+        ok &= std::memcmp(&g[i], &expected_f, sizeof(float)) == 0;
+    }
+    check(ok, "reference", dsp::Isa::Scalar, frames);
+
+    // Round to nearest even, then clamp to the S16 range
+    const float values[] = {0.5f, 1.5f, -0.5f, -2.5f, 100.49f, 40000.0f, -40000.0f, 32767.5f};
+    const int16_t expected[] = {0, 2, 0, -2, 100, 32767, -32768, 32767};
+    int16_t converted[8];
+    k.float_to_s16(values, converted, 8, 1.0f);
+    check(std::memcmp(converted, expected, sizeof(expected)) == 0, "float_to_s16 rounding", dsp::Isa::Scalar, 8);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(1234);
+    const dsp::SampleKernels& ref = *dsp::kernels_for(dsp::Isa::Scalar);
+
+    test_scalar_reference(rng);
+    for (dsp::Isa isa : {dsp::Isa::Sse2, dsp::Isa::Avx2, dsp::Isa::Avx512}) {
+        const dsp::SampleKernels* k = dsp::kernels_for(isa);
+        if (!k) {
+            std::cout << dsp::isa_name(isa) << ": not available, skipped" << std::endl;
+            continue;
+        }
+        test_implementation(*k, ref, rng);
+        std::cout << dsp::isa_name(isa) << ": checked" << std::endl;
+    }
+    std::cout << "Dispatched: " << dsp::isa_name(dsp::kernels().isa) << std::endl;
+
+    return test_util::report("Sample kernel");
+}
@@ -0,0 +1,61 @@
+// Checks the pieces of early decoding that need no model: the prefix that
+// consecutive partial hypotheses agree on, and the decode time budget.
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <common/time_budget.h>
+#include <pipeline/hypothesis_stabilizer.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+void test_stabilizer() {
+    pipeline::HypothesisStabilizer stabilizer;
+    check(stabilizer.update("hello wor") == 0, "first hypothesis is tentative");
+    // "wor" grew into "world", so only "hello " is settled
+    check(stabilizer.update("hello world and") == 6, "partial word is not stable");
+    check(stabilizer.update("hello world and more") == 15, "agreed words are stable");
+    check(stabilizer.update("hello word") == 6, "revised word is cut at its start");
+
+    stabilizer.reset();
+    check(stabilizer.update("你好世界") == 0, "reset forgets the previous hypothesis");
+    // The two differ in the last byte of the third character
+    const std::string revised = std::string("你好") + "\xe4\xb8\x96" + "\xe7\x95\x8c";
+    check(stabilizer.update(std::string("你好") + "\xe4\xb8\x97") == 6, "cut keeps whole characters");
+    check(stabilizer.update(revised) == 6, "differing character is not stable");
+    check(stabilizer.update(revised + "！") == revised.size(), "characters need no word boundary");
+}
+
+void test_budget() {
+    using Clock = common::TimeBudget::Clock;
+    const Clock::time_point t0 = Clock::now();
+
+    common::TimeBudget budget(0.25, std::chrono::seconds(1));
+    check(budget.available(t0), "fresh budget is available");
+    // 100 ms of work at a 25% share is paid back after 400 ms
+    budget.charge(std::chrono::milliseconds(100), t0);
+    check(budget.available(t0), "saved-up time covers the first charge");
+    budget.charge(std::chrono::milliseconds(400), t0);
+    check(!budget.available(t0 + std::chrono::milliseconds(900)), "over budget until paid back");
+    check(budget.available(t0 + std::chrono::seconds(1)), "available once paid back");
+
+    // A long idle period saves up at most the burst
+    const Clock::time_point t1 = t0 + std::chrono::seconds(60);
+    budget.charge(std::chrono::milliseconds(500), t1);
+    check(!budget.available(t1 + std::chrono::milliseconds(900)), "idle credit is capped");
+    check(budget.available(t1 + std::chrono::seconds(1)), "capped credit is still used");
+
+    common::TimeBudget disabled(0.0, std::chrono::seconds(1));
+    check(!disabled.available(t0), "zero share is never available");
+}
+
+} // namespace
+
+int main() {
+    test_stabilizer();
+    test_budget();
+    return test_util::report("Early decode");
+}
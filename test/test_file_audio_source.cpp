@@ -0,0 +1,224 @@
+// Checks the WAV reader of FileAudioSource on small files written to /tmp:
+// unknown chunks are skipped (also from a FIFO, which cannot seek) including
+// their pad byte, placeholder data sizes read to end of file, a real data
+// size stops at the chunk end, float32 is scaled and clamped, multichannel
+// input is downmixed, and unsupported files are rejected when opened.
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <audio/sources/file_audio_source.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+std::string temp_path() {
+    return "/tmp/test_file_audio_source_" + std::to_string(::getpid()) + ".wav";
+}
+
+void put_u16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+void put_u32(std::string& out, uint32_t value) {
+    put_u16(out, static_cast<uint16_t>(value & 0xFFFF));
+    put_u16(out, static_cast<uint16_t>(value >> 16));
+}
+
+// One chunk, padded to an even size as RIFF requires
+std::string chunk(const char* id, const std::string& body) {
+    std::string out(id, 4);
+    put_u32(out, static_cast<uint32_t>(body.size()));
+    out += body;
+    if (body.size() % 2) {
+        out.push_back('\0');
+    }
+    return out;
+}
+
+std::string fmt_chunk(uint16_t format_tag, uint16_t channels, uint16_t bits, uint32_t rate = 16000) {
+    std::string body;
+    put_u16(body, format_tag);
+    put_u16(body, channels);
+    put_u32(body, rate);
+    put_u32(body, rate * channels * bits / 8);
+    put_u16(body, static_cast<uint16_t>(channels * bits / 8));
+    put_u16(body, bits);
+    return chunk("fmt ", body);
+}
+
+std::string riff(const std::string& chunks) {
+    std::string out = "RIFF";
+    put_u32(out, static_cast<uint32_t>(chunks.size() + 4));
+    return out + "WAVE" + chunks;
+}
+
+std::string pcm16(const std::vector<int16_t>& samples) {
+    std::string out;
+    for (int16_t sample : samples) {
+        put_u16(out, static_cast<uint16_t>(sample));
+    }
+    return out;
+}
+
+std::string float32(const std::vector<float>& samples) {
+    std::string out;
+    for (float sample : samples) {
+        uint32_t bits;
+        std::memcpy(&bits, &sample, sizeof(bits));
+        put_u32(out, bits);
+    }
+    return out;
+}
+
+void write_file(const std::string& path, const std::string& bytes) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    std::fwrite(bytes.data(), 1, bytes.size(), file);
+    std::fclose(file);
+}
+
+// Reads the whole source in small pieces, so reads cross frame boundaries
+std::vector<int16_t> read_all(audio::FileAudioSource& source) {
+    std::vector<int16_t> samples;
+    int16_t buffer[3];
+    size_t n;
+    while ((n = source.read(buffer, 3)) > 0) {
+        samples.insert(samples.end(), buffer, buffer + n);
+    }
+    return samples;
+}
+
+std::vector<int16_t> read_wav(const std::string& bytes) {
+    const std::string path = temp_path();
+    write_file(path, bytes);
+    audio::FileAudioSource source(path, audio::FileAudioSource::Format::Wav);
+    std::vector<int16_t> samples = read_all(source);
+    std::remove(path.c_str());
+    return samples;
+}
+
+bool rejected(const std::string& bytes) {
+    try {
+        read_wav(bytes);
+    } catch (const std::runtime_error&) {
+        std::remove(temp_path().c_str());
+        return true;
+    }
+    return false;
+}
+
+const std::vector<int16_t> kSamples = {0, 1, -1, 32767, -32768, 1234, -4321};
+
+void test_chunk_skipping() {
+    // Odd-sized chunks before and after fmt; a misplaced pad byte would
+    // shift every following sample by one byte
+    const std::string wav = riff(chunk("JUNK", "abc") + fmt_chunk(1, 1, 16)
+                                 + chunk("LIST", "INFOisft\x05\0\0\0hello") + chunk("fact", std::string(4, '\0'))
+                                 + chunk("data", pcm16(kSamples)));
+    check(read_wav(wav) == kSamples, "unknown chunks and pad bytes skipped");
+
+    // Trailing chunks after data are not audio
+    check(read_wav(riff(fmt_chunk(1, 1, 16) + chunk("data", pcm16(kSamples)) + chunk("LIST", "xyz")))
+              == kSamples,
+          "data size stops before trailing chunks");
+}
+
+void test_placeholder_sizes() {
+    for (uint32_t placeholder : {0u, 0xFFFFFFFFu}) {
+        std::string wav = riff(fmt_chunk(1, 1, 16) + "data");
+        put_u32(wav, placeholder);
+        wav += pcm16(kSamples);
+        wav.push_back('\x7F');  // Partial frame at the end is dropped
+        check(read_wav(wav) == kSamples, "placeholder data size " + std::to_string(placeholder) + " reads to end");
+    }
+}
+
+void test_float32() {
+    const std::vector<float> samples = {0.0f, 0.5f, -0.5f, 1.5f, -2.0f, 0.25f};
+    const std::vector<int16_t> expected = {0, 16384, -16384, 32767, -32768, 8192};
+    check(read_wav(riff(fmt_chunk(3, 1, 32) + chunk("data", float32(samples)))) == expected,
+          "float32 scaled and clamped");
+
+    // WAVE_FORMAT_EXTENSIBLE carries the real format in its sub-format GUID
+    std::string body = fmt_chunk(0xFFFE, 1, 32).substr(8);
+    put_u16(body, 22);
+    put_u16(body, 32);
+    put_u32(body, 0x4);
+    put_u16(body, 3);
+    body += std::string(14, '\0');
+    check(read_wav(riff(chunk("fmt ", body) + chunk("data", float32(samples)))) == expected,
+          "extensible float32");
+}
+
+void test_downmix() {
+    const std::vector<int16_t> stereo = {100, 300, -32768, -32768, 32767, 32767, 1000, -1000};
+    check(read_wav(riff(fmt_chunk(1, 2, 16) + chunk("data", pcm16(stereo))))
+              == std::vector<int16_t>({200, -32768, 32767, 0}),
+          "stereo PCM16 averaged");
+
+    const std::vector<int16_t> six(6 * 4, 600);
+    check(read_wav(riff(fmt_chunk(1, 6, 16) + chunk("data", pcm16(six)))) == std::vector<int16_t>(4, 600),
+          "5.1 PCM16 downmixed");
+
+    const std::vector<float> stereo_float = {0.5f, -0.5f, 1.0f, 1.0f};
+    check(read_wav(riff(fmt_chunk(3, 2, 32) + chunk("data", float32(stereo_float))))
+              == std::vector<int16_t>({0, 32767}),
+          "stereo float32 averaged");
+}
+
+void test_rejected() {
+    check(rejected("RIFX\0\0\0\0WAVE"), "not RIFF");
+    check(rejected(riff(fmt_chunk(1, 1, 16))), "no data chunk");
+    check(rejected(riff(chunk("data", pcm16(kSamples)) + fmt_chunk(1, 1, 16))), "data before fmt");
+    check(rejected(riff(fmt_chunk(1, 1, 24) + chunk("data", ""))), "24-bit PCM");
+    check(rejected(riff(fmt_chunk(1, 1, 16, 44100) + chunk("data", ""))), "other sample rate");
+    check(rejected(riff(fmt_chunk(1, 0, 16) + chunk("data", ""))), "zero channels");
+
+    std::string truncated = riff(fmt_chunk(1, 1, 16) + "LIST");
+    put_u32(truncated, 1000);
+    check(rejected(truncated + "short"), "truncated chunk");
+}
+
+void test_fifo() {
+    const std::string path = temp_path() + ".fifo";
+    if (::mkfifo(path.c_str(), 0600) != 0) {
+        check(false, "mkfifo");
+        return;
+    }
+    const std::string wav = riff(chunk("LIST", std::string(10000, 'x')) + fmt_chunk(1, 1, 16)
+                                 + chunk("data", pcm16(kSamples)));
+    std::thread writer([&path, &wav] { write_file(path, wav); });
+
+    std::vector<int16_t> samples;
+    try {
+        audio::FileAudioSource source(path, audio::FileAudioSource::Format::Wav);
+        samples = read_all(source);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+    }
+    writer.join();
+    std::remove(path.c_str());
+    check(samples == kSamples, "chunks skipped on a FIFO");
+}
+
+} // namespace
+
+int main() {
+    test_chunk_skipping();
+    test_placeholder_sizes();
+    test_float32();
+    test_downmix();
+    test_rejected();
+    test_fifo();
+    return test_util::report("File audio source");
+}
@@ -0,0 +1,230 @@
+// Checks the HTTP client's retries against a scripted local server: a 503
+// is retried after the backoff and the following 200 is returned, retries
+// stop after max_retries with the last answer, the request deadline cuts
+// retries short, a server that never answers ends in a timeout that is not
+// retried, and a huge configured backoff is clamped to the deadline.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <translator/http/http_client.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+using Clock = std::chrono::steady_clock;
+
+long elapsed_ms(Clock::time_point since) {
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - since).count());
+}
+
+// Answers each request with the next scripted status (0: read the request and
+// never answer), one request per connection. Once the script runs out it
+// repeats its last entry.
+class ScriptedServer {
+public:
+    explicit ScriptedServer(std::deque<int> script)
+        : script_(std::move(script))
+        , requests_(0)
+        , running_(true) {
+        listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        ::bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        ::listen(listener_, 16);
+        ::getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+        thread_ = std::thread(&ScriptedServer::serve, this);
+    }
+
+    ~ScriptedServer() {
+        running_ = false;
+        thread_.join();
+        for (int fd : held_) {
+            ::close(fd);
+        }
+        ::close(listener_);
+    }
+
+    int port() const { return port_; }
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(port_) + "/translate"; }
+    int requests() const { return requests_; }
+
+private:
+    void serve() {
+        while (running_) {
+            pollfd fd{listener_, POLLIN, 0};
+            if (::poll(&fd, 1, 20) <= 0) {
+                continue;
+            }
+            const int client = ::accept(listener_, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            if (!read_request(client)) {
+                ::close(client);
+                continue;
+            }
+            ++requests_;
+
+            const int status = script_.front();
+            if (script_.size() > 1) {
+                script_.pop_front();
+            }
+            if (status == 0) {
+                held_.push_back(client);  // Keep the connection open without answering
+                continue;
+            }
+            const std::string body = status == 200 ? "translated" : "busy";
+            const std::string reply = "HTTP/1.1 " + std::to_string(status) + " Scripted\r\nContent-Length: "
+                                    + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+            ::send(client, reply.data(), reply.size(), MSG_NOSIGNAL);
+            ::close(client);
+        }
+    }
+
+    static bool read_request(int fd) {
+        timeval timeout{1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        std::string request;
+        char buffer[1024];
+        size_t header_end;
+        while ((header_end = request.find("\r\n\r\n")) == std::string::npos) {
+            const ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                return false;
+            }
+            request.append(buffer, static_cast<size_t>(n));
+        }
+        size_t content_length = 0;
+        const size_t pos = request.find("Content-Length:");
+        if (pos != std::string::npos) {
+            content_length = std::strtoul(request.c_str() + pos + 15, nullptr, 10);
+        }
+        while (request.size() < header_end + 4 + content_length) {
+            const ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                return false;
+            }
+            request.append(buffer, static_cast<size_t>(n));
+        }
+        return true;
+    }
+
+    std::deque<int> script_;  // Server thread only
+    std::vector<int> held_;
+    std::atomic<int> requests_;
+    std::atomic<bool> running_;
+    int listener_;
+    int port_;
+    std::thread thread_;
+};
+
+translator::HttpResponse post(translator::HttpClient& client, const std::string& url) {
+    std::promise<translator::HttpResponse> promise;
+    std::future<translator::HttpResponse> future = promise.get_future();
+    client.post(url, "{}", [&promise](translator::HttpResponse&& response) { promise.set_value(std::move(response)); });
+    return future.get();
+}
+
+translator::HttpClientConfig config(int timeout_ms, int max_retries, int retry_backoff_ms) {
+    translator::HttpClientConfig config;
+    config.timeout_ms = timeout_ms;
+    config.max_retries = max_retries;
+    config.retry_backoff_ms = retry_backoff_ms;
+    return config;
+}
+
+void test_retry_then_success() {
+    ScriptedServer server({503, 200});
+    translator::HttpClient client(config(3000, 2, 100));
+    const auto start = Clock::now();
+    const translator::HttpResponse response = post(client, server.url());
+    check(response.status == 200 && response.body == "translated", "503 retried, 200 returned");
+    check(response.error.empty(), "no transfer error");
+    check(elapsed_ms(start) >= 100, "waited for the backoff");
+    check(server.requests() == 2, "two attempts");
+    const translator::HttpClientStats stats = client.stats();
+    check(stats.requests == 1 && stats.retries == 1 && stats.failures == 0, "one retry counted");
+}
+
+void test_retries_exhausted() {
+    // Backoff doubles: 50 ms, then 100 ms
+    ScriptedServer server({503});
+    translator::HttpClient client(config(3000, 2, 50));
+    const auto start = Clock::now();
+    const translator::HttpResponse response = post(client, server.url());
+    check(response.status == 503 && response.body == "busy", "last answer returned after retries");
+    check(elapsed_ms(start) >= 150, "backoff doubled");
+    check(server.requests() == 3, "max_retries further attempts");
+    check(client.stats().retries == 2, "two retries counted");
+    check(client.stats().failures == 0, "an answer is not a failure");
+}
+
+void test_deadline_stops_retries() {
+    // The backoff would end after the request timeout, so no retry is made
+    ScriptedServer server({503, 200});
+    translator::HttpClient client(config(300, 5, 500));
+    const auto start = Clock::now();
+    const translator::HttpResponse response = post(client, server.url());
+    check(response.status == 503, "answer before the deadline returned");
+    check(elapsed_ms(start) < 300, "did not wait past the deadline");
+    check(server.requests() == 1 && client.stats().retries == 0, "no retry past the deadline");
+}
+
+void test_timeout() {
+    ScriptedServer server({0});
+    translator::HttpClient client(config(300, 2, 10));
+    const auto start = Clock::now();
+    const translator::HttpResponse response = post(client, server.url());
+    const long elapsed = elapsed_ms(start);
+    check(response.status == 0 && !response.error.empty(), "timeout reported as transfer error");
+    check(elapsed >= 250 && elapsed < 2000, "request ends at its timeout");
+    check(server.requests() == 1 && client.stats().retries == 0, "timeout not retried");
+    check(client.stats().failures == 1, "timeout counted as failure");
+}
+
+void test_huge_backoff() {
+    // The backoff is clamped to a few seconds, which here exceeds the deadline
+    int port;
+    {
+        ScriptedServer closed({200});
+        port = closed.port();
+    }
+    translator::HttpClient client(config(500, 20, INT_MAX));
+    const auto start = Clock::now();
+    const translator::HttpResponse response = post(client, "http://127.0.0.1:" + std::to_string(port) + "/");
+    check(!response.error.empty(), "connection refused reported");
+    check(elapsed_ms(start) < 500, "clamped backoff does not outlive the deadline");
+    check(client.stats().retries == 0 && client.stats().failures == 1, "no retry scheduled past the deadline");
+}
+
+} // namespace
+
+int main() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    test_retry_then_success();
+    test_retries_exhausted();
+    test_deadline_stops_retries();
+    test_timeout();
+    test_huge_backoff();
+    curl_global_cleanup();
+    return test_util::report("HTTP client");
+}
@@ -0,0 +1,297 @@
+// Checks the network ingest front end: the frame and WebSocket codecs, and a
+// running server with the pipeline left stopped, so ring buffers fill up and
+// backpressure can be observed. Results are submitted to the output writer by
+// hand and must reach only the connection of their source.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ingest/ingest_protocol.h>
+#include <ingest/ingest_server.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+void test_frames() {
+    ingest::AudioFormat format;
+    std::string error;
+    check(ingest::ParseAudioFormat("f32le 48000 2", format, error)
+              && format.sample_format == dsp::CaptureConverter::Format::Float32
+              && format.rate == 48000 && format.channels == 2,
+          "parse audio format");
+    check(!ingest::ParseAudioFormat("s24le 48000 2", format, error) && error.find("s24le") != std::string::npos,
+          "unknown sample format rejected");
+    check(!ingest::ParseAudioFormat("s16le 48000", format, error), "missing channel count rejected");
+    check(!ingest::ParseAudioFormat("s16le 48000 2 x", format, error), "trailing input rejected");
+
+    std::string data;
+    ingest::AppendFrame('A', "abc", 3, data);
+    check(data == std::string("A\x03\0\0\0abc", 8), "frame layout");
+
+    ingest::Frame frame;
+    check(ingest::ParseFrame(data.data(), 4, frame, error) == ingest::ParseStatus::Incomplete, "short header");
+    check(ingest::ParseFrame(data.data(), 7, frame, error) == ingest::ParseStatus::Incomplete, "short payload");
+    check(ingest::ParseFrame(data.data(), data.size(), frame, error) == ingest::ParseStatus::Complete
+              && frame.type == 'A' && std::string(frame.payload, frame.size) == "abc" && frame.consumed == 8,
+          "complete frame");
+    check(ingest::ParseFrame("X\0\0\0\0", 5, frame, error) == ingest::ParseStatus::Invalid, "unknown frame type");
+    check(ingest::ParseFrame("A\0\0\0\x7f", 5, frame, error) == ingest::ParseStatus::Invalid, "oversized frame");
+}
+
+void test_websocket() {
+    namespace ws = ingest::websocket;
+    // Example from RFC 6455 section 1.3
+    check(ws::AcceptKey("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=", "accept key");
+
+    std::string key;
+    check(ws::ParseHandshake("GET /ingest HTTP/1.1\r\nHost: x\r\nUpgrade: WebSocket\r\nConnection: Upgrade\r\n"
+                             "sec-websocket-key:  abc== \r\n\r\n", key) && key == "abc==",
+          "handshake headers are case-insensitive");
+    check(!ws::ParseHandshake("GET / HTTP/1.1\r\nHost: x\r\n\r\n", key), "plain HTTP is not an upgrade");
+
+    // A masked client text frame "end"
+    std::string data = "\x81\x83";
+    const char mask[4] = {0x11, 0x22, 0x33, 0x44};
+    data.append(mask, 4);
+    for (int i = 0; i < 3; ++i) {
+        data += static_cast<char>("end"[i] ^ mask[i]);
+    }
+    ws::Frame frame;
+    std::string error;
+    check(ws::ParseFrame(&data[0], data.size() - 1, frame, error) == ingest::ParseStatus::Incomplete, "partial frame");
+    check(ws::ParseFrame(&data[0], data.size(), frame, error) == ingest::ParseStatus::Complete && frame.fin
+              && frame.opcode == ws::kText && std::string(frame.payload, frame.size) == "end",
+          "masked frame decoded");
+    std::string unmasked = "\x81\x03" "end";
+    check(ws::ParseFrame(&unmasked[0], unmasked.size(), frame, error) == ingest::ParseStatus::Invalid,
+          "unmasked client frame rejected");
+
+    std::string out;
+    ws::AppendFrame(ws::kBinary, std::string(300, 'x').data(), 300, out);
+    check(out.size() == 304 && out[1] == 126 && static_cast<unsigned char>(out[2]) == 1
+              && static_cast<unsigned char>(out[3]) == 44,
+          "16-bit payload length");
+}
+
+int connect_to(int port) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    ::inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    timeval timeout{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+void send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+std::string read_line(int fd) {
+    std::string line;
+    char c;
+    while (::recv(fd, &c, 1, 0) == 1 && c != '\n') {
+        line += c;
+    }
+    return line;
+}
+
+bool read_exact(int fd, char* out, size_t n) {
+    while (n > 0) {
+        const ssize_t got = ::recv(fd, out, n, 0);
+        if (got <= 0) {
+            return false;
+        }
+        out += got;
+        n -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+// Reads one unfragmented server message of up to 64 KiB
+std::string read_message(int fd) {
+    unsigned char header[4];
+    if (!read_exact(fd, reinterpret_cast<char*>(header), 2)) {
+        return std::string();
+    }
+    size_t length = header[1] & 0x7f;
+    if (length == 126) {
+        read_exact(fd, reinterpret_cast<char*>(header + 2), 2);
+        length = static_cast<size_t>(header[2]) << 8 | header[3];
+    }
+    std::string payload(length, '\0');
+    read_exact(fd, &payload[0], length);
+    return payload;
+}
+
+std::string client_message(uint8_t opcode, const std::string& payload) {
+    std::string frame;
+    frame += static_cast<char>(0x80 | opcode);
+    const char mask[4] = {0x5a, 0x11, 0x7e, 0x03};
+    if (payload.size() < 126) {
+        frame += static_cast<char>(0x80 | payload.size());
+    } else {
+        frame += static_cast<char>(0x80 | 127);
+        for (int i = 7; i >= 0; --i) {
+            frame += static_cast<char>((static_cast<uint64_t>(payload.size()) >> (i * 8)) & 0xff);
+        }
+    }
+    frame.append(mask, 4);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        frame += static_cast<char>(payload[i] ^ mask[i % 4]);
+    }
+    return frame;
+}
+
+bool closed_by_server(int fd) {
+    char c;
+    return ::recv(fd, &c, 1, 0) == 0;
+}
+
+template <typename Predicate>
+bool wait_for(Predicate done) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void test_server() {
+    common::PipelineConfig pipeline_config;
+    pipeline_config.ring_buffer_seconds = 1.0f;
+    pipeline::RecognitionPipeline pipeline(pipeline_config);
+
+    common::OutputConfig output_config;
+    output_config.destination = "/dev/null";
+    auto writer = std::make_shared<output::OutputWriter>(output_config);
+    writer->start();
+
+    common::IngestConfig config;
+    config.tcp_port = 20000 + ::getpid() % 20000;
+    config.websocket_port = config.tcp_port + 1;
+    config.threads = 2;
+    config.max_connections = 3;
+    ingest::IngestServer server(config, pipeline, writer, nullptr);
+    server.start();
+
+    // TCP: three seconds of audio into a ring buffer of about one second
+    const int tcp = connect_to(config.tcp_port);
+    check(tcp >= 0, "tcp connect");
+    check(read_line(tcp) == "{\"type\":\"session\",\"source\":1}", "tcp session announced");
+    std::string data;
+    ingest::AppendFrame('F', "s16le 16000 1", 13, data);
+    const std::vector<int16_t> audio(3 * 16000, 100);
+    ingest::AppendFrame('A', reinterpret_cast<const char*>(audio.data()), audio.size() * 2, data);
+    send_all(tcp, data);
+    check(wait_for([&] {
+              const pipeline::StageStats source = pipeline.stats().sources[1];
+              return source.queue_depth > 0 && source.queue_depth == source.queue_capacity;
+          }),
+          "ring buffer filled");
+    check(wait_for([&] { return server.stats().paused >= 1; }), "connection paused");
+    check(pipeline.stats().sources[1].dropped == 0, "backpressure instead of drops");
+
+    // WebSocket: stereo float at 48 kHz, converted to 16 kHz mono
+    const int ws = connect_to(config.websocket_port);
+    check(ws >= 0, "websocket connect");
+    send_all(ws, "GET /ingest HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                 "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+    std::string response;
+    while (response.find("\r\n\r\n") == std::string::npos) {
+        char c;
+        if (::recv(ws, &c, 1, 0) != 1) {
+            break;
+        }
+        response += c;
+    }
+    check(response.find("101 Switching Protocols") != std::string::npos
+              && response.find("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") != std::string::npos,
+          "websocket handshake");
+    check(read_message(ws) == "{\"type\":\"session\",\"source\":2}", "websocket session announced");
+    send_all(ws, client_message(0x1, "format f32le 48000 2"));
+    const std::vector<float> stereo(2 * 24000, 0.25f);
+    send_all(ws, client_message(0x2, std::string(reinterpret_cast<const char*>(stereo.data()), stereo.size() * 4)));
+    check(wait_for([&] { return pipeline.stats().sources[2].queue_depth > 7800; }), "websocket audio resampled");
+    check(pipeline.stats().sources[2].queue_depth <= 8000, "half a second at 16 kHz");
+
+    // Results go back only to their own connection
+    output::OutputRecord record;
+    record.source_id = 2;
+    record.text = "for ws";
+    writer->submit(record);
+    record.source_id = 1;
+    record.text = "for tcp";
+    writer->submit(record);
+    check(read_line(tcp).find("\"text\":\"for tcp\"") != std::string::npos, "tcp receives its result");
+    check(read_message(ws).find("\"text\":\"for ws\"") != std::string::npos, "websocket receives its result");
+
+    // The end of a session is passed on, then the server closes the connection.
+    // A fresh connection: closing one with unread audio would reset it.
+    const int finished = connect_to(config.tcp_port);
+    check(read_line(finished) == "{\"type\":\"session\",\"source\":3}", "third session");
+    output::OutputRecord end;
+    end.source_id = 3;
+    end.end_of_stream = true;
+    writer->submit(end);
+    check(read_line(finished) == "{\"type\":\"end\",\"source\":3}", "end of session sent");
+    check(closed_by_server(finished), "closed after the end of the session");
+    ::close(finished);
+
+    // Protocol errors are reported before the connection is closed
+    const int bad = connect_to(config.tcp_port);
+    check(read_line(bad) == "{\"type\":\"session\",\"source\":4}", "fourth session");
+    send_all(bad, std::string("X\0\0\0\0", 5));
+    check(read_line(bad) == "{\"type\":\"error\",\"message\":\"Unknown frame type\"}", "error reported");
+    check(closed_by_server(bad), "closed after an error");
+    ::close(bad);
+
+    // At max_connections further clients are turned away
+    const int third = connect_to(config.tcp_port);
+    check(read_line(third).find("\"session\"") != std::string::npos, "room for a third connection");
+    const int rejected = connect_to(config.tcp_port);
+    check(closed_by_server(rejected) && server.stats().rejected == 1, "fourth connection rejected");
+    ::close(rejected);
+    ::close(third);
+
+    send_all(ws, client_message(0x8, ""));
+    check(read_message(ws).empty() && closed_by_server(ws), "websocket close answered");
+    ::close(ws);
+
+    server.stop();
+    writer->stop();
+}
+
+} // namespace
+
+int main() {
+    test_frames();
+    test_websocket();
+    test_server();
+
+    return test_util::report("Ingest server");
+}
@@ -0,0 +1,125 @@
+// Checks the latency histogram's summary: percentiles of known distributions
+// land within one bucket (12.5%) of the exact value, small values are exact,
+// an empty histogram reports zeros, and values up to the top of the uint64
+// range go to the last buckets without spilling into neighbouring counters.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+#include <common/latency_histogram.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+// Within the resolution of a log-linear bucket
+bool near(double actual_ms, double expected_ms) {
+    return std::fabs(actual_ms - expected_ms) <= expected_ms * 0.125;
+}
+
+void test_empty() {
+    common::LatencyHistogram histogram;
+    const common::LatencySummary summary = histogram.summary();
+    check(summary.count == 0, "empty count");
+    check(summary.mean_ms == 0 && summary.max_ms == 0, "empty mean and max");
+    check(summary.p50_ms == 0 && summary.p95_ms == 0 && summary.p99_ms == 0, "empty percentiles");
+}
+
+void test_uniform() {
+    common::LatencyHistogram histogram;
+    for (uint64_t us = 1; us <= 1000; ++us) {
+        histogram.record_us(us);
+    }
+    const common::LatencySummary summary = histogram.summary();
+    check(summary.count == 1000, "uniform count");
+    check(std::fabs(summary.mean_ms - 0.5005) < 1e-9, "mean is exact");
+    check(summary.max_ms == 1.0, "max is exact");
+    check(near(summary.p50_ms, 0.500), "uniform p50");
+    check(near(summary.p95_ms, 0.950), "uniform p95");
+    check(near(summary.p99_ms, 0.990), "uniform p99");
+    check(summary.p50_ms <= summary.p95_ms && summary.p95_ms <= summary.p99_ms, "percentiles ordered");
+}
+
+void test_bimodal() {
+    // 90% fast, 10% slow: the median sees only the fast mode, p95 and p99 only the slow one
+    common::LatencyHistogram histogram;
+    for (int i = 0; i < 900; ++i) {
+        histogram.record(std::chrono::microseconds(100));
+    }
+    for (int i = 0; i < 100; ++i) {
+        histogram.record(std::chrono::milliseconds(10));
+    }
+    const common::LatencySummary summary = histogram.summary();
+    check(near(summary.p50_ms, 0.1), "bimodal p50");
+    check(near(summary.p95_ms, 10), "bimodal p95");
+    check(near(summary.p99_ms, 10), "bimodal p99");
+    check(std::fabs(summary.mean_ms - 1.09) < 1e-9, "bimodal mean");
+}
+
+void test_small_values_exact() {
+    common::LatencyHistogram histogram;
+    for (int i = 0; i < 100; ++i) {
+        histogram.record_us(3);
+    }
+    histogram.record(std::chrono::microseconds(-5));  // Clamped to zero
+    const common::LatencySummary summary = histogram.summary();
+    check(summary.count == 101, "negative duration counted");
+    check(summary.p50_ms == 0.003 && summary.p99_ms == 0.003, "values below 8 us exact");
+    check(summary.max_ms == 0.003, "negative duration does not become max");
+}
+
+void test_large_values() {
+    common::LatencyHistogram histogram;
+    const uint64_t day_us = 86400ull * 1000 * 1000;
+    for (int i = 0; i < 98; ++i) {
+        histogram.record_us(day_us);
+    }
+    histogram.record_us(uint64_t(1) << 62);
+    histogram.record_us(std::numeric_limits<uint64_t>::max());
+    const common::LatencySummary summary = histogram.summary();
+    check(summary.count == 100, "top buckets counted, nothing spilled");
+    check(near(summary.p50_ms, day_us / 1000.0), "one day resolved");
+    check(near(summary.p99_ms, static_cast<double>(uint64_t(1) << 62) / 1000.0), "2^62 us resolved");
+    check(summary.max_ms == static_cast<double>(std::numeric_limits<uint64_t>::max()) / 1000.0, "max of uint64");
+
+    common::LatencyHistogram top;
+    top.record_us(std::numeric_limits<uint64_t>::max());
+    check(near(top.summary().p50_ms, static_cast<double>(std::numeric_limits<uint64_t>::max()) / 1000.0),
+          "largest value in the last bucket");
+}
+
+void test_concurrent_record() {
+    common::LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&histogram, t] {
+            for (uint64_t i = 0; i < 10000; ++i) {
+                histogram.record_us(i + static_cast<uint64_t>(t));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const common::LatencySummary summary = histogram.summary();
+    check(summary.count == 40000, "concurrent records not lost");
+    check(summary.max_ms == 10.002, "concurrent max");
+}
+
+} // namespace
+
+int main() {
+    test_empty();
+    test_uniform();
+    test_bimodal();
+    test_small_values_exact();
+    test_large_values();
+    test_concurrent_record();
+    return test_util::report("Latency histogram");
+}
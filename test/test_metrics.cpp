@@ -0,0 +1,140 @@
+// Checks the metrics registry (one metric per name and labels, type
+// conflicts rejected, collectors added and removed), the Prometheus text
+// format it renders, and the HTTP /metrics endpoint.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <metrics/metrics.h>
+#include <metrics/metrics_server.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+bool contains(const std::string& text, const std::string& needle) {
+    return text.find(needle) != std::string::npos;
+}
+
+template <typename F>
+bool throws(F f) {
+    try {
+        f();
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+void test_registry() {
+    metrics::Registry& registry = metrics::Registry::Instance();
+    metrics::Counter& holes = registry.counter("test_holes_total", "Holes");
+    check(&registry.counter("test_holes_total", "Holes") == &holes, "same name, same counter");
+    check(&registry.counter("test_holes_total", "Holes", {{"source", "1"}}) != &holes, "labels make a new series");
+    check(throws([&] { registry.gauge("test_holes_total", "Holes"); }), "type conflict rejected");
+    check(throws([&] { registry.counter("1bad name", "Bad"); }), "invalid name rejected");
+
+    // Updates from many threads are not lost
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&holes] {
+            for (int i = 0; i < 10000; ++i) {
+                holes.inc();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    check(holes.value() == 40000, "concurrent increments");
+
+    metrics::Gauge& depth = registry.gauge("test_depth", "Depth", {{"stage", "say \"hi\"\n"}});
+    depth.set(2.5);
+    depth.add(-1);
+
+    metrics::Histogram& rtf = registry.histogram("test_rtf", "Real-time factor", {0.1, 0.5, 1});
+    rtf.observe(0.05);
+    rtf.observe(0.5);  // Bounds are inclusive
+    rtf.observe(3);
+
+    const uint64_t collector = registry.add_collector([](metrics::Exposition& out) {
+        out.gauge("test_collected", "From a collector", {{"stage", "vad"}}, 7);
+        out.gauge("test_collected", "From a collector", {{"stage", "decode"}}, 8);
+    });
+    const std::string text = registry.render();
+    check(contains(text, "# HELP test_holes_total Holes\n# TYPE test_holes_total counter\n"
+                         "test_holes_total 40000\ntest_holes_total{source=\"1\"} 0\n"),
+          "counter family with one HELP and TYPE");
+    check(contains(text, "test_depth{stage=\"say \\\"hi\\\"\\n\"} 1.5\n"), "gauge value, label escaped");
+    check(contains(text, "# TYPE test_rtf histogram\n"
+                         "test_rtf_bucket{le=\"0.1\"} 1\n"
+                         "test_rtf_bucket{le=\"0.5\"} 2\n"
+                         "test_rtf_bucket{le=\"1\"} 2\n"
+                         "test_rtf_bucket{le=\"+Inf\"} 3\n"
+                         "test_rtf_sum 3.55\n"
+                         "test_rtf_count 3\n"),
+          "histogram buckets cumulative");
+    check(contains(text, "# TYPE test_collected gauge\n"
+                         "test_collected{stage=\"vad\"} 7\ntest_collected{stage=\"decode\"} 8\n"),
+          "collector samples grouped");
+
+    registry.remove_collector(collector);
+    check(!contains(registry.render(), "test_collected"), "removed collector not run");
+}
+
+std::string http_get(int port, const std::string& request) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return std::string();
+    }
+    ::send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    std::string reply;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        reply.append(buffer, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return reply;
+}
+
+void test_server() {
+    metrics::Registry::Instance().counter("test_scraped_total", "Scraped").inc(3);
+
+    common::MetricsConfig config;  // Port 0: any free port
+    metrics::MetricsServer server(config);
+    server.start();
+    check(server.port() > 0, "bound port reported");
+
+    const std::string ok = http_get(server.port(), "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    check(ok.compare(0, 15, "HTTP/1.0 200 OK") == 0, "metrics answered");
+    check(contains(ok, "Content-Type: text/plain; version=0.0.4"), "exposition content type");
+    check(contains(ok, "\r\n\r\n") && contains(ok, "test_scraped_total 3\n"), "metrics in body");
+
+    check(http_get(server.port(), "GET / HTTP/1.1\r\n\r\n").compare(0, 12, "HTTP/1.0 404") == 0, "other paths 404");
+    check(http_get(server.port(), "POST /metrics HTTP/1.1\r\n\r\n").compare(0, 12, "HTTP/1.0 405") == 0,
+          "other methods 405");
+
+    server.stop();
+    check(http_get(server.port(), "GET /metrics HTTP/1.1\r\n\r\n").empty(), "closed after stop");
+}
+
+} // namespace
+
+int main() {
+    test_registry();
+    test_server();
+    return test_util::report("Metrics");
+}
@@ -0,0 +1,136 @@
+// Checks the text, JSONL and subtitle output formats, and that the output
+// writer delivers every final result in order to a file, drains on stop and
+// drops partial results rather than waiting when its queue is full.
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <output/output_format.h>
+#include <output/output_writer.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+output::OutputRecord final_record(uint64_t sequence, float start, float end, const std::string& text) {
+    output::OutputRecord record;
+    record.source_id = 3;
+    record.sequence = sequence;
+    record.start = start;
+    record.end = end;
+    record.text = text;
+    return record;
+}
+
+void test_text() {
+    auto format = output::OutputFormat::Create("text");
+    output::OutputRecord record = final_record(0, 1.5f, 2.25f, "Hello");
+    record.language = "EN";
+    record.target_lang = "ZH";
+    record.translation = "你好";
+    std::string out;
+    check(format->append(record, out), "text writes final results");
+    check(out == "\n[Recognition Result]\nSource: 3\nTime: 1.500s -- 2.250s\nText: Hello\n"
+                 "Language Code: EN\nTarget Language: ZH\nTranslated Text: 你好\n" + std::string(50, '-') + "\n",
+          "text layout unchanged");
+
+    output::OutputRecord partial = final_record(1, 0.0f, 1.0f, "good morn");
+    partial.partial = true;
+    partial.stable_size = 5;
+    out.clear();
+    check(format->append(partial, out), "text writes partial results");
+    check(out == "[Partial] Source 3 0.000s -- 1.000s: good [morn]\n", "tentative text bracketed");
+}
+
+void test_jsonl() {
+    auto format = output::OutputFormat::Create("jsonl");
+    output::OutputRecord record = final_record(7, 0.0f, 1.0f, "say \"hi\"\\\n\t\x01");
+    record.translation_error = "timeout";
+    std::string out;
+    check(format->append(record, out), "jsonl writes final results");
+    check(out == "{\"type\":\"final\",\"source\":3,\"sequence\":7,\"start\":0.000,\"end\":1.000,"
+                 "\"text\":\"say \\\"hi\\\"\\\\\\n\\t\\u0001\",\"translation_error\":\"timeout\"}\n",
+          "jsonl escapes strings and leaves out empty fields");
+
+    output::OutputRecord end;
+    end.source_id = 4;
+    end.end_of_stream = true;
+    out.clear();
+    check(format->append(end, out) && out == "{\"type\":\"end\",\"source\":4}\n", "jsonl marks the end of a session");
+    out.clear();
+    check(!output::OutputFormat::Create("text")->append(end, out) && out.empty(), "text skips the end of a session");
+}
+
+void test_subtitles() {
+    auto srt = output::OutputFormat::Create("srt");
+    auto vtt = output::OutputFormat::Create("vtt");
+    check(srt->header().empty(), "srt has no header");
+    check(vtt->header() == "WEBVTT\n\n", "vtt header");
+
+    output::OutputRecord record = final_record(0, 3661.5f, 3662.0f, "line one\nline two");
+    record.translation = "翻译";
+    std::string out;
+    check(srt->append(record, out) && srt->append(record, out), "srt writes final results");
+    check(out == "1\n01:01:01,500 --> 01:01:02,000\nline one line two\n翻译\n\n"
+                 "2\n01:01:01,500 --> 01:01:02,000\nline one line two\n翻译\n\n",
+          "srt cues numbered, text kept on one line");
+
+    out.clear();
+    check(vtt->append(record, out), "vtt writes final results");
+    check(out == "1\n01:01:01.500 --> 01:01:02.000\nline one line two\n翻译\n\n", "vtt time separator");
+
+    record.partial = true;
+    out.clear();
+    check(!vtt->append(record, out) && out.empty(), "subtitles skip partial results");
+}
+
+void test_writer() {
+    const std::string path = "test_output_format.jsonl";
+    common::OutputConfig config;
+    config.format = "jsonl";
+    config.destination = path;
+    config.queue_capacity = 4;
+    {
+        output::OutputWriter writer(config);
+        // Not started: nothing drains, so the queue fills up
+        for (int i = 0; i < 4; ++i) {
+            output::OutputRecord record = final_record(i, 0.0f, 1.0f, "text " + std::to_string(i));
+            check(writer.try_submit(record), "submit while queue has room");
+        }
+        output::OutputRecord partial = final_record(4, 0.0f, 1.0f, "partial");
+        partial.partial = true;
+        check(!writer.try_submit(partial), "partial dropped when full");
+        check(writer.dropped() == 1 && writer.queue_depth() == 4, "drop counted");
+
+        writer.start();
+        for (int i = 4; i < 100; ++i) {
+            output::OutputRecord record = final_record(i, 0.0f, 1.0f, "text " + std::to_string(i));
+            writer.submit(record);
+        }
+        writer.stop();
+        check(writer.written() == 100 && writer.queue_depth() == 0, "everything written on stop");
+    }
+
+    std::ifstream file(path);
+    std::string line;
+    int expected = 0;
+    bool in_order = true;
+    while (std::getline(file, line)) {
+        in_order &= line.find("\"text\":\"text " + std::to_string(expected) + "\"") != std::string::npos;
+        ++expected;
+    }
+    check(expected == 100 && in_order, "file holds every result in order");
+    std::remove(path.c_str());
+}
+
+} // namespace
+
+int main() {
+    test_text();
+    test_jsonl();
+    test_subtitles();
+    test_writer();
+    return test_util::report("Output format");
+}
@@ -0,0 +1,194 @@
+// Checks the pipeline's queues: the SPSC ring buffer wraps around, stops at
+// full and empty and keeps order between a producer and a consumer thread;
+// the bounded queue drops on try_push() when full, blocks on push() until
+// there is room, and drains after close().
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <common/bounded_queue.h>
+#include <common/spsc_ring_buffer.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+void test_ring_full_and_empty() {
+    common::SpscRingBuffer<int> ring(5);
+    check(ring.capacity() == 8, "capacity rounded up to a power of two");
+
+    int out[16];
+    check(ring.read(out, 4) == 0, "read from empty ring returns nothing");
+
+    const int in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    check(ring.write(in, 10) == 8, "write stops when full");
+    check(ring.size() == 8, "full ring size");
+    check(ring.write(in, 1) == 0, "write to full ring returns nothing");
+
+    int item = 42;
+    check(!ring.try_push(item) && item == 42, "try_push to full ring leaves item");
+
+    check(ring.read(out, 16) == 8, "read stops when empty");
+    bool in_order = true;
+    for (int i = 0; i < 8; ++i) {
+        in_order &= out[i] == i;
+    }
+    check(in_order, "full ring read in order");
+    check(ring.size() == 0 && !ring.try_pop(item), "empty after draining");
+}
+
+void test_ring_wrap_around() {
+    common::SpscRingBuffer<int> ring(8);
+    int next_in = 0;
+    int next_out = 0;
+    bool in_order = true;
+    // Odd chunk sizes so writes and reads straddle the end of the storage
+    for (int round = 0; round < 100; ++round) {
+        int in[5];
+        for (int& value : in) {
+            value = next_in++;
+        }
+        check(ring.write(in, 5) == 5, "write fits");
+        int out[5];
+        check(ring.read(out, 5) == 5, "read what was written");
+        for (int value : out) {
+            in_order &= value == next_out++;
+        }
+    }
+    check(in_order, "order kept across wrap-around");
+
+    // Single-item ends wrap the same way
+    for (int i = 0; i < 20; ++i) {
+        int item = i;
+        int popped = -1;
+        check(ring.try_push(item) && ring.try_pop(popped) && popped == i, "try_push/try_pop across wrap-around");
+    }
+}
+
+void test_ring_threads() {
+    constexpr int kItems = 200000;
+    common::SpscRingBuffer<int> ring(64);
+    std::thread producer([&ring] {
+        int next = 0;
+        int chunk[7];
+        while (next < kItems) {
+            const int n = std::min(7, kItems - next);
+            for (int i = 0; i < n; ++i) {
+                chunk[i] = next + i;
+            }
+            const size_t written = ring.write(chunk, static_cast<size_t>(n));
+            if (written == 0) {
+                std::this_thread::yield();
+            }
+            next += static_cast<int>(written);
+        }
+    });
+
+    int expected = 0;
+    bool in_order = true;
+    int chunk[11];
+    while (expected < kItems) {
+        const size_t n = ring.read(chunk, 11);
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < n; ++i) {
+            in_order &= chunk[i] == expected++;
+        }
+    }
+    producer.join();
+    check(in_order, "producer and consumer threads keep order");
+    check(ring.size() == 0, "consumer read everything");
+}
+
+void test_queue_try_push_drops() {
+    common::BoundedQueue<int> queue(2);
+    check(queue.try_push(1) && queue.try_push(2), "try_push fills the queue");
+    check(!queue.try_push(3), "try_push drops when full");
+    check(queue.size() == 2 && queue.pushed() == 2 && queue.dropped() == 1, "drop counted");
+
+    int item = 0;
+    check(queue.pop(item) && item == 1, "pop oldest first");
+    check(queue.try_push(4), "room again after pop");
+    check(queue.pop(item) && item == 2 && queue.pop(item) && item == 4, "order kept across wrap-around");
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+    check(!queue.pop_until(item, deadline), "pop_until times out on empty queue");
+}
+
+void test_queue_push_backpressure() {
+    common::BoundedQueue<std::unique_ptr<int>> queue(1);
+    check(queue.push(std::make_unique<int>(1)), "push into empty queue");
+
+    std::atomic<bool> pushed(false);
+    std::thread producer([&queue, &pushed] {
+        queue.push(std::make_unique<int>(2));
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    check(!pushed, "push blocks while full");
+    check(queue.dropped() == 0, "push does not drop");
+
+    std::unique_ptr<int> item;
+    check(queue.pop(item) && *item == 1, "pop first");
+    producer.join();
+    check(pushed, "push resumes once there is room");
+    check(queue.pop(item) && *item == 2, "blocked item delivered");
+
+    // Closing wakes a blocked producer and lets consumers drain
+    check(queue.push(std::make_unique<int>(3)), "refill");
+    std::thread blocked([&queue] { queue.push(std::make_unique<int>(4)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.close();
+    blocked.join();
+    check(queue.dropped() == 1, "push into closed queue dropped");
+    check(queue.pop(item) && *item == 3, "closed queue still drains");
+    check(!queue.pop(item), "closed and drained");
+}
+
+void test_queue_threads() {
+    constexpr int kProducers = 4;
+    constexpr int kItems = 20000;
+    common::BoundedQueue<int> queue(16);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&queue, p] {
+            for (int i = 0; i < kItems; ++i) {
+                queue.push(p * kItems + i);
+            }
+        });
+    }
+
+    // Items of each producer arrive in the order it pushed them
+    std::vector<int> next(kProducers, 0);
+    bool in_order = true;
+    for (int received = 0; received < kProducers * kItems; ++received) {
+        int item = 0;
+        queue.pop(item);
+        const int producer = item / kItems;
+        in_order &= item % kItems == next[producer]++;
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    check(in_order, "per-producer order kept");
+    check(queue.dropped() == 0 && queue.size() == 0, "nothing dropped or left");
+}
+
+} // namespace
+
+int main() {
+    test_ring_full_and_empty();
+    test_ring_wrap_around();
+    test_ring_threads();
+    test_queue_try_push_drops();
+    test_queue_push_backpressure();
+    test_queue_threads();
+    return test_util::report("Queue");
+}
@@ -0,0 +1,183 @@
+// Checks the work-stealing thread pool: every task runs exactly once, tasks
+// submitted from a worker run newest first on that worker, an idle worker
+// steals the oldest tasks of a busy one, and tasks still queued when the pool
+// is destroyed all run.
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <common/thread_pool.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+// Waits for a condition set by another pool task, with a deadline so a
+// broken pool fails the check instead of hanging the test
+template <typename F>
+bool wait_for(F done) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void test_results() {
+    common::ThreadPool pool(4);
+    check(pool.size() == 4, "pool size");
+    check(common::ThreadPool(0).size() == 1, "at least one worker");
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 1000; ++i) {
+        futures.push_back(pool.submit([i] { return i * i; }));
+    }
+    bool all_ok = true;
+    for (int i = 0; i < 1000; ++i) {
+        all_ok &= futures[static_cast<size_t>(i)].get() == i * i;
+    }
+    check(all_ok, "every task runs once with its own result");
+
+    auto failing = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+    bool threw = false;
+    try {
+        failing.get();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    check(threw, "exception reaches the future");
+}
+
+void test_submit_from_worker() {
+    // One worker: children queue behind their parent and run newest first
+    common::ThreadPool pool(1);
+    std::mutex mutex;
+    std::vector<int> order;
+    std::thread::id parent_thread;
+    std::vector<std::thread::id> child_threads;
+
+    pool.submit([&] {
+        parent_thread = std::this_thread::get_id();
+        for (int i = 0; i < 5; ++i) {
+            pool.submit([&, i] {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(i);
+                child_threads.push_back(std::this_thread::get_id());
+            });
+        }
+    }).get();
+
+    check(wait_for([&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return order.size() == 5;
+    }), "children submitted from a worker run");
+    std::lock_guard<std::mutex> lock(mutex);
+    check(order == std::vector<int>({4, 3, 2, 1, 0}), "own deque taken LIFO");
+    bool same_thread = true;
+    for (const auto& id : child_threads) {
+        same_thread &= id == parent_thread;
+    }
+    check(same_thread, "children stay on the submitting worker");
+}
+
+void test_stealing() {
+    // The parent keeps its worker busy until the children are done, so the
+    // other worker has to steal all of them, oldest first
+    common::ThreadPool pool(2);
+    std::mutex mutex;
+    std::vector<int> order;
+    std::atomic<int> stolen(0);
+
+    auto parent = pool.submit([&] {
+        const std::thread::id parent_thread = std::this_thread::get_id();
+        for (int i = 0; i < 20; ++i) {
+            pool.submit([&, i, parent_thread] {
+                if (std::this_thread::get_id() != parent_thread) {
+                    ++stolen;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(i);
+            });
+        }
+        return wait_for([&] {
+            std::lock_guard<std::mutex> lock(mutex);
+            return order.size() == 20;
+        });
+    });
+
+    check(parent.get(), "idle worker ran the busy worker's tasks");
+    check(stolen == 20, "all children stolen");
+    std::vector<int> expected;
+    for (int i = 0; i < 20; ++i) {
+        expected.push_back(i);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    check(order == expected, "steals taken FIFO");
+}
+
+void test_destroy_with_queued_tasks() {
+    std::atomic<int> ran(0);
+    {
+        common::ThreadPool pool(2);
+        for (int i = 0; i < 2; ++i) {
+            pool.submit([] { std::this_thread::sleep_for(std::chrono::milliseconds(20)); });
+        }
+        for (int i = 0; i < 200; ++i) {
+            pool.submit([&ran] { ++ran; });
+        }
+        // Queued tasks submit more work while the pool is shutting down
+        for (int i = 0; i < 10; ++i) {
+            pool.submit([&pool, &ran] {
+                pool.submit([&ran] { ++ran; });
+                ++ran;
+            });
+        }
+    }
+    check(ran == 220, "queued tasks all run before destruction returns");
+}
+
+void test_many_submitters() {
+    // Outside threads and workers submitting at once; pending_ must account for
+    // every task or a worker would sleep with work queued
+    std::atomic<int> ran(0);
+    {
+        common::ThreadPool pool(3);
+        std::vector<std::thread> submitters;
+        for (int t = 0; t < 4; ++t) {
+            submitters.emplace_back([&pool, &ran] {
+                for (int i = 0; i < 500; ++i) {
+                    pool.submit([&pool, &ran] {
+                        pool.submit([&ran] { ++ran; });
+                        ++ran;
+                    });
+                }
+            });
+        }
+        for (auto& submitter : submitters) {
+            submitter.join();
+        }
+        check(wait_for([&ran] { return ran == 4000; }), "all tasks run while the pool is alive");
+    }
+    check(ran == 4000, "no task runs twice");
+}
+
+} // namespace
+
+int main() {
+    test_results();
+    test_submit_from_worker();
+    test_stealing();
+    test_destroy_with_queued_tasks();
+    test_many_submitters();
+    return test_util::report("Thread pool");
+}
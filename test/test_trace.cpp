@@ -0,0 +1,110 @@
+// Checks that tracing records nothing while off, keeps each thread's spans
+// on its own named track, counts events past a full buffer as dropped,
+// starts every trace empty and exports Chrome trace JSON.
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <trace/trace.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+size_t count(const std::string& text, const std::string& needle) {
+    size_t n = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+        ++n;
+    }
+    return n;
+}
+
+std::string export_trace() {
+    std::ostringstream out;
+    trace::WriteChromeTrace(out);
+    return out.str();
+}
+
+void test_disabled() {
+    trace::Start();
+    trace::Stop();
+    {
+        trace::Span span("ignored", "test");
+    }
+    trace::RecordAsync("ignored_async", "test", 1, trace::NowNs(), trace::NowNs());
+    check(trace::Stats().events == 0, "nothing recorded while off");
+    check(!trace::Enabled(), "off after stop");
+}
+
+void test_threads() {
+    trace::Start();
+    check(trace::Enabled(), "on after start");
+    auto worker = [](const char* name) {
+        trace::SetThreadName(name);
+        for (int i = 0; i < 100; ++i) {
+            trace::Span span("work", "test");
+        }
+    };
+    std::thread first(worker, "first");
+    std::thread second(worker, "second");
+    first.join();
+    second.join();
+    const int64_t start = trace::NowNs();
+    trace::RecordAsync("request", "test", 42, start, start + 5000);
+    trace::Stop();
+
+    const trace::TraceStats stats = trace::Stats();
+    check(stats.events == 201, "every span recorded");
+    check(stats.threads == 3, "one buffer per recording thread");
+    check(stats.dropped == 0, "nothing dropped");
+
+    const std::string json = export_trace();
+    check(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0, "trace object");
+    check(json.find("\"args\":{\"name\":\"first\"}") != std::string::npos
+              && json.find("\"args\":{\"name\":\"second\"}") != std::string::npos,
+          "thread names exported");
+    check(count(json, "\"ph\":\"M\"") == 3, "one metadata event per thread");
+    check(count(json, "\"name\":\"work\",\"cat\":\"test\",\"ph\":\"X\"") == 200, "spans exported");
+    check(count(json, "\"name\":\"request\",\"cat\":\"test\",\"ph\":\"b\"") == 1
+              && count(json, "\"name\":\"request\",\"cat\":\"test\",\"ph\":\"e\"") == 1
+              && count(json, "\"id\":\"0x2a\"}") == 2,
+          "async begin and end share an id");
+    check(json.size() > 4 && json.compare(json.size() - 4, 4, "\n]}\n") == 0, "trace closed");
+}
+
+void test_restart() {
+    trace::Start();
+    check(trace::Stats().events == 0, "start discards the last trace");
+    {
+        trace::Span span("after_restart", "test");
+    }
+    trace::Stop();
+    const std::string json = export_trace();
+    check(count(json, "\"ph\":\"X\"") == 1, "only the new trace exported");
+    check(json.find("\"name\":\"work\"") == std::string::npos, "old spans gone");
+}
+
+void test_overflow() {
+    trace::Start();
+    std::thread([] {
+        for (size_t i = 0; i < trace::kEventsPerThread + 10; ++i) {
+            trace::RecordSpan("tick", "test", 1, 2);
+        }
+    }).join();
+    trace::Stop();
+    const trace::TraceStats stats = trace::Stats();
+    check(stats.events == trace::kEventsPerThread, "buffer keeps its capacity");
+    check(stats.dropped == 10, "events past a full buffer counted as dropped");
+}
+
+} // namespace
+
+int main() {
+    test_disabled();
+    test_threads();
+    test_restart();
+    test_overflow();
+    return test_util::report("Trace");
+}
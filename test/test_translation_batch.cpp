@@ -0,0 +1,42 @@
+// Checks that texts joined into one translation request are split back in
+// order, and that a translation whose lines were merged or split is rejected
+// so the texts are resent one by one.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <translator/batch/translation_batch.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+void test_round_trip() {
+    const std::vector<std::string> texts = {"Good morning.", "  How are you?\n", "Line one\nline two"};
+    const std::string joined = translator::JoinBatch(texts);
+    check(joined == "Good morning.\nHow are you?\nLine one line two", "one trimmed text per line");
+
+    std::vector<std::string> parts;
+    check(translator::SplitBatch("早上好。\r\n你好吗？\n第一行 第二行\n", 3, parts), "translation split");
+    check(parts.size() == 3 && parts[0] == "早上好。" && parts[1] == "你好吗？" && parts[2] == "第一行 第二行",
+          "parts trimmed and in order");
+
+    check(translator::SplitBatch("single", 1, parts) && parts.size() == 1, "single text");
+}
+
+void test_mismatch() {
+    std::vector<std::string> parts;
+    check(!translator::SplitBatch("早上好。你好吗？", 2, parts), "merged lines rejected");
+    check(!translator::SplitBatch("早上好。\n你好\n吗？", 2, parts), "split line rejected");
+    check(!translator::SplitBatch("早上好。\n\n你好吗？", 2, parts), "blank line rejected");
+    check(!translator::SplitBatch("", 1, parts), "empty translation rejected");
+}
+
+} // namespace
+
+int main() {
+    test_round_trip();
+    test_mismatch();
+    return test_util::report("Translation batch");
+}
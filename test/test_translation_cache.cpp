@@ -0,0 +1,126 @@
+// Checks the translation cache: key normalization, the memory bound of the
+// LRU, and that the on-disk store survives a reopen, compacts when full and
+// ignores a torn record at its end.
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <translator/cache/translation_cache.h>
+#include "test_util.h"
+
+namespace {
+
+using test_util::check;
+
+std::string temp_path() {
+    return "/tmp/test_translation_cache_" + std::to_string(::getpid()) + ".bin";
+}
+
+void test_keys() {
+    using translator::TranslationCache;
+    check(TranslationCache::Normalize("  hello \t  world\n") == "hello world", "whitespace collapsed");
+    check(TranslationCache::Normalize("你好\xe3\x80\x80世界") == "你好 世界", "ideographic space collapsed");
+    check(TranslationCache::MakeKey("en", "zh", "Hi  there") == TranslationCache::MakeKey("EN", "ZH", "Hi there"),
+          "language case and spacing share a key");
+    check(TranslationCache::MakeKey("EN", "ZH", "Hi") != TranslationCache::MakeKey("EN", "JA", "Hi"),
+          "target language is part of the key");
+}
+
+void test_memory_bound() {
+    common::TranslationCacheConfig config;
+    config.max_memory_mb = 1;
+    translator::TranslationCache cache(config);
+
+    const std::string value(1000, 'x');
+    for (int i = 0; i < 2000; ++i) {
+        cache.store("key" + std::to_string(i), value);
+    }
+    translator::TranslationCacheStats stats = cache.stats();
+    check(stats.bytes <= (1u << 20), "memory stays within max_memory_mb");
+    check(stats.entries > 500 && stats.entries < 2000, "old entries evicted");
+
+    std::string out;
+    check(cache.lookup("key1999", out) && out == value, "newest entry kept");
+    check(!cache.lookup("key0", out), "oldest entry evicted");
+    stats = cache.stats();
+    check(stats.hits == 1 && stats.misses == 1, "hits and misses counted");
+}
+
+void test_persistence() {
+    const std::string path = temp_path();
+    std::remove(path.c_str());
+
+    common::TranslationCacheConfig config;
+    config.disk_path = path;
+    config.disk_max_mb = 1;
+    {
+        translator::TranslationCache cache(config);
+        cache.store(translator::TranslationCache::MakeKey("EN", "ZH", "good morning"), "早上好");
+        cache.store(translator::TranslationCache::MakeKey("EN", "ZH", "thanks"), "谢谢");
+        cache.store(translator::TranslationCache::MakeKey("EN", "ZH", "thanks"), "多谢");
+    }
+    {
+        translator::TranslationCache cache(config);
+        std::string out;
+        check(cache.lookup(translator::TranslationCache::MakeKey("en", "zh", "good  morning"), out) && out == "早上好",
+              "translation read back after reopen");
+        check(cache.lookup(translator::TranslationCache::MakeKey("EN", "ZH", "thanks"), out) && out == "多谢",
+              "newest record wins");
+        const translator::TranslationCacheStats stats = cache.stats();
+        check(stats.disk_hits == 2 && stats.disk_entries == 2, "served from disk");
+    }
+
+    // Simulate a crash after the header was updated but before the record
+    // reached the disk: garbage past the last record, counted as used
+    {
+        uint64_t used = 0;
+        {
+            translator::PersistentTranslationStore store(path, 1 << 20);
+            used = store.bytes_used();
+        }
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(used));
+        file.write("\x05\x00\x00\x00\x05\x00\x00\x00garbage!", 16);
+        const uint64_t torn_used = used + 16;
+        file.seekp(24);  // FileHeader::used
+        file.write(reinterpret_cast<const char*>(&torn_used), sizeof(torn_used));
+    }
+    {
+        translator::PersistentTranslationStore store(path, 1 << 20);
+        std::string out;
+        check(store.entries() == 2, "torn tail ignored");
+        store.put("new", "entry");
+        check(store.get("new", out) && out == "entry", "append after recovery");
+    }
+
+    // Filling the file compacts it and keeps the newest translations
+    {
+        translator::PersistentTranslationStore store(path, 1 << 20);
+        const std::string value(4000, 'y');
+        for (int i = 0; i < 1000; ++i) {
+            store.put("fill" + std::to_string(i), value);
+        }
+        std::string out;
+        check(store.bytes_used() <= (1u << 20), "store stays within its size");
+        check(store.get("fill999", out) && out == value, "newest record kept after compaction");
+        check(!store.get("fill0", out), "oldest record dropped by compaction");
+    }
+    {
+        translator::PersistentTranslationStore store(path, 1 << 20);
+        std::string out;
+        check(store.get("fill999", out), "compacted file reopens");
+    }
+    std::remove(path.c_str());
+}
+
+} // namespace
+
+int main() {
+    test_keys();
+    test_memory_bound();
+    test_persistence();
+    return test_util::report("Translation cache");
+}
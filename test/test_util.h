@@ -0,0 +1,29 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+// Shared by the unit tests: check() records a failure and carries on, so one
+// run reports every broken case; report() ends main() with the summary.
+namespace test_util {
+
+inline int g_failures = 0;
+
+inline void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL " << what << std::endl;
+        ++g_failures;
+    }
+}
+
+// Exit code for main(): 1 after any failed check
+inline int report(const std::string& suite) {
+    if (g_failures != 0) {
+        std::cerr << g_failures << " failures" << std::endl;
+        return 1;
+    }
+    std::cout << suite << " checks passed" << std::endl;
+    return 0;
+}
+
+} // namespace test_util